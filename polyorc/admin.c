@@ -0,0 +1,418 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "admin.h"
+#include "generator.h"
+#include "polyorcout.h"
+#include "polyorchistogram.h"
+#include "polyorcstats.h"
+#include "polyorcwire.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <ev.h>
+
+/* A connected client, commands are read a line at a time */
+typedef struct _admin_client {
+    int fd;
+    struct ev_io io;
+    char line[ADMIN_MAX_LINE];
+    size_t len;
+    int lost; /* A reply did not fit in the socket, the client is closed */
+    struct _admin_client *next;
+    struct _admin_server *server;
+} admin_client;
+
+struct _admin_server {
+    pthread_t pthread;
+    struct ev_loop *loop;
+    struct ev_io accept_io;
+    struct ev_async stop;
+    int fd;
+    const char *path; /* A unix socket to unlink, 0 for tcp */
+    admin_client *clients;
+    orcrate rate; /* Since the stats before */
+};
+
+/* The socket is non-blocking, a client that does not read its replies
+   fills it and is closed rather than stall the admin thread */
+static void send_reply(admin_client *client, const char *text, size_t len) {
+    if (0 != client->lost) {
+        return;
+    }
+    if ((ssize_t)len != send(client->fd, text, len, MSG_NOSIGNAL)) {
+        client->lost = 1;
+    }
+}
+
+static void reply(admin_client *client, const char *format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (0 < len) {
+        send_reply(client, buf, (size_t)len < sizeof(buf) ? (size_t)len :
+                   sizeof(buf) - 1);
+    }
+}
+
+static void reply_stats(admin_client *client) {
+    orcstatistics *sum = calloc(1, sizeof(orcstatistics));
+    if (0 == sum) {
+        reply(client, "ERR out of memory\n");
+        return;
+    }
+    generator_snapshot(sum);
+    orcrate_update(&(client->server->rate), sum);
+    const orchistogram *total = &(sum->latency[orcl_total]);
+    reply(client, "requests %llu\n", sum->hits);
+    reply(client, "requests_sec %.1f\n", client->server->rate.hits_sec);
+    reply(client, "bytes %llu\n", sum->total_bytes);
+    reply(client, "failed %llu\n", sum->failed);
+    reply(client, "missed %llu\n", sum->missed);
+    reply(client, "aborted %llu\n", sum->aborted);
+    reply(client, "connects %llu\n", sum->connects);
+    reply(client, "sessions %llu\n", sum->sessions);
+    reply(client, "mean_ms %.2f\n", orchist_mean(total) / 1000.0);
+    reply(client, "p50_ms %.2f\n", orchist_percentile(total, 50.0) / 1000.0);
+    reply(client, "p99_ms %.2f\n", orchist_percentile(total, 99.0) / 1000.0);
+    reply(client, "OK\n");
+    free(sum);
+}
+
+/* The statistics so far in the wire encoding, for a coordinator */
+static void reply_dump(admin_client *client) {
+    orcstatistics *sum = calloc(1, sizeof(orcstatistics));
+    size_t len = 0;
+    char *text = 0;
+    /* Read before the snapshot, finished statistics are final */
+    int finished = generator_finished();
+    if (0 != sum) {
+        generator_snapshot(sum);
+        text = orcwire_encode(sum, &len);
+        free(sum);
+    }
+    if (0 == text) {
+        reply(client, "ERR out of memory\n");
+        return;
+    }
+    reply(client, "state %s\n", (0 != finished) ? "finished" : "running");
+    send_reply(client, text, len);
+    reply(client, "OK\n");
+    free(text);
+}
+
+/* Run one command and answer OK or ERR */
+static void run_command(admin_client *client, char *line) {
+    char *value = strchr(line, ' ');
+    double number = 0;
+    if (0 != value) {
+        *value = '\0';
+        value++;
+        while (' ' == *value) {
+            value++;
+        }
+    }
+    orcout(orcm_verbose, "Admin: %s %s\n", line, (0 != value) ? value : "");
+
+    if (0 == strcmp("stats", line)) {
+        reply_stats(client);
+        return;
+    }
+    if (0 == strcmp("dump", line)) {
+        reply_dump(client);
+        return;
+    }
+    if (0 == strcmp("help", line)) {
+        reply(client, "rate RATE, events N, scale FACTOR, pause, resume,"
+              " urls FILE, stats, stop, shard K N, start EPOCH, dump,"
+              " bye\nOK\n");
+        return;
+    }
+    if (0 == strcmp("pause", line) || 0 == strcmp("resume", line)) {
+        if (0 == generator_pause('p' == line[0])) {
+            reply(client, "ERR a replay can not pause\n");
+            return;
+        }
+    } else if (0 == strcmp("stop", line)) {
+        generator_stop();
+    } else if (0 == strcmp("bye", line)) {
+        generator_bye();
+    } else if (0 == strcmp("shard", line)) {
+        int index;
+        int count;
+        if (0 == value || 2 != sscanf(value, "%d %d", &index, &count) ||
+            0 == generator_set_shard(index, count)) {
+            reply(client, "ERR shard needs K N with K < N and N urls\n");
+            return;
+        }
+    } else if (0 == strcmp("start", line)) {
+        if (0 == value || 1 != sscanf(value, "%lf", &number) ||
+            0 == generator_start_at(number)) {
+            reply(client, "ERR start needs an epoch and --hold\n");
+            return;
+        }
+    } else if (0 == strcmp("urls", line)) {
+        if (0 == value || 0 != access(value, R_OK)) {
+            reply(client, "ERR no readable url file\n");
+            return;
+        }
+        if (0 == generator_switch_urls(value)) {
+            reply(client, "ERR the urls can not be switched\n");
+            return;
+        }
+    } else if (0 == value || 1 != sscanf(value, "%lf", &number) ||
+               !(0 < number)) {
+        reply(client, "ERR unknown command or value, try help\n");
+        return;
+    } else if (0 == strcmp("rate", line)) {
+        if (0 == generator_set_rate(number)) {
+            reply(client, "ERR rate needs --rate without profile\n");
+            return;
+        }
+    } else if (0 == strcmp("events", line)) {
+        if (0 == generator_set_events((int)number)) {
+            reply(client, "ERR events needs a closed-loop without profile\n");
+            return;
+        }
+    } else if (0 == strcmp("scale", line)) {
+        if (0 == generator_scale(number)) {
+            reply(client, "ERR nothing to scale\n");
+            return;
+        }
+    } else {
+        reply(client, "ERR unknown command, try help\n");
+        return;
+    }
+    reply(client, "OK\n");
+}
+
+static void close_client(admin_client *client) {
+    admin_server *server = client->server;
+    admin_client **pos = &(server->clients);
+    while (*pos != client) {
+        pos = &((*pos)->next);
+    }
+    *pos = client->next;
+    ev_io_stop(server->loop, &(client->io));
+    close(client->fd);
+    free(client);
+}
+
+static void client_cb(struct ev_loop *loop, struct ev_io *io, int revents) {
+    admin_client *client = (admin_client *)io->data;
+    ssize_t got = recv(client->fd, client->line + client->len,
+                       sizeof(client->line) - 1 - client->len, 0);
+    if (0 >= got) {
+        if (0 > got && (EAGAIN == errno || EINTR == errno)) {
+            return;
+        }
+        close_client(client);
+        return;
+    }
+    client->len += got;
+    char *start = client->line;
+    char *nl;
+    while (0 == client->lost &&
+           0 != (nl = memchr(start, '\n', client->line + client->len - start))) {
+        *nl = '\0';
+        if (nl > start && '\r' == nl[-1]) {
+            nl[-1] = '\0';
+        }
+        if ('\0' != *start) {
+            run_command(client, start);
+        }
+        start = nl + 1;
+    }
+    if (0 != client->lost) {
+        close_client(client);
+        return;
+    }
+    client->len -= start - client->line;
+    memmove(client->line, start, client->len);
+    if (sizeof(client->line) - 1 == client->len) {
+        reply(client, "ERR line too long\n");
+        close_client(client);
+    }
+}
+
+static void accept_cb(struct ev_loop *loop, struct ev_io *io, int revents) {
+    admin_server *server = (admin_server *)io->data;
+    int fd = accept(server->fd, 0, 0);
+    if (-1 == fd) {
+        return;
+    }
+    admin_client *client = calloc(1, sizeof(admin_client));
+    if (0 == client) {
+        close(fd);
+        return;
+    }
+    /* Replies never wait for a client, see send_reply */
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    client->fd = fd;
+    client->server = server;
+    client->next = server->clients;
+    server->clients = client;
+    ev_io_init(&(client->io), client_cb, fd, EV_READ);
+    client->io.data = client;
+    ev_io_start(loop, &(client->io));
+}
+
+static void stop_cb(struct ev_loop *loop, struct ev_async *async,
+                    int revents) {
+    ev_break(loop, EVBREAK_ALL);
+}
+
+static void * admin_loop(void *data) {
+    admin_server *server = (admin_server *)data;
+    ev_loop(server->loop, 0);
+    return 0;
+}
+
+/* Listen on a port of localhost or on a unix socket if there is a / */
+static int listen_on(const char *address, admin_server *server) {
+    int fd;
+    if (0 != strchr(address, '/')) {
+        struct sockaddr_un un;
+        memset(&un, 0, sizeof(un));
+        if (sizeof(un.sun_path) <= strlen(address)) {
+            orcerror("Admin socket path %s is too long\n", address);
+            exit(EXIT_FAILURE);
+        }
+        un.sun_family = AF_UNIX;
+        strcpy(un.sun_path, address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(address);
+        if (-1 == fd || -1 == bind(fd, (struct sockaddr *)&un, sizeof(un))) {
+            orcerror("Admin socket %s\n", address);
+            orcerrno(errno);
+            exit(EXIT_FAILURE);
+        }
+        server->path = address;
+    } else {
+        struct sockaddr_in in;
+        char host[64] = "127.0.0.1";
+        const char *colon = strrchr(address, ':');
+        int port = 0;
+        int on = 1;
+        if (0 != colon) {
+            snprintf(host, sizeof(host), "%.*s", (int)(colon - address),
+                     address);
+            address = colon + 1;
+        }
+        if (1 != sscanf(address, "%d", &port) || 0 >= port || 65535 < port) {
+            orcerror("Admin port %s is not a port or a path\n", address);
+            exit(EXIT_FAILURE);
+        }
+        memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        /* There is no authentication, only local clients unless an address
+           is given */
+        if (1 != inet_pton(AF_INET, host, &(in.sin_addr))) {
+            orcerror("Admin address %s is not an ipv4 address\n", host);
+            exit(EXIT_FAILURE);
+        }
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (-1 != fd) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        }
+        if (-1 == fd || -1 == bind(fd, (struct sockaddr *)&in, sizeof(in))) {
+            orcerror("Admin port %d\n", port);
+            orcerrno(errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (-1 == listen(fd, 8)) {
+        orcerror("Admin listen\n");
+        orcerrno(errno);
+        exit(EXIT_FAILURE);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+/**
+ * Starts the admin channel in its own thread and event loop. Clients send
+ * one command per line and get OK or ERR back, failures to listen are
+ * fatal.
+ *
+ * @author Oscar Norlander
+ *
+ * @param address A port on localhost, or the path of a unix socket.
+ *
+ * @return admin_server * Stop it with admin_stop.
+ */
+admin_server * admin_start(const char *address) {
+    admin_server *server = calloc(1, sizeof(admin_server));
+    if (0 == server) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    server->fd = listen_on(address, server);
+    server->loop = ev_loop_new(0);
+    ev_io_init(&(server->accept_io), accept_cb, server->fd, EV_READ);
+    server->accept_io.data = server;
+    ev_io_start(server->loop, &(server->accept_io));
+    ev_async_init(&(server->stop), stop_cb);
+    ev_async_start(server->loop, &(server->stop));
+
+    int status = pthread_create(&(server->pthread), 0, admin_loop, server);
+    if (0 != status) {
+        orcerror("Admin thread %s (%d)\n", strerror(status), status);
+        exit(EXIT_FAILURE);
+    }
+    orcstatus(orcm_normal, orc_green, "ADMIN", "Listening on %s\n", address);
+    return server;
+}
+
+/**
+ * Stops the admin channel and closes its clients.
+ *
+ * @author Oscar Norlander
+ *
+ * @param server The channel, may be 0.
+ */
+void admin_stop(admin_server *server) {
+    if (0 == server) {
+        return;
+    }
+    ev_async_send(server->loop, &(server->stop));
+    pthread_join(server->pthread, 0);
+    while (0 != server->clients) {
+        close_client(server->clients);
+    }
+    ev_io_stop(server->loop, &(server->accept_io));
+    ev_loop_destroy(server->loop);
+    close(server->fd);
+    if (0 != server->path) {
+        unlink(server->path);
+    }
+    free(server);
+}
@@ -0,0 +1,30 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef ADMIN_H
+#define ADMIN_H
+
+/* The longest command line a client can send */
+#define ADMIN_MAX_LINE 4096
+
+typedef struct _admin_server admin_server;
+
+admin_server * admin_start(const char *address);
+
+void admin_stop(admin_server *server);
+
+#endif
@@ -20,6 +20,31 @@
 
 #include "config.h"
 #include "polyorcout.h"
+#include "polyorcaccesslog.h"
+
+/* How requests are started in open-loop (--rate) mode */
+enum polyorc_arrival {
+    orca_constant = 0,
+    orca_poisson
+};
+
+/* What the generator does with response bodies */
+enum polyorc_sink {
+    orcs_count = 0, /* Only count the bytes */
+    orcs_checksum, /* Count and keep a running checksum */
+    orcs_buffer /* Keep the whole body in memory */
+};
+
+/* The http version the generator asks for */
+enum polyorc_http {
+    orch_default = 0, /* Whatever libcurl defaults to */
+    orch_2tls, /* HTTP/2 over TLS (ALPN), HTTP/1.1 for plain http */
+    orch_2c /* HTTP/2 with prior knowledge, also over plain http */
+};
+
+/* What the threads share through one CURLSH, see --share */
+#define ORC_SHARE_DNS 1
+#define ORC_SHARE_SSL 2
 
 /* Used by main to communicate with parse_opt. */
 typedef struct _polyarguments {
@@ -27,6 +52,38 @@ typedef struct _polyarguments {
     enum polyorc_color color;
     int max_events;
     int max_threads;
+    double rate;
+    enum polyorc_arrival arrival;
+    enum polyorc_sink sink;
+    int index_cache;
+    double zipf;
+    unsigned long long seed;
+    enum polyorc_http http;
+    int max_streams;
+    int max_host_conns;
+    int max_conns;
+    int share; /* ORC_SHARE_* bits */
+    const char **resolve; /* HOST:PORT:ADDR entries */
+    int resolve_len;
+    int pre_resolve;
+    int pin;
+    int *cpus; /* Thread i runs on cpus[i % cpus_len] when pinned */
+    int cpus_len;
+    const struct _load_profile *profile; /* 0 without --profile */
+    double duration; /* Seconds after the warm-up, 0 to run until stopped */
+    unsigned long long requests; /* Requests after the warm-up, 0 for any */
+    double warmup;
+    double drain_timeout;
+    const char *replay; /* An access log to replay instead of in_file */
+    double replay_speed;
+    enum orc_logformat replay_format;
+    const char *replay_base;
+    const char *template_file; /* A request template, 0 for plain GETs */
+    const char *csv_file; /* Rows for the {{csv:N}} placeholders */
+    const char *scenario_file; /* Virtual users instead of single requests */
+    const char *admin; /* Port or unix socket of the admin channel */
+    int hold; /* Wait for a coordinator to start the run */
+    unsigned int url_stats; /* Urls with statistics of their own, 0 for none */
     const char *url;
     const char *out_file;
     const char *in_file;
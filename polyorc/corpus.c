@@ -0,0 +1,479 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "corpus.h"
+#include "polyorcout.h"
+#include "polyorcdefs.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
+
+/* Files smaller than this are indexed by one thread */
+#define CORPUS_PARALLEL_MIN (16 * 1024 * 1024)
+
+#define CORPUS_INDEX_SUFFIX ".idx"
+#define CORPUS_INDEX_MAGIC "ORCIDX2"
+
+/* Header of the sidecar index, followed by count packed spans */
+typedef struct _corpus_index_header {
+    char magic[8];
+    unsigned long long file_size;
+    long long file_mtime;
+    unsigned long long count;
+} corpus_index_header;
+
+/* A part of the file indexed by one thread */
+typedef struct _index_chunk {
+    const char *data;
+    size_t start; /* First byte of the first line in the chunk */
+    size_t end; /* First byte after the chunk */
+    unsigned long long *out; /* Where to write the spans, 0 to only count */
+    unsigned int count;
+    unsigned int skipped;
+    pthread_t pthread;
+} index_chunk;
+
+/* Walk the lines of a chunk. Empty lines are ignored, a trailing \r is
+   stripped and lines longer than MAX_URL_LEN are skipped. The url ends
+   at the first blank, what follows is the optional weight column. */
+static void * index_chunk_run(void *ptr) {
+    index_chunk *chunk = (index_chunk *)ptr;
+    const char *data = chunk->data;
+    size_t pos = chunk->start;
+
+    chunk->count = 0;
+    chunk->skipped = 0;
+    while (pos < chunk->end) {
+        const char *nl = memchr(data + pos, '\n', chunk->end - pos);
+        size_t line_end = (0 != nl) ? (size_t)(nl - data) : chunk->end;
+        size_t len = line_end - pos;
+        if (0 < len && '\r' == data[pos + len - 1]) {
+            len--;
+        }
+        const char *blank = memchr(data + pos, ' ', len);
+        const char *tab = memchr(data + pos, '\t', len);
+        if (0 != tab && (0 == blank || tab < blank)) {
+            blank = tab;
+        }
+        if (0 != blank) {
+            len = (size_t)(blank - (data + pos));
+        }
+        if (0 == len) {
+            /* Nothing */
+        } else if (MAX_URL_LEN < len) {
+            chunk->skipped++;
+        } else {
+            if (0 != chunk->out) {
+                chunk->out[chunk->count] = CORPUS_PACK(pos, len);
+            }
+            chunk->count++;
+        }
+        pos = line_end + 1;
+    }
+    return 0;
+}
+
+/* Run one pass over all chunks, in parallel if there are more than one */
+static void index_pass(index_chunk *chunks, int n) {
+    int i;
+    if (1 == n) {
+        index_chunk_run(&(chunks[0]));
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        int status = pthread_create(&(chunks[i].pthread), 0, index_chunk_run,
+                                    &(chunks[i]));
+        if (0 != status) {
+            orcerror("Index thread %s (%d)\n", strerror(status), status);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < n; i++) {
+        pthread_join(chunks[i].pthread, 0);
+    }
+}
+
+/* Build the span array. Large files are split at line boundaries and
+   indexed by several threads, first counting and then filling. */
+static void build_index(url_corpus *corpus, int threads) {
+    int n = 1;
+    int i;
+    if (CORPUS_PARALLEL_MIN <= corpus->data_len && 1 < threads) {
+        n = threads;
+    }
+
+    index_chunk chunks[n];
+    memset(chunks, 0, sizeof(chunks));
+    for (i = 0; i < n; i++) {
+        size_t split = (corpus->data_len / n) * i;
+        chunks[i].data = corpus->data;
+        if (0 == split) {
+            chunks[i].start = 0;
+        } else {
+            /* Move the split to the start of the next line */
+            const char *nl = memchr(corpus->data + split - 1, '\n',
+                                    corpus->data_len - split + 1);
+            chunks[i].start = (0 != nl) ?
+                (size_t)(nl - corpus->data) + 1 : corpus->data_len;
+        }
+        if (0 < i) {
+            chunks[i - 1].end = chunks[i].start;
+        }
+    }
+    chunks[n - 1].end = corpus->data_len;
+
+    index_pass(chunks, n);
+
+    unsigned long long total = 0;
+    unsigned int skipped = 0;
+    for (i = 0; i < n; i++) {
+        total += chunks[i].count;
+        skipped += chunks[i].skipped;
+    }
+    if (0xffffffffULL < total) {
+        orcerror("Too many urls (%llu)\n", total);
+        exit(EXIT_FAILURE);
+    }
+    if (0 < skipped) {
+        orcerror("Skipped %u urls longer than %d characters\n", skipped,
+                 MAX_URL_LEN);
+    }
+    corpus->count = (unsigned int)total;
+    if (0 == total) {
+        return;
+    }
+
+    unsigned long long *spans = calloc(total, sizeof(unsigned long long));
+    if (0 == spans) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    unsigned long long *out = spans;
+    for (i = 0; i < n; i++) {
+        chunks[i].out = out;
+        out += chunks[i].count;
+    }
+    index_pass(chunks, n);
+    corpus->spans = spans;
+}
+
+/* Map a sidecar index if it belongs to the url file as it is now. Size
+   and mtime can match a file that was changed within the same second, so
+   every span must also lie within the file. */
+static int load_index(url_corpus *corpus, const char *index_name,
+                      const struct stat *st) {
+    unsigned long long i;
+    int fd = open(index_name, O_RDONLY);
+    if (-1 == fd) {
+        return 0;
+    }
+    struct stat ist;
+    if (-1 == fstat(fd, &ist) || sizeof(corpus_index_header) > ist.st_size) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, ist.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        return 0;
+    }
+    const corpus_index_header *header = map;
+    if (0 != memcmp(header->magic, CORPUS_INDEX_MAGIC,
+                    sizeof(CORPUS_INDEX_MAGIC)) ||
+        header->file_size != (unsigned long long)st->st_size ||
+        header->file_mtime != (long long)st->st_mtime ||
+        0xffffffffULL < header->count ||
+        ist.st_size != (off_t)(sizeof(corpus_index_header) +
+                               header->count * sizeof(unsigned long long)))
+    {
+        munmap(map, ist.st_size);
+        return 0;
+    }
+    const unsigned long long *spans = (const unsigned long long *)(header + 1);
+    for (i = 0; i < header->count; i++) {
+        unsigned long long len = CORPUS_LEN(spans[i]);
+        if (0 == len || MAX_URL_LEN < len ||
+            corpus->data_len < CORPUS_OFFSET(spans[i]) + len) {
+            munmap(map, ist.st_size);
+            return 0;
+        }
+    }
+    corpus->index_map = map;
+    corpus->index_map_len = ist.st_size;
+    corpus->spans = spans;
+    corpus->count = (unsigned int)header->count;
+    return 1;
+}
+
+/* Write the sidecar index, failing is not fatal */
+static void save_index(const url_corpus *corpus, const char *index_name,
+                       const struct stat *st) {
+    corpus_index_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_INDEX_MAGIC, sizeof(CORPUS_INDEX_MAGIC));
+    header.file_size = st->st_size;
+    header.file_mtime = st->st_mtime;
+    header.count = corpus->count;
+
+    FILE *out = fopen(index_name, "w");
+    if (0 == out) {
+        orcerror("Could not write index %s\n", index_name);
+        orcerrno(errno);
+        return;
+    }
+    if (1 != fwrite(&header, sizeof(header), 1, out) ||
+        corpus->count != fwrite(corpus->spans, sizeof(unsigned long long),
+                                corpus->count, out))
+    {
+        orcerror("Could not write index %s\n", index_name);
+        orcerrno(errno);
+        fclose(out);
+        unlink(index_name);
+        return;
+    }
+    fclose(out);
+    orcstatus(orcm_verbose, orc_green, "CREATED", "Index %s\n", index_name);
+}
+
+/**
+ * Maps a file with one url per line and indexes it. The file is never
+ * copied, urls are read from the mapping through the span array.
+ *
+ * @author Oscar Norlander
+ *
+ * @param file_name The url file.
+ * @param threads The number of threads to index large files with.
+ * @param use_cache If set, a sidecar index (file_name.idx) is used when
+ *                  it is up to date and written otherwise.
+ *
+ * @return url_corpus * 0 if the file can not be used, the error is
+ *                      printed.
+ */
+url_corpus * corpus_try_open(const char *file_name, int threads,
+                             int use_cache) {
+    url_corpus *corpus = calloc(1, sizeof(url_corpus));
+    if (0 == corpus) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+
+    int fd = open(file_name, O_RDONLY);
+    if (-1 == fd) {
+        orcerror("File %s\n", file_name);
+        orcerrno(errno);
+        free(corpus);
+        return 0;
+    }
+    struct stat st;
+    if (-1 == fstat(fd, &st)) {
+        orcerror("File %s\n", file_name);
+        orcerrno(errno);
+        close(fd);
+        free(corpus);
+        return 0;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        orcerror("%s is not a file\n", file_name);
+        close(fd);
+        free(corpus);
+        return 0;
+    }
+    corpus->data_len = st.st_size;
+    if (0 < corpus->data_len) {
+        void *map = mmap(NULL, corpus->data_len, PROT_READ, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == map) {
+            orcerror("Maping %s failed\n", file_name);
+            orcerrno(errno);
+            close(fd);
+            free(corpus);
+            return 0;
+        }
+        corpus->data = map;
+    }
+    close(fd);
+
+    char index_name[PATH_MAX];
+    int loaded = 0;
+    if (0 != use_cache) {
+        int len = snprintf(index_name, sizeof(index_name), "%s%s", file_name,
+                           CORPUS_INDEX_SUFFIX);
+        if (0 > len || sizeof(index_name) <= (size_t)len) {
+            orcerror("Name error for path %s\n", file_name);
+            corpus_close(corpus);
+            return 0;
+        }
+        loaded = load_index(corpus, index_name, &st);
+    }
+    if (0 == loaded && 0 < corpus->data_len) {
+        build_index(corpus, threads);
+        if (0 != use_cache && 0 < corpus->count) {
+            save_index(corpus, index_name, &st);
+        }
+    }
+    return corpus;
+}
+
+/**
+ * Like corpus_try_open, for when the url file is needed to run at all.
+ *
+ * @author Oscar Norlander
+ *
+ * @param file_name The url file.
+ * @param threads The number of threads to index large files with.
+ * @param use_cache If set, the sidecar index is used, see corpus_try_open.
+ *
+ * @return url_corpus * Never 0, failures are fatal.
+ */
+url_corpus * corpus_open(const char *file_name, int threads, int use_cache) {
+    url_corpus *corpus = corpus_try_open(file_name, threads, use_cache);
+    if (0 == corpus) {
+        exit(EXIT_FAILURE);
+    }
+    return corpus;
+}
+
+/* Parse the weight column after a url. Returns 0 if there is none, 1 if
+   it was parsed and -1 if it is not a valid weight. */
+static int parse_weight(const url_corpus *corpus, unsigned long long span,
+                        double *weight) {
+    size_t pos = CORPUS_OFFSET(span) + CORPUS_LEN(span);
+    const char *data = corpus->data;
+    while (pos < corpus->data_len && (' ' == data[pos] || '\t' == data[pos])) {
+        pos++;
+    }
+    char buf[64];
+    size_t len = 0;
+    while (pos + len < corpus->data_len && '\n' != data[pos + len] &&
+           '\r' != data[pos + len] && ' ' != data[pos + len] &&
+           '\t' != data[pos + len]) {
+        if (sizeof(buf) - 1 <= len) {
+            return -1;
+        }
+        buf[len] = data[pos + len];
+        len++;
+    }
+    if (0 == len) {
+        return 0;
+    }
+    buf[len] = '\0';
+    char *end;
+    errno = 0;
+    *weight = strtod(buf, &end);
+    if (0 != errno || '\0' != *end || !(0 <= *weight)) {
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Reads the weight column of the url file. Urls without a weight get
+ * weight 1 and so do invalid weights, with a warning.
+ *
+ * @author Oscar Norlander
+ *
+ * @param corpus The corpus.
+ * @param weights Set to count weights, free it when done. Set to 0 if no
+ *                url has a weight.
+ *
+ * @return unsigned int The number of urls with a weight.
+ */
+unsigned int corpus_weights(const url_corpus *corpus, double **weights) {
+    unsigned int i;
+    unsigned int weighted = 0;
+    unsigned int invalid = 0;
+    double *out = 0;
+
+    *weights = 0;
+    for (i = 0; i < corpus->count; i++) {
+        double weight = 1.0;
+        int status = parse_weight(corpus, corpus->spans[i], &weight);
+        if (0 == status) {
+            continue;
+        }
+        if (0 == out) {
+            out = malloc(corpus->count * sizeof(double));
+            if (0 == out) {
+                orcerror("%s (%d)\n", strerror(errno), errno);
+                exit(EXIT_FAILURE);
+            }
+            unsigned int j;
+            for (j = 0; j < corpus->count; j++) {
+                out[j] = 1.0;
+            }
+        }
+        if (0 > status) {
+            invalid++;
+            continue;
+        }
+        out[i] = weight;
+        weighted++;
+    }
+    if (0 < invalid) {
+        orcerror("%u urls have an invalid weight, using 1\n", invalid);
+    }
+    *weights = out;
+    return weighted;
+}
+
+/**
+ * Unmaps and frees a corpus.
+ *
+ * @author Oscar Norlander
+ *
+ * @param corpus The corpus.
+ */
+void corpus_close(url_corpus *corpus) {
+    if (0 == corpus) {
+        return;
+    }
+    if (0 != corpus->index_map) {
+        munmap(corpus->index_map, corpus->index_map_len);
+    } else {
+        free((void *)corpus->spans);
+    }
+    if (0 != corpus->data) {
+        munmap((void *)corpus->data, corpus->data_len);
+    }
+    free(corpus);
+}
+
+/**
+ * Copies url number i to out and terminates it.
+ *
+ * @author Oscar Norlander
+ *
+ * @param corpus The corpus.
+ * @param i The url index, less than count.
+ * @param out A buffer of at least MAX_URL_LEN + 1 characters.
+ *
+ * @return size_t The length of the url.
+ */
+size_t corpus_copy_url(const url_corpus *corpus, unsigned int i, char *out) {
+    unsigned long long span = corpus->spans[i];
+    size_t len = CORPUS_LEN(span);
+    memcpy(out, corpus->data + CORPUS_OFFSET(span), len);
+    out[len] = '\0';
+    return len;
+}
@@ -0,0 +1,54 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+
+/* A url is stored as its offset in the file and its length packed in one
+   64 bit value. MAX_URL_LEN fits in the low 16 bits. */
+#define CORPUS_LEN_BITS 16
+#define CORPUS_PACK(offset, len) \
+    (((unsigned long long)(offset) << CORPUS_LEN_BITS) | (len))
+#define CORPUS_OFFSET(span) ((span) >> CORPUS_LEN_BITS)
+#define CORPUS_LEN(span) \
+    ((unsigned int)((span) & ((1ULL << CORPUS_LEN_BITS) - 1)))
+
+/* A url file mapped read-only and indexed once. All threads share it.
+   A line is a url, optionally followed by blanks and a weight. */
+typedef struct _url_corpus {
+    const char *data; /* The mapped file */
+    size_t data_len;
+    const unsigned long long *spans; /* One packed span per url */
+    unsigned int count;
+    void *index_map; /* Set if spans are mapped from the sidecar index */
+    size_t index_map_len;
+} url_corpus;
+
+url_corpus * corpus_open(const char *file_name, int threads, int use_cache);
+
+url_corpus * corpus_try_open(const char *file_name, int threads,
+                             int use_cache);
+
+void corpus_close(url_corpus *corpus);
+
+size_t corpus_copy_url(const url_corpus *corpus, unsigned int i, char *out);
+
+unsigned int corpus_weights(const url_corpus *corpus, double **weights);
+
+#endif
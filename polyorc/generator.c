@@ -16,28 +16,123 @@
 */
 
 #include "generator.h"
+#include "corpus.h"
+#include "share.h"
+#include "topology.h"
+#include "profile.h"
+#include "replay.h"
+#include "request.h"
+#include "scenario.h"
+#include "admin.h"
 #include "polyorcout.h"
 #include "polyorcdefs.h"
 #include "polyorctypes.h"
+#include "polyorcrand.h"
+#include "polyorcutils.h"
+#include "polyorcstats.h"
+#include "polyorcsegment.h"
+#include "polyorcurlstat.h"
+#include "polyorcalias.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
 #include <pthread.h>
 #include <ev.h>
 #include <curl/curl.h>
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <unistd.h>
+#include <time.h>
+#include <math.h>
 
-// No lock needed. We only read this.
-static unsigned int ring_size;
-static char **ring;
+/* A url file and how its urls are picked. A set is never changed once
+   threads can see it, switching urls loads a new one. */
+typedef struct _url_set {
+    url_corpus *ring;
+    orcalias *picker; /* Set if urls are picked by weight */
+    double *weights; /* Of the picker, for the pickers of shards */
+    struct _url_set *older; /* Sets used before, freed at exit */
+} url_set;
 
-// No lock needed. We only indicate if run or not.
+/* Picks by weight among the urls of one shard only. Draw j is url
+   shard_index + j * shard_count. Never changed once threads can see it. */
+typedef struct _shard_picker {
+    orcalias alias;
+    struct _shard_picker *older; /* Pickers used before, freed at exit */
+} shard_picker;
+
+// Every shard picker made, the newest first
+static shard_picker *shard_pickers;
+
+// No lock needed. We only read this. The newest url set.
+static url_set *urls;
+
+// The url set of --url-stats, urls of later sets are not tracked
+static url_set *tracked;
+
+/* Changed by the admin channel. Threads compare the generation on every
+   tick and read the rest when it has moved, no lock is taken. */
+typedef struct _live_control {
+    unsigned int generation;
+    double rate; /* Total rate of an open-loop */
+    int events; /* Transfers per thread of a closed-loop */
+    int paused;
+    url_set *urls;
+    int shard_index; /* Use the urls where index % shard_count is this */
+    int shard_count;
+    shard_picker *picker; /* Of the shard in urls, 0 without weights */
+    double start_at; /* Epoch seconds a held run starts */
+} live_control;
+
+static live_control control;
+
+// With --hold, set by the admin channel when the coordinator has the last
+// statistics
+static pthread_mutex_t bye_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bye_cond = PTHREAD_COND_INITIALIZER;
+static int bye;
+
+// Set when all threads have halted
+static int finished;
+
+// No lock needed. We only read this. Set by generator_init.
+static const polyarguments *options;
+
+// No lock needed. We only read this. Set with --template.
+static request_template *request;
+
+// No lock needed. We only read this. Set with --scenario.
+static scenario *flow;
+
+// Set with --share, the handle locks itself.
+static CURLSH *share;
+
+// No lock needed. We only read this. Set with --resolve or --pre-resolve.
+static struct curl_slist *resolve;
+
+// No lock needed. We only indicate if run or not. When set no new
+// requests start and the threads drain.
 static int done;
 
+// No lock needed. Set by a second Ctrl+c, abort what is in flight.
+static int abort_all;
+
+// Requests started after the warm-up, only changed with atomics.
+static unsigned long long started;
+
+// No lock needed. Set before the threads start, profiles count from here.
+static ev_tstamp start_time;
+
+/* How often every loop runs its housekeeping */
+#define TICK_INTERVAL 0.1
+
+/* Seconds a held run waits for the coordinator to say bye */
+#define HOLD_LINGER 10
+
+/* Urls in each table of the url report */
+#define URL_REPORT_TOP 10
+
 /* Global information, common to all connections */
 typedef struct _global_info {
     int id;
@@ -46,23 +141,75 @@ typedef struct _global_info {
     int still_running;
     CURLM *multi;
     int job_max;
+    int job_target; /* Closed-loop transfers to keep in flight, <= job_max */
     int job_count;
-    int stat_need_sync;
-    struct timeval read_time;
-    int read_byte_memory;
-    int hits_sec;
-    orcstatistics *stat;
-    int current;
+    orcstatistics *stat; /* Private, published to slot every tick */
+    orcslot *slot;
+    orcurlstat *url_stats; /* In the segment, 0 without --url-stats */
+    unsigned int url_stat_count;
+    unsigned int current;
+    orcrand rand;
+    struct ev_timer rate_timer;
+    enum polyorc_arrival arrival;
+    int open_loop;
+    double rate_gap; /* Mean seconds between arrivals, 0 when paused */
+    ev_tstamp next_arrival;
+    struct ev_timer tick_timer;
+    const load_profile *profile;
+    int threads;
+    ev_tstamp warmup_end; /* Nothing started before this is counted */
+    ev_tstamp stop_at; /* 0 without --duration */
+    unsigned long long max_requests; /* 0 without --requests */
+    double drain_timeout;
+    ev_tstamp drain_deadline; /* Set when the thread starts to drain */
+    int aborting;
+    replay_reader *replay; /* 0 unless replaying an access log */
+    replay_request replay_next; /* The next request to start */
+    double replay_speed;
+    struct ev_timer replay_timer;
+    int replay_done; /* The share of this thread is replayed */
+    unsigned long long counter; /* Requests started, for templates */
+    url_set *urls; /* 0 if every url comes from a template */
+    unsigned int generation; /* Of the admin control last applied */
+    double rate; /* Open-loop rate of this thread when not paused */
+    int events; /* Closed-loop transfers when not paused */
+    int paused;
+    int shard_index;
+    int shard_count;
+    shard_picker *shard_picker; /* 0 to pick from all urls by weight */
+    int held; /* Waiting for the start of a coordinator */
+    struct ev_timer start_timer;
+    double warmup;
+    double duration;
+    unsigned int csv_row; /* Next csv row of a template */
+    struct _conn_info *pool; /* job_max preconfigured easy handles */
+    struct _conn_info *free_conns; /* Pooled handles not in the multi */
+    enum polyorc_sink sink;
 } global_info;
 
 /* Information associated with a specific easy handle */
 typedef struct _conn_info {
     CURL *easy;
-    char *url;
+    char url[MAX_URL_LEN + 1];
     global_info *global;
     char *memory;
     size_t memory_size;
+    size_t memory_cap;
+    size_t body_size;
+    unsigned int checksum;
     char error[CURL_ERROR_SIZE];
+    struct _conn_info *next_free;
+    int busy; /* In the multi */
+    int warmup; /* Started in the warm-up, not counted */
+    unsigned int url_index; /* In url_stats, UINT_MAX when not tracked */
+    char method[ORC_LOG_METHOD_LEN]; /* Only used in replay */
+    request_scratch scratch; /* Only used with a template */
+    /* Only used in a scenario, where every handle is a virtual user with
+       its own cookies */
+    request_scratch *flow_scratch; /* One per step */
+    int flow_step; /* Step of the next request */
+    int flow_repeat; /* Requests of the step left */
+    struct ev_timer think;
 } conn_info;
 
 /* Information associated with a specific socket */
@@ -81,18 +228,22 @@ typedef struct _thread_context {
     int id;
     pthread_t pthread;
     polyarguments *arg;
+    orcstatistics *stat; /* Kept after the thread ends for the report */
+    orcslot *slot; /* Where the thread publishes stat */
+    int cpu; /* -1 if not pinned */
 } thread_context;
 
-/* If we use mmaped memory, sync it */
-void sync_mmap_ifused(global_info *global) {
-    if (1 == global->stat_need_sync) {
-        int res = msync(global->stat, sizeof(orcstatistics), MS_ASYNC);
-        if (-1 == res) {
-            orcerror("Sync of maped memory failed\n");
-            orcerrno(errno);
-            exit(EXIT_FAILURE);
-        }
-    }
+// The threads of generator_loop, read by the admin channel for snapshots
+static thread_context *contexts;
+static int context_count;
+
+// The slots of the threads, a file in --stat-dir or anonymous memory
+static orcsegment segment;
+
+/* Copy the statistics of a thread to its slot, stamped with the time */
+static void publish(global_info *global) {
+    global->stat->published = (unsigned long long)(ev_time() * 1000000.0);
+    orcseg_publish(global->slot, global->stat);
 }
 
 /* Die if we get a bad CURLMcode somewhere */
@@ -120,6 +271,132 @@ static void mcode_or_die(const char *where, CURLMcode code) {
 }
 
 static void new_conn(global_info *global);
+static void fill_conns(global_info *global);
+
+/* Record the timing breakdown of a finished transfer */
+static void record_timings(global_info *global, CURL *easy) {
+    orchistogram *latency = global->stat->latency;
+    curl_off_t namelookup = 0;
+    curl_off_t connect = 0;
+    curl_off_t appconnect = 0;
+    curl_off_t starttransfer = 0;
+    curl_off_t total = 0;
+    long connects = 0;
+
+    curl_easy_getinfo(easy, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(easy, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+
+    orchist_record(&(latency[orcl_total]), total);
+    /* A reused connection has no dns, connect or tls time */
+    if (0 < connects) {
+        orchist_record(&(latency[orcl_dns]), namelookup);
+        orchist_record(&(latency[orcl_connect]), connect - namelookup);
+        if (0 < appconnect) {
+            orchist_record(&(latency[orcl_tls]), appconnect - connect);
+        }
+    }
+    if (0 < starttransfer) {
+        orchist_record(&(latency[orcl_ttfb]), starttransfer);
+        orchist_record(&(latency[orcl_transfer]), total - starttransfer);
+    }
+}
+
+/* Count new connections and transfers that ran as streams on a
+   multiplexed connection */
+static void record_connection(global_info *global, CURL *easy) {
+    long connects = 0;
+    long version = 0;
+
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &version);
+    global->stat->connects += connects;
+    if (CURL_HTTP_VERSION_2_0 == version || CURL_HTTP_VERSION_3 == version) {
+        global->stat->multiplexed++;
+    }
+}
+
+/* Count a finished transfer in the active profile step */
+static void record_step(global_info *global, conn_info *conn, CURL *easy) {
+    curl_off_t total = 0;
+    if (0 == global->stat->step) {
+        return;
+    }
+    orcstep *step = &(global->stat->steps[global->stat->step - 1]);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total);
+    step->hits++;
+    step->total_bytes += conn->body_size;
+    orchist_record(&(step->latency), total);
+}
+
+/* Count a finished transfer in the scenario step it belongs to */
+static void record_flow(global_info *global, conn_info *conn, CURL *easy) {
+    curl_off_t total = 0;
+    orcflowstep *step = &(global->stat->flow[conn->flow_step]);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total);
+    step->hits++;
+    step->total_bytes += conn->body_size;
+    orchist_record(&(step->latency), total);
+}
+
+/* The reason a transfer failed in curl */
+static enum orc_failure failure_of(CURLcode result) {
+    switch (result) {
+    case CURLE_COULDNT_CONNECT:
+        return orcf_connect;
+    case CURLE_OPERATION_TIMEDOUT:
+        return orcf_timeout;
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_RESOLVE_PROXY:
+        return orcf_dns;
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_PEER_FAILED_VERIFICATION:
+    case CURLE_SSL_CERTPROBLEM:
+    case CURLE_SSL_CIPHER:
+    case CURLE_SSL_CACERT_BADFILE:
+    case CURLE_SSL_ISSUER_ERROR:
+    case CURLE_SSL_PINNEDPUBKEYNOTMATCH:
+    case CURLE_SSL_INVALIDCERTSTATUS:
+        return orcf_tls;
+    default:
+        return orcf_other;
+    }
+}
+
+/* Count the status of a finished transfer and whether it failed, a curl
+   error or a 4xx or 5xx response is a failure */
+static void record_outcome(global_info *global, conn_info *conn, CURL *easy,
+                           CURLcode result, long response_code) {
+    curl_off_t total = 0;
+    orcstatistics *stat = global->stat;
+    int failed = (CURLE_OK != result || 400 <= response_code);
+
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total);
+    if (100 <= response_code && 600 > response_code) {
+        stat->status[orcc_1xx + response_code / 100 - 1]++;
+        orcstat_count_code(stat, (int)response_code, 1);
+    } else {
+        stat->status[orcc_none]++;
+    }
+    if (CURLE_OK != result) {
+        stat->failures[failure_of(result)]++;
+    }
+    if (0 != failed) {
+        stat->failed++;
+        orchist_record(&(stat->failed_latency), total);
+    } else {
+        orchist_record(&(stat->ok_latency), total);
+    }
+    if (UINT_MAX != conn->url_index) {
+        orcurl_record(&(global->url_stats[conn->url_index]), total,
+                      conn->body_size, failed);
+    }
+}
+
+static void user_done(global_info *global, conn_info *conn);
 
 /* Check for completed transfers, and remove their easy handles */
 static void check_multi_info(global_info *global) {
@@ -142,30 +419,45 @@ static void check_multi_info(global_info *global) {
             curl_easy_getinfo(easy, CURLINFO_EFFECTIVE_URL, &effective_url);
             curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response_code);
             curl_easy_getinfo(easy, CURLINFO_HTTP_CONNECTCODE, &connect_code);
-            orcout(orcm_debug, "response code:%ld connect_code:%ld\n", response_code, connect_code);
+            orcout(orcm_debug, "response code:%ld connect_code:%ld\n",
+                   response_code, connect_code);
             orcout(orcm_debug, "DONE: %s => (%d) %s\n", effective_url,
                    result, conn->error);
-            orcout(orcm_debug, "%s", conn->memory);
-            /* Cleanup the finished easy handle */
+            if (orcs_checksum == global->sink) {
+                orcout(orcm_debug, "body %zu bytes fnv1a %08x\n",
+                       conn->body_size, conn->checksum);
+            } else if (0 != conn->memory_size) {
+                orcout(orcm_debug, "%s", conn->memory);
+            }
+            /* Give the finished easy handle back to the pool, it keeps its
+               options and connection state for the next request */
             curl_multi_remove_handle(global->multi, easy);
-            curl_easy_cleanup(easy);
             /* Write visited url to file */
             global->job_count--;
-            /*if (200 == response_code || 200 == connect_code) {
-                //remove this block?
-            }*/
-            /* Create new readers here */
-            if (0 == done) {
-                orcout(orcm_debug, "T%d --> %s\n", global->id, conn->url);
-                new_conn(global);
+            if (0 == conn->warmup) {
+                global->stat->hits++;
+                record_outcome(global, conn, easy, result, response_code);
+                record_timings(global, easy);
+                record_step(global, conn, easy);
+                record_connection(global, easy);
+                if (0 != flow) {
+                    record_flow(global, conn, easy);
+                }
+            }
+            conn->busy = 0;
+            if (0 != flow) {
+                user_done(global, conn);
+            } else {
+                conn->next_free = global->free_conns;
+                global->free_conns = conn;
             }
-            global->stat->hits++;
-            global->hits_sec++;
-            /* Cleanups after download */
-            free(conn->memory);
-            free(conn);
         }
     }
+    /* Closed-loop, create new readers here. In open-loop the rate timer
+       starts them and virtual users start their own. */
+    if (0 == global->open_loop && 0 == flow) {
+        fill_conns(global);
+    }
 }
 
 /* Called by libevent when our "wait for socket actions" timeout expires */
@@ -187,12 +479,12 @@ static void socket_action_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
 static int multi_timer_cb(CURLM *multi, long timeout_ms, global_info *global) {
     orcout(orcm_debug, "%s timeout %li\n", __PRETTY_FUNCTION__,  timeout_ms);
     ev_timer_stop(global->loop, &(global->timer_event));
-    if (timeout_ms > 0) {
-        double  t = timeout_ms / 1000;
-        ev_timer_init(&(global->timer_event), socket_action_timer_cb, t, 0.);
+    if (timeout_ms >= 0) {
+        /* libcurl refuses socket_action calls from inside its own
+           callbacks, so a zero timeout also goes through the loop */
+        double  t = timeout_ms / 1000.0;
+        ev_timer_set(&(global->timer_event), t, 0.);
         ev_timer_start(global->loop, &(global->timer_event));
-    } else {
-        socket_action_timer_cb(global->loop, &(global->timer_event), 0);
     }
     return 0;
 }
@@ -284,48 +576,40 @@ static int sock_cb(CURL *handle, curl_socket_t curl_soc, int what, void *cbp,
     return 0;
 }
 
-/* CURLOPT_WRITEFUNCTION - reads a page and write to memmory */
-static size_t write_cb(void *contents, size_t size, size_t nmemb, void *data) {
-    size_t realsize = size * nmemb;
-    conn_info *conn = (conn_info *)data;
-
-    conn->memory = realloc(conn->memory, conn->memory_size + realsize + 1);
-    if (0 == conn->memory) {
-        /* out of memory! */
-        orcerror("%s (%d)\n", strerror(errno), errno);
-        exit(EXIT_FAILURE);
+/* Keeps the body in memmory, only used by the buffer sink */
+static void buffer_body(conn_info *conn, void *contents, size_t realsize) {
+    if (conn->memory_size + realsize + 1 > conn->memory_cap) {
+        /* The buffer is kept between requests, only grow it */
+        conn->memory_cap = conn->memory_size + realsize + 1;
+        conn->memory = realloc(conn->memory, conn->memory_cap);
+        if (0 == conn->memory) {
+            /* out of memory! */
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
     }
 
     memcpy(&(conn->memory[conn->memory_size]), contents, realsize);
     conn->memory_size += realsize;
     conn->memory[conn->memory_size] = 0;
+}
+
+/* CURLOPT_WRITEFUNCTION - counts the body, and depending on the sink mode
+   checksums it or keeps it in memmory */
+static size_t write_cb(void *contents, size_t size, size_t nmemb, void *data) {
+    size_t realsize = size * nmemb;
+    conn_info *conn = (conn_info *)data;
+
+    conn->body_size += realsize;
+    if (orcs_checksum == conn->global->sink) {
+        conn->checksum = orc_fnv1a(conn->checksum, contents, realsize);
+    } else if (orcs_buffer == conn->global->sink) {
+        buffer_body(conn, contents, realsize);
+    }
 
-    /* lets update the */
-    conn->global->stat->total_bytes += realsize;
-    conn->global->read_byte_memory += realsize;
-
-    struct timeval readt;
-    readt.tv_sec = conn->global->read_time.tv_sec;
-    readt.tv_usec = conn->global->read_time.tv_usec;
-    struct timeval now;
-    gettimeofday(&now, 0);
-    if ((now.tv_sec - readt.tv_sec) >= 2) {
-        long sec = now.tv_sec - readt.tv_sec;
-        long usec = now.tv_usec - readt.tv_usec;
-        if (usec < 0) {
-            sec--;
-            usec = 1000000 - (readt.tv_usec - now.tv_usec);
-        }
-        double timediff = (double)sec + ((double)usec / 1000000.0);
-
-        conn->global->stat->bytes_sec =
-            conn->global->read_byte_memory / timediff;
-        conn->global->read_byte_memory = 0;
-        conn->global->stat->hits_sec = conn->global->hits_sec;
-        conn->global->hits_sec = 0;
-        printf("%f %d\n", timediff, conn->global->stat->bytes_sec);
-        gettimeofday(&(conn->global->read_time), 0);
-        //sync_mmap_ifused(conn->global);
+    /* Only counted, readers derive the rate from the published totals */
+    if (0 == conn->warmup) {
+        conn->global->stat->total_bytes += realsize;
     }
 
     return realsize;
@@ -341,50 +625,222 @@ static int prog_cb(void *data, double dltotal, double dlnow, double ult,
     if (dlnow > 0 && dltotal > 0) {
         orcout(orcm_debug, "Progress: %s (%g/%g)\n", conn->url, dlnow, dltotal);
     }
-    return done;
+    return conn->global->aborting;
 }
 
-/* Create a new easy handle, and add it to the global curl_multi */
-static void new_conn(global_info *global) {
-    CURLMcode rc;
-    conn_info *conn;
-    long int debug = 1L;
-    if (orcm_debug != debug) {
-        debug = 0;
+/* Give a handle the slots of every step of the scenario */
+static void setup_user(conn_info *conn) {
+    int i;
+    conn->flow_scratch = calloc(flow->count, sizeof(request_scratch));
+    if (0 == conn->flow_scratch) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < flow->count; i++) {
+        request_setup(flow->steps[i].request, conn->easy,
+                      &(conn->flow_scratch[i]));
     }
+    /* An empty file turns on the cookie engine of the handle */
+    curl_easy_setopt(conn->easy, CURLOPT_COOKIEFILE, "");
+    conn->flow_step = 0;
+    conn->flow_repeat = flow->steps[0].repeat;
+}
 
-    conn = calloc(1, sizeof(conn_info));
-    memset(conn, 0, sizeof(conn_info));
+/* Create the pool of easy handles. Everything but the url is set once here,
+   so starting a request only costs a CURLOPT_URL and an add_handle. */
+static void create_pool(global_info *global, const polyarguments *arg) {
+    int i;
+    long int debug = 0L;
+    long int http_version = CURL_HTTP_VERSION_NONE;
+    if (orcm_debug == get_verbosity()) {
+        debug = 1L;
+    }
+    if (orch_2tls == arg->http) {
+        http_version = CURL_HTTP_VERSION_2TLS;
+    } else if (orch_2c == arg->http) {
+        http_version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+    }
 
-    conn->error[0] = '\0';
-    conn->easy = curl_easy_init();
-    if (!conn->easy) {
-        orcerror("curl_easy_init() failed, exiting!\n");
+    global->pool = calloc(global->job_max, sizeof(conn_info));
+    if (0 == global->pool) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
         exit(EXIT_FAILURE);
     }
+    global->free_conns = 0;
+    for (i = global->job_max - 1; i >= 0; i--) {
+        conn_info *conn = &(global->pool[i]);
+        conn->easy = curl_easy_init();
+        if (!conn->easy) {
+            orcerror("curl_easy_init() failed, exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        conn->global = global;
+        curl_easy_setopt(conn->easy, CURLOPT_WRITEFUNCTION, write_cb);
+        curl_easy_setopt(conn->easy, CURLOPT_WRITEDATA, conn);
+        curl_easy_setopt(conn->easy, CURLOPT_VERBOSE, debug);
+        curl_easy_setopt(conn->easy, CURLOPT_ERRORBUFFER, conn->error);
+        curl_easy_setopt(conn->easy, CURLOPT_PRIVATE, conn);
+        curl_easy_setopt(conn->easy, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(conn->easy, CURLOPT_PROGRESSFUNCTION, prog_cb);
+        curl_easy_setopt(conn->easy, CURLOPT_PROGRESSDATA, conn);
+        curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_TIME, 3L);
+        curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_LIMIT, 10L);
+        curl_easy_setopt(conn->easy, CURLOPT_USERAGENT, ORC_USERAGENT);
+        curl_easy_setopt(conn->easy, CURLOPT_FOLLOWLOCATION, 1L);
+        if (orch_default != arg->http) {
+            curl_easy_setopt(conn->easy, CURLOPT_HTTP_VERSION, http_version);
+            /* Wait for a connection that can multiplex rather than opening
+               a new one per transfer */
+            curl_easy_setopt(conn->easy, CURLOPT_PIPEWAIT, 1L);
+        }
+        if (0 != share) {
+            curl_easy_setopt(conn->easy, CURLOPT_SHARE, share);
+        }
+        if (0 != resolve) {
+            curl_easy_setopt(conn->easy, CURLOPT_RESOLVE, resolve);
+        }
+        if (0 != request) {
+            request_setup(request, conn->easy, &(conn->scratch));
+        }
+        if (0 != flow) {
+            setup_user(conn);
+        }
+        conn->next_free = global->free_conns;
+        global->free_conns = conn;
+    }
+}
 
-    conn->memory = calloc(1, sizeof(char));
-    conn->memory_size = 0;
+/* Cleanup the pool, no handle may be in the multi any more */
+static void destroy_pool(global_info *global) {
+    int i;
+    for (i = 0; i < global->job_max; i++) {
+        curl_easy_cleanup(global->pool[i].easy);
+        free(global->pool[i].memory);
+        request_release(&(global->pool[i].scratch));
+        if (0 != global->pool[i].flow_scratch) {
+            int j;
+            for (j = 0; j < flow->count; j++) {
+                request_release(&(global->pool[i].flow_scratch[j]));
+            }
+            free(global->pool[i].flow_scratch);
+        }
+    }
+    free(global->pool);
+    global->pool = 0;
+    global->free_conns = 0;
+}
 
-    conn->global = global;
-    conn->url = ring[global->current];
-    global->current++;
-    if (ring_size == global->current) {
-        global->current = 0;
+/* Give a pooled handle the url and method of a replayed request */
+static void set_replay_request(conn_info *conn, const replay_request *request) {
+    memcpy(conn->url, request->url, sizeof(conn->url));
+    memcpy(conn->method, request->method, sizeof(conn->method));
+    curl_easy_setopt(conn->easy, CURLOPT_CUSTOMREQUEST, (char *)0);
+    if (0 == strcmp(conn->method, "HEAD")) {
+        curl_easy_setopt(conn->easy, CURLOPT_NOBODY, 1L);
+    } else {
+        curl_easy_setopt(conn->easy, CURLOPT_HTTPGET, 1L);
+        if (0 != strcmp(conn->method, "GET")) {
+            curl_easy_setopt(conn->easy, CURLOPT_CUSTOMREQUEST, conn->method);
+        }
+    }
+}
+
+/* Write the values of this request into the template slots of a handle */
+static void set_template_request(global_info *global, conn_info *conn,
+                                 const request_template *tpl,
+                                 request_scratch *scratch) {
+    orctpl_values values;
+    char url[MAX_URL_LEN + 1];
+    values.random = orcrand_next(&(global->rand));
+    values.counter = global->counter++;
+    values.thread = global->id;
+    values.timestamp = (unsigned long long)(ev_now(global->loop) * 1000.0);
+    values.url = conn->url;
+    values.url_len = strlen(conn->url);
+    /* Every placeholder of a request gets the same row */
+    request_fill_csv(tpl, global->csv_row++, &values);
+    /* A url that does not fit keeps the untemplated one */
+    if (0 < request_apply(tpl, conn->easy, scratch, &values, url)) {
+        memcpy(conn->url, url, sizeof(url));
+    }
+}
+
+/* Pick a url of the shard by weight */
+static unsigned int pick_url(global_info *global) {
+    if (0 != global->shard_picker) {
+        unsigned int j = orcalias_sample(&(global->shard_picker->alias),
+                                         &(global->rand));
+        return global->shard_index + j * global->shard_count;
+    }
+    return orcalias_sample(global->urls->picker, &(global->rand));
+}
+
+/* Start the round-robin at a random url of the shard */
+static void start_in_shard(global_info *global) {
+    unsigned int count = global->urls->ring->count;
+    unsigned int shard_index = global->shard_index;
+    unsigned int shard_count = global->shard_count;
+    if (count <= shard_index) {
+        global->current = shard_index % count;
+        return;
+    }
+    unsigned int slots = (count - shard_index + shard_count - 1) / shard_count;
+    global->current = shard_index +
+                      shard_count * orcrand_range(&(global->rand), slots);
+}
+
+/* Count a request against --requests, returns 0 when the limit is hit */
+static int request_allowed(global_info *global, int warmup) {
+    if (0 == warmup && 0 < global->max_requests &&
+        __sync_fetch_and_add(&started, 1) >= global->max_requests)
+    {
+        if (0 == done) {
+            orcstatus(orcm_normal, orc_green, "FINISHED", "%llu requests\n",
+                      global->max_requests);
+        }
+        done = 1;
+        return 0;
+    }
+    return 1;
+}
+
+/* Add an easy handle to the global curl_multi with its next request */
+static void start_conn(global_info *global, conn_info *conn, int warmup) {
+    CURLMcode rc;
+    unsigned int index = UINT_MAX;
+    conn->busy = 1;
+    conn->warmup = warmup;
+
+    conn->error[0] = '\0';
+    conn->memory_size = 0;
+    conn->body_size = 0;
+    conn->checksum = ORC_FNV1A_INIT;
+    if (0 != global->replay) {
+        set_replay_request(conn, &(global->replay_next));
+    } else if (0 != global->urls && 0 != global->urls->picker) {
+        index = pick_url(global);
+        corpus_copy_url(global->urls->ring, index, conn->url);
+    } else if (0 != global->urls) {
+        index = global->current;
+        corpus_copy_url(global->urls->ring, index, conn->url);
+        global->current += global->shard_count;
+        if (global->urls->ring->count <= global->current) {
+            global->current = global->shard_index;
+        }
+    }
+    conn->url_index = UINT_MAX;
+    if (global->urls == tracked && index < global->url_stat_count) {
+        conn->url_index = index;
+    }
+    if (0 != flow) {
+        const scenario_step *step = &(flow->steps[conn->flow_step]);
+        request_scratch *scratch = &(conn->flow_scratch[conn->flow_step]);
+        request_use(step->request, conn->easy, scratch);
+        set_template_request(global, conn, step->request, scratch);
+    } else if (0 != request) {
+        set_template_request(global, conn, request, &(conn->scratch));
     }
     curl_easy_setopt(conn->easy, CURLOPT_URL, conn->url);
-    curl_easy_setopt(conn->easy, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(conn->easy, CURLOPT_WRITEDATA, conn);
-    curl_easy_setopt(conn->easy, CURLOPT_VERBOSE, debug);
-    curl_easy_setopt(conn->easy, CURLOPT_ERRORBUFFER, conn->error);
-    curl_easy_setopt(conn->easy, CURLOPT_PRIVATE, conn);
-    curl_easy_setopt(conn->easy, CURLOPT_NOPROGRESS, 0L);
-    curl_easy_setopt(conn->easy, CURLOPT_PROGRESSFUNCTION, prog_cb);
-    curl_easy_setopt(conn->easy, CURLOPT_PROGRESSDATA, conn);
-    curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_TIME, 3L);
-    curl_easy_setopt(conn->easy, CURLOPT_LOW_SPEED_LIMIT, 10L);
-    curl_easy_setopt(conn->easy, CURLOPT_USERAGENT, ORC_USERAGENT);
-    curl_easy_setopt(conn->easy, CURLOPT_FOLLOWLOCATION, 1);
 
     orcout(orcm_debug, "Adding easy %p to multi %p (%s)\n", conn->easy,
            global->multi, conn->url);
@@ -396,57 +852,444 @@ static void new_conn(global_info *global) {
        that the necessary socket_action() call will be called by this app */
 }
 
-void * event_loop(void *ptr) {
-    thread_context *context = (thread_context *)ptr;
+/* Take an easy handle from the pool, and add it to the global curl_multi */
+static void new_conn(global_info *global) {
+    conn_info *conn = global->free_conns;
+    int warmup = ev_now(global->loop) < global->warmup_end;
 
-    global_info global;
-    orcstatistics altstat;
+    if (0 == request_allowed(global, warmup)) {
+        return;
+    }
+    if (0 == conn) {
+        /* Callers keep job_count below job_max, this should not happen */
+        orcerror("T%d has no free easy handle\n", global->id);
+        return;
+    }
+    global->free_conns = conn->next_free;
+    conn->next_free = 0;
+    start_conn(global, conn, warmup);
+}
 
-    memset(&global, 0, sizeof(global_info));
+/* A virtual user is done thinking, send its next request */
+static void think_cb(struct ev_loop *loop, struct ev_timer *timer,
+                     int revents) {
+    conn_info *conn = (conn_info *)timer->data;
+    global_info *global = conn->global;
+    int warmup = ev_now(loop) < global->warmup_end;
 
-    global.stat = &altstat;
-    char path[PATH_MAX - 1];
-    if (0 != context->arg->stat_dir) {
-        int len = snprintf(path, PATH_MAX - 2, "%s/%d.threadmem",
-                           context->arg->stat_dir, context->id);
-        if (-1 == len) {
-            orcerror("Name error for path %s", path);
-            orcerrno(errno);
-            exit(EXIT_FAILURE);
+    if (0 != done) {
+        return;
+    }
+    if (0 != global->paused) {
+        ev_timer_set(timer, TICK_INTERVAL, 0.);
+        ev_timer_start(loop, timer);
+        return;
+    }
+    if (0 == request_allowed(global, warmup)) {
+        return;
+    }
+    start_conn(global, conn, warmup);
+}
+
+/* Move a virtual user to its next request and let it think first */
+static void user_done(global_info *global, conn_info *conn) {
+    const scenario_step *step = &(flow->steps[conn->flow_step]);
+    double wait = scenario_think(&(step->think), &(global->rand));
+
+    conn->flow_repeat--;
+    if (0 == conn->flow_repeat) {
+        conn->flow_step++;
+        if (flow->count == conn->flow_step) {
+            /* The next session is a new user without cookies */
+            conn->flow_step = 0;
+            if (0 == conn->warmup) {
+                global->stat->sessions++;
+            }
+            curl_easy_setopt(conn->easy, CURLOPT_COOKIELIST, "ALL");
         }
-        int fd = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IXUSR);
-        if (-1 == fd) {
-            orcerror("File %s", path);
-            orcerrno(errno);
-            exit(EXIT_FAILURE);
+        conn->flow_repeat = flow->steps[conn->flow_step].repeat;
+    }
+    if (0 == done) {
+        ev_timer_set(&(conn->think), wait, 0.);
+        ev_timer_start(global->loop, &(conn->think));
+    }
+}
+
+/* Start the virtual users, each after a first think time so they do not
+   all send their first request at once */
+static void start_users(global_info *global) {
+    int i;
+    global->stat->flow_count = flow->count;
+    for (i = 0; i < flow->count; i++) {
+        memcpy(global->stat->flow[i].name, flow->steps[i].name,
+               ORC_FLOW_NAME_LEN);
+    }
+    /* The users own their handles, none is free */
+    global->free_conns = 0;
+    for (i = 0; i < global->job_max; i++) {
+        conn_info *conn = &(global->pool[i]);
+        ev_timer_init(&(conn->think), think_cb,
+                      scenario_think(&(flow->steps[0].think), &(global->rand)),
+                      0.);
+        conn->think.data = conn;
+        ev_timer_start(global->loop, &(conn->think));
+    }
+}
+
+/* Closed-loop, keep job_max transfers in flight */
+static void fill_conns(global_info *global) {
+    while (0 == done && global->job_count < global->job_target) {
+        new_conn(global);
+    }
+}
+
+/* Time until the next open-loop arrival */
+static double arrival_gap(global_info *global) {
+    if (orca_poisson == global->arrival) {
+        return orcrand_exp(&(global->rand), global->rate_gap);
+    }
+    return global->rate_gap;
+}
+
+/* Open-loop, start every request whose arrival time has passed. An arrival
+   that finds job_max transfers in flight is counted as missed, it is never
+   queued, so a slow target can not lower the offered load. */
+static void rate_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
+                          int revents) {
+    global_info *global = (global_info *)timer->data;
+    ev_tstamp now = ev_now(loop);
+
+    if (0 != done) {
+        /* Leave the timer stopped so the loop can run dry */
+        return;
+    }
+
+    while (0 == done && global->next_arrival <= now) {
+        if (global->job_count < global->job_max) {
+            new_conn(global);
+        } else if (now >= global->warmup_end) {
+            global->stat->missed++;
+            if (0 < global->stat->step) {
+                global->stat->steps[global->stat->step - 1].missed++;
+            }
         }
+        global->next_arrival += arrival_gap(global);
+    }
+    if (0 == done) {
+        ev_timer_set(timer, global->next_arrival - now, 0.);
+        ev_timer_start(loop, timer);
+    }
+}
 
-        /* make the file big enough for the mmaped memory */
-        ftruncate(fd, sizeof(orcstatistics));
+/* Open-loop, change the rate of this thread. A rate of 0 pauses. */
+static void set_rate(global_info *global, double rate) {
+    ev_tstamp now = ev_now(global->loop);
+    if (0 >= rate) {
+        global->rate_gap = 0;
+        ev_timer_stop(global->loop, &(global->rate_timer));
+        return;
+    }
+    double gap = 1.0 / rate;
+    if (0 == global->rate_gap) {
+        global->rate_gap = gap;
+        global->next_arrival = now + arrival_gap(global);
+    } else if (gap != global->rate_gap) {
+        /* Scale what is left of the wait to the new rate, this keeps
+           Poisson arrivals Poisson */
+        if (global->next_arrival > now) {
+            global->next_arrival = now + (global->next_arrival - now) *
+                                   gap / global->rate_gap;
+        }
+        global->rate_gap = gap;
+    } else {
+        return;
+    }
+    ev_timer_stop(global->loop, &(global->rate_timer));
+    ev_timer_set(&(global->rate_timer), global->next_arrival - now, 0.);
+    ev_timer_start(global->loop, &(global->rate_timer));
+}
 
-        global.stat = mmap(NULL, sizeof(orcstatistics), PROT_READ | PROT_WRITE,
-                           MAP_SHARED, fd, 0);
-        if (MAP_FAILED == global.stat) {
-            orcerror("Maping memory failed \n");
-            orcerrno(errno);
-            exit(EXIT_FAILURE);
+/* Follow the load profile, returns 0 when it has ended */
+static int apply_profile(global_info *global, ev_tstamp now) {
+    const load_profile *profile = global->profile;
+    double t = now - global->warmup_end;
+    if (0 > t) {
+        /* Warm up at the start of the profile, without counting it */
+        t = 0;
+        global->stat->step = 0;
+    }
+    int step = profile_step_at(profile, t);
+    int last = global->stat->step - 1;
+    if (0 <= last && last != step) {
+        /* The tick is late, the step did run to its end */
+        global->stat->steps[last].seconds = profile->steps[last].seconds;
+    }
+    if (0 > step) {
+        return 0;
+    }
+    double value = profile_value_at(profile, step, t);
+    global->stat->step = step + 1;
+    global->stat->steps[step].seconds = t - profile->steps[step].start;
+    if (0 != global->open_loop) {
+        /* The rate is for all threads */
+        global->stat->target = value / global->threads;
+        set_rate(global, global->stat->target);
+    } else {
+        global->job_target = (int)(value + 0.5);
+        if (global->job_target > global->job_max) {
+            global->job_target = global->job_max;
         }
-        fd = close(fd);
-        if (-1 == fd) {
-            orcerror("Close file %s", path);
-            orcerrno(errno);
-            exit(EXIT_FAILURE);
+        global->stat->target = global->job_target;
+        fill_conns(global);
+    }
+    return 1;
+}
+
+/* Abort the transfers still in flight, they are not counted */
+static void abort_conns(global_info *global) {
+    int i;
+    global->aborting = 1;
+    for (i = 0; i < global->job_max; i++) {
+        conn_info *conn = &(global->pool[i]);
+        if (0 == conn->busy) {
+            continue;
         }
-        global.stat_need_sync = 1;
+        curl_multi_remove_handle(global->multi, conn->easy);
+        conn->busy = 0;
+        conn->next_free = global->free_conns;
+        global->free_conns = conn;
+        global->job_count--;
+        global->stat->aborted++;
     }
-    memset(global.stat, 0, sizeof(orcstatistics));
-    global.stat->thread_no = context->id;
+}
 
-    // Let us start at a random place in the ring
-    global.current = random()%ring_size;
+/* Stopping, start nothing new and let the transfers in flight finish
+   within the drain timeout. The loop ends when none is left. */
+static void drain(global_info *global, ev_tstamp now) {
+    if (0 == global->drain_deadline) {
+        global->drain_deadline = now + global->drain_timeout;
+        ev_timer_stop(global->loop, &(global->rate_timer));
+        ev_timer_stop(global->loop, &(global->replay_timer));
+    }
+    if (0 < global->job_count &&
+        (now >= global->drain_deadline || 0 != abort_all))
+    {
+        abort_conns(global);
+    }
+    if (0 == global->job_count) {
+        if (0 != flow) {
+            int i;
+            for (i = 0; i < global->job_max; i++) {
+                ev_timer_stop(global->loop, &(global->pool[i].think));
+            }
+        }
+        ev_timer_stop(global->loop, &(global->tick_timer));
+        ev_break(global->loop, EVBREAK_ALL);
+    }
+}
+
+/* The coordinator started the run, its clock starts now */
+static void release_hold(global_info *global, ev_tstamp now) {
+    global->held = 0;
+    global->warmup_end = now + global->warmup;
+    if (0 < global->duration) {
+        global->stop_at = global->warmup_end + global->duration;
+    }
+}
+
+/* Pick up what the admin channel changed since the last tick */
+static void apply_control(global_info *global) {
+    global->generation = control.generation;
+    __sync_synchronize();
+    url_set *set = control.urls;
+    int moved = 0;
+    if (0 < control.shard_count &&
+        (control.shard_count != global->shard_count ||
+         control.shard_index != global->shard_index))
+    {
+        global->shard_count = control.shard_count;
+        global->shard_index = control.shard_index;
+        moved = 1;
+    }
+    global->shard_picker = control.picker;
+    if (0 != set && (set != global->urls || 0 != moved)) {
+        global->urls = set;
+        start_in_shard(global);
+    }
+    if (0 < control.rate) {
+        global->rate = control.rate / global->threads;
+    }
+    if (0 < control.events) {
+        global->events = control.events;
+        if (global->events > global->job_max) {
+            global->events = global->job_max;
+        }
+    }
+    global->paused = control.paused;
+    if (0 != global->held && 0 == global->paused) {
+        ev_tstamp now = ev_now(global->loop);
+        if (now < control.start_at) {
+            /* Paused until the start time of the coordinator */
+            global->paused = 1;
+            ev_timer_stop(global->loop, &(global->start_timer));
+            ev_timer_set(&(global->start_timer), control.start_at - now, 0.);
+            ev_timer_start(global->loop, &(global->start_timer));
+            return;
+        }
+        release_hold(global, now);
+    }
+    if (0 != global->replay || 0 != flow) {
+        /* Virtual users look at paused themselves */
+        return;
+    }
+    if (0 != global->paused) {
+        if (0 != global->open_loop) {
+            set_rate(global, 0);
+        } else {
+            global->job_target = 0;
+        }
+    } else if (0 == global->profile) {
+        /* A profile sets its own target on this tick */
+        if (0 != global->open_loop) {
+            set_rate(global, global->rate);
+        } else {
+            global->job_target = global->events;
+            fill_conns(global);
+        }
+    }
+}
+
+/* The start time of a held run has come */
+static void start_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
+                           int revents) {
+    apply_control((global_info *)timer->data);
+}
+
+/* Housekeeping of a loop, runs every TICK_INTERVAL */
+static void tick_cb(struct ev_loop *loop, struct ev_timer *timer,
+                    int revents) {
+    global_info *global = (global_info *)timer->data;
+    ev_tstamp now = ev_now(loop);
+
+    if (global->generation != control.generation) {
+        apply_control(global);
+    }
+    if (0 == done && 0 != global->profile && 0 == global->paused &&
+        0 == apply_profile(global, now)) {
+        if (1 == global->id) {
+            orcstatus(orcm_normal, orc_green, "FINISHED", "Load profile\n");
+        }
+        done = 1;
+    }
+    if (0 == done && 0 < global->stop_at && now >= global->stop_at) {
+        if (1 == global->id) {
+            orcstatus(orcm_normal, orc_green, "FINISHED", "Duration\n");
+        }
+        done = 1;
+    }
+    if (0 != done || 0 != global->replay_done) {
+        drain(global, now);
+    }
+    publish(global);
+}
+
+/* Replay, start every request of the log whose time has come. Like the
+   open-loop rate a request that finds job_max in flight is missed. */
+static void replay_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
+                            int revents) {
+    global_info *global = (global_info *)timer->data;
+    ev_tstamp now = ev_now(loop);
+
+    while (0 == done && 0 == global->replay_done) {
+        ev_tstamp due = start_time +
+                        global->replay_next.offset / global->replay_speed;
+        if (due > now) {
+            ev_timer_set(timer, due - now, 0.);
+            ev_timer_start(loop, timer);
+            return;
+        }
+        if (global->job_count < global->job_max) {
+            new_conn(global);
+        } else if (now >= global->warmup_end) {
+            global->stat->missed++;
+        }
+        if (0 == replay_next(global->replay, &(global->replay_next))) {
+            orcstatus(orcm_verbose, orc_green, "FINISHED",
+                      "Replay of thread %d\n", global->id);
+            global->replay_done = 1;
+        }
+    }
+}
+
+/* Multiplexing and connection caps of the multi handle of a thread */
+static void setup_multi_limits(global_info *global, const polyarguments *arg) {
+    CURLMcode rc;
+    if (orch_default != arg->http) {
+        rc = curl_multi_setopt(global->multi, CURLMOPT_PIPELINING,
+                               CURLPIPE_MULTIPLEX);
+        mcode_or_die("setup_multi_limits: CURLMOPT_PIPELINING", rc);
+    }
+    if (0 < arg->max_streams) {
+        rc = curl_multi_setopt(global->multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                               (long)arg->max_streams);
+        mcode_or_die("setup_multi_limits: CURLMOPT_MAX_CONCURRENT_STREAMS",
+                     rc);
+    }
+    if (0 < arg->max_host_conns) {
+        rc = curl_multi_setopt(global->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                               (long)arg->max_host_conns);
+        mcode_or_die("setup_multi_limits: CURLMOPT_MAX_HOST_CONNECTIONS", rc);
+    }
+    if (0 < arg->max_conns) {
+        rc = curl_multi_setopt(global->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                               (long)arg->max_conns);
+        mcode_or_die("setup_multi_limits: CURLMOPT_MAX_TOTAL_CONNECTIONS", rc);
+    }
+}
+
+void * event_loop(void *ptr) {
+    thread_context *context = (thread_context *)ptr;
+
+    global_info global;
+
+    memset(&global, 0, sizeof(global_info));
+
+    /* Updates go to private statistics, readers only see the slot */
+    global.stat = calloc(1, sizeof(orcstatistics));
+    if (0 == global.stat) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    context->stat = global.stat;
+    global.stat->thread_no = context->id;
+    global.stat->started = (unsigned long long)(ev_time() * 1000000.0);
+    global.slot = context->slot;
+    publish(&global);
+    global.url_stats = orcseg_urls(&segment, context->id - 1);
+    if (0 != global.url_stats) {
+        global.url_stat_count = segment.header->urls;
+    }
 
     global.id = context->id;
     global.job_max = context->arg->max_events;
+    global.sink = context->arg->sink;
+    unsigned long long seed = context->arg->seed;
+    if (0 == seed) {
+        seed = (unsigned long long)time(0);
+    }
+    orcrand_seed(&(global.rand), (seed << 16) ^ (unsigned long long)context->id);
+
+    // Let us start at a random place in the ring
+    global.urls = urls;
+    global.shard_index = 0;
+    global.shard_count = 1;
+    if (0 != global.urls) {
+        start_in_shard(&global);
+    }
+    // and the csv rows of a template
+    if (0 != request && 0 < request->row_count) {
+        global.csv_row = orcrand_range(&(global.rand), request->row_count);
+    }
     global.loop = ev_loop_new(0);
     global.multi = curl_multi_init();
     ev_timer_init(&(global.timer_event), socket_action_timer_cb, 0., 0.);
@@ -455,37 +1298,313 @@ void * event_loop(void *ptr) {
     curl_multi_setopt(global.multi, CURLMOPT_TIMERDATA, &global);
     curl_multi_setopt(global.multi, CURLMOPT_SOCKETFUNCTION, sock_cb);
     curl_multi_setopt(global.multi, CURLMOPT_SOCKETDATA, &global);
+    setup_multi_limits(&global, context->arg);
+
+    create_pool(&global, context->arg);
 
-    gettimeofday(&(global.read_time), 0);
-    new_conn(&global);
+    global.threads = context->arg->max_threads;
+    global.profile = context->arg->profile;
+    global.warmup = context->arg->warmup;
+    global.duration = context->arg->duration;
+    global.held = context->arg->hold;
+    global.paused = context->arg->hold;
+    ev_timer_init(&(global.start_timer), start_timer_cb, 0., 0.);
+    global.start_timer.data = &global;
+    global.warmup_end = start_time + context->arg->warmup;
+    if (0 < context->arg->duration && 0 == global.held) {
+        global.stop_at = global.warmup_end + context->arg->duration;
+    }
+    global.max_requests = context->arg->requests;
+    global.drain_timeout = context->arg->drain_timeout;
+    global.job_target = global.job_max;
+    global.events = global.job_max;
+    global.rate = context->arg->rate / context->arg->max_threads;
+    global.arrival = context->arg->arrival;
+    ev_timer_init(&(global.rate_timer), rate_timer_cb, 0., 0.);
+    global.rate_timer.data = &global;
+    ev_timer_init(&(global.tick_timer), tick_cb, TICK_INTERVAL, TICK_INTERVAL);
+    global.tick_timer.data = &global;
+    ev_timer_start(global.loop, &(global.tick_timer));
+    if (0 < context->arg->rate) {
+        global.open_loop = 1;
+    }
+    replay_reader reader;
+    if (0 != context->arg->replay) {
+        /* Opened by the thread, the read buffer is allocated on its node */
+        replay_open(&reader, context->arg->replay, context->arg->replay_format,
+                    context->arg->replay_base, context->id - 1,
+                    context->arg->max_threads);
+        global.replay = &reader;
+        global.replay_speed = context->arg->replay_speed;
+        global.open_loop = 1;
+        ev_timer_init(&(global.replay_timer), replay_timer_cb, 0., 0.);
+        global.replay_timer.data = &global;
+        if (0 == replay_next(&reader, &(global.replay_next))) {
+            global.replay_done = 1;
+        } else {
+            ev_timer_start(global.loop, &(global.replay_timer));
+        }
+    } else if (0 != flow) {
+        start_users(&global);
+    } else if (0 != global.held) {
+        /* Started by the admin channel */
+    } else if (0 != global.profile) {
+        apply_profile(&global, ev_now(global.loop));
+    } else if (0 != global.open_loop) {
+        /* The total rate is shared evenly by the threads */
+        set_rate(&global, global.rate);
+    } else {
+        fill_conns(&global);
+    }
     ev_loop(global.loop, 0);
+    publish(&global);
 
     /* Cleanups after looping */
     curl_multi_cleanup(global.multi);
+    destroy_pool(&global);
+    if (0 != global.replay) {
+        replay_close(global.replay);
+    }
     return 0;
 }
 
+/* Print what every profile step achieved, to find where latency turns */
+static void print_steps(const orcstatistics *sum, const load_profile *profile) {
+    int i;
+    orcoutc(orc_reset, orc_red, "%-6s", "step");
+    orcout(orcm_quiet, "%10s %8s %10s %10s %9s %9s %9s\n", "target", "secs",
+           "requests", "req/s", "p50 ms", "p99 ms", "missed");
+    for (i = 0; i < profile->count; i++) {
+        const orcstep *step = &(sum->steps[i]);
+        if (0 >= step->seconds) {
+            break;
+        }
+        const profile_step *ps = &(profile->steps[i]);
+        char target[32];
+        if (ps->from == ps->to) {
+            snprintf(target, sizeof(target), "%g", ps->from);
+        } else {
+            snprintf(target, sizeof(target), "%g-%g", ps->from, ps->to);
+        }
+        orcoutc(orc_reset, orc_red, "%-6d", i + 1);
+        orcout(orcm_quiet, "%10s %8.1f %10llu %10.1f %9.2f %9.2f %9llu\n",
+               target, step->seconds, step->hits, step->hits / step->seconds,
+               orchist_percentile(&(step->latency), 50.0) / 1000.0,
+               orchist_percentile(&(step->latency), 99.0) / 1000.0,
+               step->missed);
+    }
+}
+
+/* Print the latency of every step of the scenario */
+static void print_flow(const orcstatistics *sum) {
+    int i;
+    orcoutc(orc_reset, orc_red, "Sessions:   ");
+    orcout(orcm_quiet, "%llu\n", sum->sessions);
+    orcoutc(orc_reset, orc_red, "%-10s", "step ms");
+    orcout(orcm_quiet, "%10s %9s %9s %9s %9s %9s %9s\n", "count", "mean",
+           "p50", "p90", "p99", "p99.9", "max");
+    for (i = 0; i < sum->flow_count; i++) {
+        orcstat_print_latency(sum->flow[i].name, &(sum->flow[i].latency));
+    }
+}
+
+/* Merge the statistics of all threads and print them */
+static void print_report(thread_context *threads, int count,
+                         const load_profile *profile) {
+    int i;
+    orcstatistics *sum = calloc(1, sizeof(orcstatistics));
+    if (0 == sum) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        if (0 != threads[i].stat) {
+            orcstat_merge(sum, threads[i].stat);
+        }
+    }
+
+    orcoutc(orc_reset, orc_red, "Requests:   ");
+    orcout(orcm_quiet, "%llu\n", sum->hits);
+    orcoutc(orc_reset, orc_red, "Downloaded: ");
+    orcout(orcm_quiet, "%.2Lf %s\n", byte_to_human_size(sum->total_bytes),
+           byte_to_human_suffix(sum->total_bytes));
+    if (0 != sum->missed) {
+        orcoutc(orc_reset, orc_red, "Missed:     ");
+        orcout(orcm_quiet, "%llu\n", sum->missed);
+    }
+    if (0 != sum->aborted) {
+        orcoutc(orc_reset, orc_red, "Aborted:    ");
+        orcout(orcm_quiet, "%llu\n", sum->aborted);
+    }
+    orcoutc(orc_reset, orc_red, "Connects:   ");
+    orcout(orcm_quiet, "%llu\n", sum->connects);
+    if (0 != sum->multiplexed) {
+        orcoutc(orc_reset, orc_red, "Streams:    ");
+        orcout(orcm_quiet, "%llu (h2/h3)\n", sum->multiplexed);
+    }
+    orcstat_print_outcome(sum);
+    orcoutc(orc_reset, orc_red, "%-10s", "ms");
+    orcout(orcm_quiet, "%10s %9s %9s %9s %9s %9s %9s\n", "count", "mean",
+           "p50", "p90", "p99", "p99.9", "max");
+    for (i = 0; i < orcl_count; i++) {
+        orcstat_print_latency(orcstat_latency_name(i), &(sum->latency[i]));
+    }
+    if (0 != sum->failed) {
+        orcstat_print_latency("ok", &(sum->ok_latency));
+        orcstat_print_latency("failed", &(sum->failed_latency));
+    }
+    if (0 != profile) {
+        print_steps(sum, profile);
+    }
+    if (0 != sum->flow_count) {
+        print_flow(sum);
+    }
+    free(sum);
+}
+
+/* Print a table of urls in the order of top */
+static void print_url_table(const char *title, const orcurlstat *sum,
+                            const unsigned int *top, int count) {
+    int i;
+    orcoutc(orc_reset, orc_red, "%-10s", title);
+    orcout(orcm_quiet, "%10s %9s %9s %9s  %s\n", "count", "p50 ms", "p99 ms",
+           "errors", "url");
+    for (i = 0; i < count; i++) {
+        const orcurlstat *url = &(sum[top[i]]);
+        orcoutc(orc_reset, orc_red, "%-10d", i + 1);
+        orcout(orcm_quiet, "%10u %9.2f %9.2f %9u  %s\n", url->count,
+               orcurl_percentile(url, 50.0) / 1000.0,
+               orcurl_percentile(url, 99.0) / 1000.0, url->errors,
+               orcseg_url_name(&segment, top[i]));
+    }
+}
+
+/* Merge the url statistics of all threads and print the slowest urls and
+   the urls that fail most */
+static void print_urls(int threads) {
+    unsigned int count = segment.header->urls;
+    unsigned int top[URL_REPORT_TOP];
+    int i, found;
+    if (0 == count) {
+        return;
+    }
+    orcurlstat *sum = calloc(count, sizeof(orcurlstat));
+    if (0 == sum) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        return;
+    }
+    for (i = 0; i < threads; i++) {
+        orcurl_merge(sum, orcseg_urls(&segment, i), count);
+    }
+    found = orcurl_top(sum, count, orcu_p99, top, URL_REPORT_TOP);
+    print_url_table("slowest", sum, top, found);
+    found = orcurl_top(sum, count, orcu_errors, top, URL_REPORT_TOP);
+    if (0 != found) {
+        print_url_table("failing", sum, top, found);
+    }
+    free(sum);
+}
+
+/* The bytes the names of the first count urls take in the segment */
+static unsigned int url_names_size(const url_corpus *ring, unsigned int count) {
+    char url[MAX_URL_LEN + 1];
+    unsigned int i;
+    unsigned int size = 0;
+    for (i = 0; i < count; i++) {
+        size += corpus_copy_url(ring, i, url) + 1;
+    }
+    return size;
+}
+
 static void finish(int sig)
 {
+    if (0 != done) {
+        abort_all = 1;
+        orcoutc(orc_reset, orc_red, "\nCtrl+c again, aborting!\n");
+        return;
+    }
     done = 1;
-    orcoutc(orc_reset, orc_red, "\nCtrl+c detected!\n");
+    orcoutc(orc_reset, orc_red, "\nCtrl+c detected, draining!\n");
 }
 
 void generator_loop(polyarguments *arg) {
     // Add Ctrl+c handling
     done = 0;
+    abort_all = 0;
+    started = 0;
     signal(SIGINT, finish);
+    start_time = ev_time();
 
     thread_context event_threads[arg->max_threads];
+    admin_server *admin = 0;
     int i;
+    contexts = event_threads;
+    context_count = arg->max_threads;
+    const char *segment_path = 0;
+    char path[PATH_MAX - 1];
+    if (0 != arg->stat_dir) {
+        int len = snprintf(path, PATH_MAX - 2, "%s/%s", arg->stat_dir,
+                           ORC_SEGMENT_FILE);
+        if (-1 == len) {
+            orcerror("Name error for path %s", path);
+            orcerrno(errno);
+            exit(EXIT_FAILURE);
+        }
+        segment_path = path;
+    }
+    /* The first urls of the file get statistics of their own */
+    unsigned int url_count = 0;
+    unsigned int names_size = 0;
+    if (0 != arg->url_stats && 0 != urls) {
+        tracked = urls;
+        url_count = tracked->ring->count;
+        if (arg->url_stats < url_count) {
+            url_count = arg->url_stats;
+        }
+        names_size = url_names_size(tracked->ring, url_count);
+    }
+    if (0 == orcseg_create(&segment, segment_path, arg->max_threads,
+                           url_count, names_size)) {
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < (int)url_count; i++) {
+        char url[MAX_URL_LEN + 1];
+        corpus_copy_url(tracked->ring, i, url);
+        orcseg_name_url(&segment, i, url);
+    }
+    for (i = 0; i < arg->max_threads; i++) {
+        event_threads[i].slot = &(segment.slots[i]);
+    }
+    if (0 != arg->admin) {
+        admin = admin_start(arg->admin);
+    }
     for (i = 0; i < arg->max_threads; i++) {
         event_threads[i].id = i + 1;
         event_threads[i].arg = arg;
+        event_threads[i].stat = 0;
+        event_threads[i].cpu = -1;
+        /* A pinned thread runs on its cpu from the start, so the stats,
+           handles and buffers it allocates are local to that node */
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (0 != arg->pin) {
+            int cpu = arg->cpus[i % arg->cpus_len];
+            if (topology_set_cpu(&attr, cpu)) {
+                event_threads[i].cpu = cpu;
+            } else {
+                orcerror("Thread %d can not be pinned to cpu %d\n",
+                         event_threads[i].id, cpu);
+            }
+        }
         int status = pthread_create(&(event_threads[i].pthread),
-                                    0,
+                                    &attr,
                                     event_loop,
                                     (void *)&event_threads[i]);
-        if (0 == status) {
+        pthread_attr_destroy(&attr);
+        if (0 == status && 0 <= event_threads[i].cpu) {
+            orcstatus(orcm_normal, orc_green, "STARTED", "Thread %d on cpu %d\n",
+                      event_threads[i].id, event_threads[i].cpu);
+        } else if (0 == status) {
             orcstatus(orcm_normal, orc_green, "STARTED", "Thread %d\n",
                       event_threads[i].id);
         } else {
@@ -500,67 +1619,404 @@ void generator_loop(polyarguments *arg) {
         orcstatus(orcm_normal, orc_green, "HALTED", "Thread %d\n",
                   event_threads[i].id);
     }
+    __sync_synchronize();
+    finished = 1;
+    if (0 != arg->hold) {
+        /* Give the coordinator time to fetch the last statistics */
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += HOLD_LINGER;
+        pthread_mutex_lock(&bye_lock);
+        while (0 == bye) {
+            if (0 != pthread_cond_timedwait(&bye_cond, &bye_lock, &until)) {
+                break;
+            }
+        }
+        pthread_mutex_unlock(&bye_lock);
+    }
+    /* Before the statistics it reads go away */
+    admin_stop(admin);
+    contexts = 0;
+    context_count = 0;
+
+    print_report(event_threads, arg->max_threads, arg->profile);
+    print_urls(arg->max_threads);
+
+    for (i = 0; i < arg->max_threads; i++) {
+        free(event_threads[i].stat);
+    }
+    orcseg_close(&segment);
 }
 
-void create_url_ring(const char* file_name) {
-    ring_size = 0;
-    ring = 0;
-    char *buff = 0;
-    size_t buff_len = 0;
-    int status = 0;
+static void free_urls(url_set *set);
 
-    FILE *url_file = fopen(file_name, "r");
-    if (0 == url_file) {
+/* Load a url file and its weights. Returns 0 if the file can not be used,
+   the error is printed. */
+static url_set * try_load_urls(const char *file_name,
+                               const polyarguments *arg) {
+    url_set *set = calloc(1, sizeof(url_set));
+    if (0 == set) {
         orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    url_corpus *ring = corpus_try_open(file_name, arg->max_threads,
+                                       arg->index_cache);
+    if (0 == ring) {
+        free(set);
+        return 0;
+    }
+    set->ring = ring;
+    orcstatus(orcm_normal, orc_green, "LOADED", "%u urls from %s\n",
+              ring->count, file_name);
+    if (0 == ring->count) {
+        return set;
+    }
+
+    double *weights = 0;
+    if (0 < arg->zipf) {
+        weights = malloc(ring->count * sizeof(double));
+        if (0 == weights) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        unsigned int i;
+        for (i = 0; i < ring->count; i++) {
+            weights[i] = pow(i + 1.0, -arg->zipf);
+        }
+        orcstatus(orcm_verbose, orc_green, "WEIGHTS", "Zipf %g\n", arg->zipf);
+    } else if (0 < corpus_weights(ring, &weights)) {
+        orcstatus(orcm_verbose, orc_green, "WEIGHTS", "From %s\n",
+                  file_name);
+    } else {
+        free(weights);
+        weights = 0;
+    }
+    if (0 != weights) {
+        set->weights = weights;
+        set->picker = calloc(1, sizeof(orcalias));
+        if (0 == set->picker) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        if (0 == orcalias_init(set->picker, weights, ring->count)) {
+            orcerror("Can not pick urls by weight\n");
+            free(set->picker);
+            set->picker = 0;
+            free_urls(set);
+            return 0;
+        }
     }
+    return set;
+}
 
-    int i = 0;
-    while (0 < (status = getline(&buff, &buff_len, url_file))) {
-        i++;
+/* Load the url file the run needs, failures are fatal */
+static url_set * load_urls(const char *file_name, const polyarguments *arg) {
+    url_set *set = try_load_urls(file_name, arg);
+    if (0 == set) {
+        exit(EXIT_FAILURE);
     }
-    if (-1 == status && 0 < errno) {
+    return set;
+}
+
+/* Free a url set and the sets used before it */
+static void free_urls(url_set *set) {
+    while (0 != set) {
+        url_set *older = set->older;
+        if (0 != set->picker) {
+            orcalias_free(set->picker);
+            free(set->picker);
+        }
+        free(set->weights);
+        corpus_close(set->ring);
+        free(set);
+        set = older;
+    }
+}
+
+/* Make the picker of shard index of count for a weighted url set. Returns
+   0 if the shard has no url with weight, the error is printed. */
+static shard_picker * make_shard_picker(const url_set *set, int index,
+                                        int count) {
+    unsigned int total = set->ring->count;
+    unsigned int len = (total - index + count - 1) / count;
+    unsigned int j;
+    shard_picker *picker = calloc(1, sizeof(shard_picker));
+    double *weights = malloc(len * sizeof(double));
+    if (0 == picker || 0 == weights) {
         orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    for (j = 0; j < len; j++) {
+        weights[j] = set->weights[index + j * count];
+    }
+    int status = orcalias_init(&(picker->alias), weights, len);
+    free(weights);
+    if (0 == status) {
+        orcerror("Can not pick the urls of shard %d of %d by weight\n",
+                 index, count);
+        free(picker);
+        return 0;
+    }
+    picker->older = shard_pickers;
+    shard_pickers = picker;
+    return picker;
+}
+
+/* Free every shard picker made */
+static void free_shard_pickers() {
+    while (0 != shard_pickers) {
+        shard_picker *older = shard_pickers->older;
+        orcalias_free(&(shard_pickers->alias));
+        free(shard_pickers);
+        shard_pickers = older;
+    }
+}
+
+void generator_init(polyarguments *arg) {
+    options = arg;
+    control.rate = arg->rate;
+    control.events = arg->max_events;
+    control.paused = arg->hold;
+    /* Before any thread touches libcurl */
+    CURLcode code = curl_global_init(CURL_GLOBAL_ALL);
+    if (CURLE_OK != code) {
+        orcerror("curl_global_init() %s\n", curl_easy_strerror(code));
+        exit(EXIT_FAILURE);
     }
-    if (0 == i) {
+    if (0 != arg->share) {
+        share = share_create(arg->share);
+    }
+    resolve = share_resolve_list(arg->resolve, arg->resolve_len);
+    if (0 != arg->replay) {
+        /* The log is streamed by the threads */
+        return;
+    }
+    if (0 != arg->scenario_file) {
+        flow = calloc(1, sizeof(scenario));
+        if (0 == flow) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        scenario_load(flow, arg->scenario_file, arg->csv_file,
+                      0 != arg->in_file);
+        orcstatus(orcm_normal, orc_green, "LOADED", "%d steps from %s\n",
+                  flow->count, arg->scenario_file);
+        if (0 == arg->in_file) {
+            /* Every url comes from the templates */
+            return;
+        }
+    } else if (0 != arg->template_file) {
+        request = request_load(arg->template_file, arg->csv_file);
+        orcstatus(orcm_normal, orc_green, "LOADED", "%s %s with %d headers\n",
+                  request->method, arg->template_file, request->header_count);
+        if (0 != request->row_count) {
+            orcstatus(orcm_normal, orc_green, "LOADED", "%u rows from %s\n",
+                      request->row_count, arg->csv_file);
+        }
+        if (0 == request->has_url && 0 == arg->in_file) {
+            orcerror("%s has no url, give urls with -f\n", arg->template_file);
+            exit(EXIT_FAILURE);
+        }
+        if (0 == arg->in_file) {
+            /* Every url comes from the template */
+            return;
+        }
+    }
+
+    urls = load_urls(arg->in_file, arg);
+    if (0 == urls->ring->count) {
         orcout(orcm_quiet, "No urls to process!\n");
         exit(0);
     }
+    control.urls = urls;
 
-    const int lines = i;
-    ring_size = i;
-    ring = calloc(i, sizeof(char*));
-    if (0 == ring) {
-        orcerror("%s (%d)\n", strerror(errno), errno);
-        exit(EXIT_FAILURE);
+    if (0 != arg->pre_resolve) {
+        resolve = share_pre_resolve(urls->ring, resolve);
     }
+}
 
-    rewind(url_file);
-    i = 0;
-    while (i < lines && 0 < (status = getline(&buff, &buff_len, url_file))) {
-        int index = buff_len - 1;
-        while (index >= 0) {
-            if(buff[index] == '\n') {
-                buff[index] = '\0';
-                break;
-            }
-            index--;
+void generator_destroy(){
+    share_destroy(share);
+    share = 0;
+    curl_slist_free_all(resolve);
+    resolve = 0;
+    curl_global_cleanup();
+    free_urls(urls);
+    urls = 0;
+    control.urls = 0;
+    free_shard_pickers();
+    control.picker = 0;
+    request_free(request);
+    request = 0;
+    if (0 != flow) {
+        scenario_free(flow);
+        free(flow);
+        flow = 0;
+    }
+}
+
+/* Make the changes to control visible to the threads */
+static void publish_control() {
+    __sync_synchronize();
+    __sync_add_and_fetch(&(control.generation), 1);
+}
+
+/* The rate can be changed for an open-loop that follows no profile */
+static int can_set_rate() {
+    return 0 < options->rate && 0 == options->profile &&
+           0 == options->replay && 0 == options->scenario_file;
+}
+
+/* The events can be changed for a closed-loop that follows no profile */
+static int can_set_events() {
+    return 0 == options->rate && 0 == options->profile &&
+           0 == options->replay && 0 == options->scenario_file;
+}
+
+int generator_set_rate(double rate) {
+    if (0 == can_set_rate() || !(0 < rate)) {
+        return 0;
+    }
+    control.rate = rate;
+    publish_control();
+    return 1;
+}
+
+int generator_set_events(int events) {
+    if (0 == can_set_events() || 0 >= events) {
+        return 0;
+    }
+    control.events = events;
+    publish_control();
+    return 1;
+}
+
+int generator_scale(double factor) {
+    if (!(0 < factor)) {
+        return 0;
+    }
+    if (can_set_rate()) {
+        return generator_set_rate(control.rate * factor);
+    }
+    if (can_set_events()) {
+        int events = (int)(control.events * factor + 0.5);
+        if (events == control.events) {
+            events += (1 < factor) ? 1 : -1;
+        }
+        if (events > options->max_events) {
+            events = options->max_events;
+        }
+        return generator_set_events((0 < events) ? events : 1);
+    }
+    return 0;
+}
+
+int generator_pause(int paused) {
+    if (0 != options->replay) {
+        return 0;
+    }
+    control.paused = paused;
+    publish_control();
+    orcstatus(orcm_normal, orc_green, paused ? "PAUSED" : "RESUMED",
+              "By admin\n");
+    return 1;
+}
+
+int generator_switch_urls(const char *file_name) {
+    if (0 != options->replay) {
+        return 0;
+    }
+    url_set *set = try_load_urls(file_name, options);
+    if (0 == set) {
+        return 0;
+    }
+    if (0 == set->ring->count) {
+        free_urls(set);
+        return 0;
+    }
+    shard_picker *picker = 0;
+    if (1 < control.shard_count && 0 != set->picker) {
+        if ((unsigned int)control.shard_count > set->ring->count) {
+            free_urls(set);
+            return 0;
+        }
+        picker = make_shard_picker(set, control.shard_index,
+                                   control.shard_count);
+        if (0 == picker) {
+            free_urls(set);
+            return 0;
         }
-        ring[i] = buff;
-        buff = 0;
-        i++;
     }
-    if (-1 == status && 0 < errno) {
+    /* Threads may still use the older sets */
+    set->older = urls;
+    urls = set;
+    control.urls = set;
+    control.picker = picker;
+    publish_control();
+    return 1;
+}
+
+void generator_snapshot(orcstatistics *sum) {
+    int i;
+    memset(sum, 0, sizeof(orcstatistics));
+    orcstatistics *stat = malloc(sizeof(orcstatistics));
+    if (0 == stat) {
         orcerror("%s (%d)\n", strerror(errno), errno);
+        return;
     }
+    /* The threads keep writing, read what they published */
+    for (i = 0; i < context_count; i++) {
+        if (0 != orcseg_read(contexts[i].slot, stat)) {
+            orcstat_merge(sum, stat);
+        }
+    }
+    free(stat);
 }
 
-void generator_init(polyarguments *arg) {
-    create_url_ring(arg->in_file);
+void generator_stop() {
+    if (0 == done) {
+        orcstatus(orcm_normal, orc_green, "FINISHED", "Stopped by admin\n");
+    }
+    done = 1;
 }
 
-void generator_destroy(){
-    if (0 != ring) {
-        free(ring);
+int generator_set_shard(int index, int count) {
+    if (0 != options->replay || 0 == urls || 0 >= count || 0 > index ||
+        count <= index || urls->ring->count < (unsigned int)count) {
+        return 0;
+    }
+    shard_picker *picker = 0;
+    if (1 < count && 0 != urls->picker) {
+        picker = make_shard_picker(urls, index, count);
+        if (0 == picker) {
+            return 0;
+        }
     }
+    control.shard_index = index;
+    control.shard_count = count;
+    control.picker = picker;
+    publish_control();
+    return 1;
 }
 
+int generator_start_at(double epoch) {
+    if (0 == options->hold) {
+        return 0;
+    }
+    control.start_at = epoch;
+    control.paused = 0;
+    publish_control();
+    return 1;
+}
+
+int generator_finished() {
+    __sync_synchronize();
+    return finished;
+}
+
+void generator_bye() {
+    pthread_mutex_lock(&bye_lock);
+    bye = 1;
+    pthread_cond_signal(&bye_cond);
+    pthread_mutex_unlock(&bye_lock);
+}
@@ -19,9 +19,26 @@
 #define GENERATOR_H
 
 #include <common.h>
+#include "polyorctypes.h"
 
 void generator_init(polyarguments *arg);
 void generator_destroy();
 void generator_loop(polyarguments *arg);
 
+/* Used by the admin channel while generator_loop runs. The int functions
+   return 1 on succes 0 if the change does not apply to this run. */
+int generator_set_rate(double rate);
+int generator_set_events(int events);
+int generator_scale(double factor);
+int generator_pause(int paused);
+int generator_switch_urls(const char *file_name);
+void generator_snapshot(orcstatistics *sum);
+void generator_stop();
+
+/* Used by a coordinator through the admin channel of a --hold run */
+int generator_set_shard(int index, int count);
+int generator_start_at(double epoch);
+int generator_finished();
+void generator_bye();
+
 #endif
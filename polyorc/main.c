@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <math.h>
 #include <sys/stat.h>
 
 #include <argp.h>
@@ -28,6 +29,9 @@
 #include "polyorcout.h"
 #include "polyorcutils.h"
 #include "generator.h"
+#include "share.h"
+#include "topology.h"
+#include "profile.h"
 
 #define STR_HELPER(x) #x
 #define STR(x) STR_HELPER(x)
@@ -35,11 +39,15 @@
 #define ORC_DEFAULT_ADMIN_PORT 7711
 #define ORC_DEFAULT_ADMIN_PORT_STR STR(ORC_DEFAULT_ADMIN_PORT)
 
+#define DEFAULT_DRAIN 5
+#define DEFAULT_DRAIN_STR STR(DEFAULT_DRAIN)
+
 #define DEFAULT_MAX_EVENTS 20
 #define DEFAULT_MAX_EVENTS_STR STR(DEFAULT_MAX_EVENTS)
 
-#define DEFAULT_MAX_JOBS 16
-#define DEFAULT_MAX_JOBS_STR STR(DEFAULT_MAX_JOBS)
+#define DEFAULT_URL_STATS 10000
+#define DEFAULT_URL_STATS_STR STR(DEFAULT_URL_STATS)
+
 
 #define DEFAULT_OUT "polyorc.out"
 
@@ -53,6 +61,9 @@ static char doc[] =
 /* A description of the arguments we accept. */
 static char args_doc[] = "URL";
 
+/* Set with --profile */
+static load_profile profile;
+
 /* The options we understand. */
 static struct argp_option options[] = {
     {"quiet",        'q', 0,       0, "Don't produce any output" },
@@ -64,9 +75,100 @@ static struct argp_option options[] = {
                                       DEFAULT_MAX_EVENTS_STR ")" },
     {"out",          'o', "FILE",  0, "Output file (default " DEFAULT_OUT ")"},
     {"jobs",         'j', "JOBS",  0, "The number of threads to use" \
-                                      " (default " DEFAULT_MAX_JOBS_STR ")" },
+                                      " (default one per usable cpu)" },
     {"file",         'f', "FILE",  0, "A file with one url per line"},
-    {"stat-dir",     's', "DIR",   0, "A directory for writing stat files"},
+    {"stat-dir",     's', "DIR",   0, "A directory for the statistics segment"},
+    {"rate",         'r', "RPS",   0, "Open-loop mode, start RPS requests per" \
+                                      " second in total no matter how many" \
+                                      " are in flight (events is the cap)" },
+    {"arrival",     1001, "MODE",  0, "Arrivals for --rate: constant or" \
+                                      " poisson (default constant)" },
+    {"body",        1002, "MODE",  0, "What to do with response bodies: count" \
+                                      " the bytes, checksum them or buffer" \
+                                      " them (default count). checksum and" \
+                                      " buffer are shown with --debug" },
+    {"index-cache", 1003, 0,       0, "Keep the url index of --file in a" \
+                                      " FILE.idx sidecar file and reuse it" \
+                                      " while FILE is unchanged" },
+    {"zipf",        1004, "S",     0, "Pick urls with Zipf weights, url" \
+                                      " number n in --file gets weight" \
+                                      " 1/n^S. Without it a second column" \
+                                      " in --file is used as weight and" \
+                                      " urls are taken in turn if there is" \
+                                      " none" },
+    {"seed",        1005, "INT",   0, "Seed the url picking and arrivals to" \
+                                      " repeat a run (default from the clock)" },
+    {"http2",       1006, 0,       0, "Use HTTP/2 for https urls (ALPN) and" \
+                                      " multiplex transfers on connections" },
+    {"h2c",         1007, 0,       0, "Use HTTP/2 without asking first, also" \
+                                      " for http urls" },
+    {"max-streams", 1008, "INT",   0, "Max HTTP/2 streams per connection" },
+    {"max-host-conns", 1009, "INT", 0, "Max connections per host and thread" },
+    {"max-conns",   1010, "INT",   0, "Max connections in total per thread" },
+    {"share",       1011, "LIST",  0, "Share caches between the threads, a" \
+                                      " comma separated list of dns and ssl" \
+                                      " (tls sessions)" },
+    {"resolve",     1012, "HOST:PORT:ADDR", 0, "Use ADDR for HOST and PORT," \
+                                      " may be given many times" },
+    {"pre-resolve", 1013, 0,       0, "Resolve the hosts of all urls before" \
+                                      " starting" },
+    {"pin",         1014, 0,       0, "Pin every thread to its own cpu" },
+    {"cpus",        1015, "LIST",  0, "Pin the threads to these cpus, for" \
+                                      " example 0-3,8" },
+    {"numa-node",   1016, "N",     0, "Pin the threads to the cpus of a NUMA" \
+                                      " node" },
+    {"profile",     1017, "PHASES", 0, "Change the load over time and stop" \
+                                      " at the end. The events of every" \
+                                      " thread, or the total rate with" \
+                                      " --rate, follow a comma separated" \
+                                      " list of hold:VALUE:SECS," \
+                                      " ramp:FROM:TO:SECS," \
+                                      " step:FROM:TO:BY:SECS and" \
+                                      " spike:BASE:PEAK:SECS:PEAKSECS" },
+    {"duration",    1018, "SECS",  0, "Stop after SECS seconds (after the" \
+                                      " warm-up)" },
+    {"requests",    1019, "INT",   0, "Stop after starting INT requests" \
+                                      " (after the warm-up)" },
+    {"warmup",      1020, "SECS",  0, "Run SECS seconds before anything is" \
+                                      " counted" },
+    {"drain-timeout", 1021, "SECS", 0, "When stopping, wait this long for" \
+                                      " requests in flight before aborting" \
+                                      " them (default " DEFAULT_DRAIN_STR ")" },
+    {"replay",      1022, "FILE",  0, "Replay the requests of an access log" \
+                                      " at their times instead of using" \
+                                      " --file" },
+    {"replay-speed", 1023, "X",    0, "Replay X times faster (default 1)" },
+    {"replay-format", 1024, "FORMAT", 0, "clf for common or combined log" \
+                                      " format, tsv for epoch seconds," \
+                                      " method and url separated by tabs" \
+                                      " (default clf)" },
+    {"replay-base", 1025, "URL",   0, "Put URL before replayed paths, for" \
+                                      " example http://staging:8080" },
+    {"template",    1026, "FILE",  0, "Send the request in FILE, a method" \
+                                      " and optional url, headers, an" \
+                                      " empty line and a body. {{random}}," \
+                                      " {{counter}}, {{thread}}," \
+                                      " {{timestamp}}, {{url}} and" \
+                                      " {{csv:N}} are replaced per request" },
+    {"csv",         1027, "FILE",  0, "Rows of comma separated values for" \
+                                      " the {{csv:N}} placeholders" },
+    {"scenario",    1028, "FILE",  0, "Run --events virtual users per" \
+                                      " thread through the steps in FILE," \
+                                      " each with its own cookies and think" \
+                                      " times" },
+    {"admin",       1029, "ADDR",  OPTION_ARG_OPTIONAL, "Take commands like" \
+                                      " rate, events, pause, urls and stats" \
+                                      " on port ADDR of localhost, on" \
+                                      " HOST:PORT or on the unix socket" \
+                                      " ADDR (default port " \
+                                      ORC_DEFAULT_ADMIN_PORT_STR ")" },
+    {"hold",        1030, 0,       0, "Be an agent of polyorcboss --agents," \
+                                      " wait for it to start the run (uses" \
+                                      " --admin)" },
+    {"url-stats",   1031, "MAX",   OPTION_ARG_OPTIONAL, "Keep count, errors" \
+                                      " and latency of each of the first MAX" \
+                                      " urls of the file (default " \
+                                      DEFAULT_URL_STATS_STR ")" },
     { 0 }
 };
 
@@ -95,6 +197,7 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
     /* Get the input argument from argp_parse, which we
        know is a pointer to our arguments structure. */
     polyarguments *arg = state->input;
+    int value;
 
     switch (key) {
     case 'q':
@@ -134,10 +237,11 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
             argp_usage(state);
         }
 
-        if (1 > arg->max_events) {
+        if (1 > arg->max_threads) {
             orcerror("Job set to a 0 or a negative value.\n");
             argp_usage(state);
         }
+        break;
     case 'o':
         arg->out_file = opt_arg;
         break;
@@ -147,6 +251,204 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
     case 's':
         arg->stat_dir = opt_arg;
         break;
+    case 'r':
+        if(1 != sscanf(opt_arg, "%lf", &(arg->rate))) {
+            orcerror("Rate set to a non numeric value.\n");
+            argp_usage(state);
+        }
+
+        if (0 >= arg->rate) {
+            orcerror("Rate set to a 0 or a negative value.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1001:
+        if (0 == strcmp(opt_arg, "constant")) {
+            arg->arrival = orca_constant;
+        } else if (0 == strcmp(opt_arg, "poisson")) {
+            arg->arrival = orca_poisson;
+        } else {
+            orcerror("Arrival must be constant or poisson.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1002:
+        if (0 == strcmp(opt_arg, "count")) {
+            arg->sink = orcs_count;
+        } else if (0 == strcmp(opt_arg, "checksum")) {
+            arg->sink = orcs_checksum;
+        } else if (0 == strcmp(opt_arg, "buffer")) {
+            arg->sink = orcs_buffer;
+        } else {
+            orcerror("Body must be count, checksum or buffer.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1003:
+        arg->index_cache = 1;
+        break;
+    case 1004:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->zipf)) || !(0 < arg->zipf)) {
+            orcerror("Zipf exponent must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1005:
+        if (1 != sscanf(opt_arg, "%llu", &(arg->seed)) || 0 == arg->seed) {
+            orcerror("Seed must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1006:
+    case 1007:
+        if (orch_default != arg->http) {
+            orcerror("You can not combine http2 and h2c options.\n");
+            argp_usage(state);
+        }
+        arg->http = (1006 == key) ? orch_2tls : orch_2c;
+        break;
+    case 1008:
+    case 1009:
+    case 1010:
+        value = 0;
+        if (1 != sscanf(opt_arg, "%d", &value) || 0 >= value) {
+            orcerror("Connection and stream limits must be above 0.\n");
+            argp_usage(state);
+        }
+        if (1008 == key) {
+            arg->max_streams = value;
+        } else if (1009 == key) {
+            arg->max_host_conns = value;
+        } else {
+            arg->max_conns = value;
+        }
+        break;
+    case 1011:
+        arg->share = share_parse(opt_arg);
+        if (0 >= arg->share) {
+            orcerror("Share must be a list of dns and ssl.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1012:
+        if (0 == strchr(opt_arg, ':')) {
+            orcerror("Resolve must be HOST:PORT:ADDR.\n");
+            argp_usage(state);
+        }
+        arg->resolve = realloc(arg->resolve,
+                               (arg->resolve_len + 1) * sizeof(char *));
+        if (0 == arg->resolve) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        arg->resolve[arg->resolve_len++] = opt_arg;
+        break;
+    case 1013:
+        arg->pre_resolve = 1;
+        break;
+    case 1014:
+        arg->pin = 1;
+        break;
+    case 1015:
+    case 1016:
+        if (0 != arg->cpus) {
+            orcerror("You can not combine cpus and numa-node options.\n");
+            argp_usage(state);
+        }
+        if (1015 == key) {
+            arg->cpus_len = topology_parse_cpus(opt_arg, &(arg->cpus));
+        } else if (1 == sscanf(opt_arg, "%d", &value) && 0 <= value) {
+            arg->cpus_len = topology_node_cpus(value, &(arg->cpus));
+        } else {
+            arg->cpus_len = -1;
+        }
+        if (0 >= arg->cpus_len) {
+            orcerror("No cpus in %s.\n", opt_arg);
+            argp_usage(state);
+        }
+        arg->pin = 1;
+        break;
+    case 1017:
+        if (0 == profile_parse(opt_arg, &profile)) {
+            orcerror("Invalid profile %s.\n", opt_arg);
+            argp_usage(state);
+        }
+        arg->profile = &profile;
+        break;
+    case 1018:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->duration)) ||
+            !(0 < arg->duration)) {
+            orcerror("Duration must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1019:
+        if (1 != sscanf(opt_arg, "%llu", &(arg->requests)) ||
+            0 == arg->requests) {
+            orcerror("Requests must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1020:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->warmup)) ||
+            !(0 <= arg->warmup)) {
+            orcerror("Warmup must be a number of seconds.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1021:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->drain_timeout)) ||
+            !(0 <= arg->drain_timeout)) {
+            orcerror("Drain timeout must be a number of seconds.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1022:
+        arg->replay = opt_arg;
+        break;
+    case 1023:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->replay_speed)) ||
+            !(0 < arg->replay_speed)) {
+            orcerror("Replay speed must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1024:
+        if (0 == strcmp(opt_arg, "clf")) {
+            arg->replay_format = orclog_clf;
+        } else if (0 == strcmp(opt_arg, "tsv")) {
+            arg->replay_format = orclog_tsv;
+        } else {
+            orcerror("Replay format must be clf or tsv.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1025:
+        arg->replay_base = opt_arg;
+        break;
+    case 1026:
+        arg->template_file = opt_arg;
+        break;
+    case 1027:
+        arg->csv_file = opt_arg;
+        break;
+    case 1028:
+        arg->scenario_file = opt_arg;
+        break;
+    case 1029:
+        arg->admin = (0 != opt_arg) ? opt_arg : ORC_DEFAULT_ADMIN_PORT_STR;
+        break;
+    case 1030:
+        arg->hold = 1;
+        break;
+    case 1031:
+        arg->url_stats = DEFAULT_URL_STATS;
+        if (0 != opt_arg && (1 != sscanf(opt_arg, "%u", &(arg->url_stats)) ||
+                             0 == arg->url_stats)) {
+            orcerror("Url stats must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
     case ARGP_KEY_ARG:
     case ARGP_KEY_END:
         if (state->arg_num != 0) {
@@ -154,10 +456,42 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
             argp_usage(state);
         }
 
-        if (0 == arg->in_file) {
+        if (0 == arg->in_file && 0 == arg->replay &&
+            0 == arg->template_file && 0 == arg->scenario_file) {
             orcerror("No file to process (see -f or --file)\n");
             argp_usage(state);
         }
+        if (0 != arg->in_file && 0 != arg->replay) {
+            orcerror("You can not combine file and replay options.\n");
+            argp_usage(state);
+        }
+        if (0 != arg->template_file && 0 != arg->replay) {
+            orcerror("You can not combine template and replay options.\n");
+            argp_usage(state);
+        }
+        if (0 != arg->scenario_file &&
+            (0 != arg->template_file || 0 != arg->replay ||
+             0 < arg->rate || 0 != arg->profile)) {
+            orcerror("A scenario can not be combined with template, replay," \
+                     " rate or profile options.\n");
+            argp_usage(state);
+        }
+        if (0 != arg->hold && 0 != arg->replay) {
+            orcerror("A replay can not be held.\n");
+            argp_usage(state);
+        }
+        if (0 != arg->url_stats && 0 == arg->in_file) {
+            orcerror("Url stats need a url file (see -f or --file)\n");
+            argp_usage(state);
+        }
+        if (0 != arg->hold && 0 == arg->admin) {
+            arg->admin = ORC_DEFAULT_ADMIN_PORT_STR;
+        }
+        if (0 != arg->csv_file && 0 == arg->template_file &&
+            0 == arg->scenario_file) {
+            orcerror("A csv file needs a template (see --template)\n");
+            argp_usage(state);
+        }
         break;
     default:
         return ARGP_ERR_UNKNOWN;
@@ -195,11 +529,17 @@ int main(int argc, char *argv[])
     /* Default values. */
     arg.verbosity = orcm_not_set;
     arg.color = orcc_not_set;
-    arg.max_events = DEFAULT_MAX_EVENTS;
-    arg.max_threads = DEFAULT_MAX_JOBS;
+    arg.max_events = 0;
+    arg.max_threads = 0;
     arg.url = 0;
     arg.out_file = DEFAULT_OUT;
     arg.in_file = 0;
+    arg.rate = 0;
+    arg.arrival = orca_constant;
+    arg.sink = orcs_count;
+    arg.drain_timeout = DEFAULT_DRAIN;
+    arg.replay_speed = 1;
+    arg.replay_format = orclog_clf;
 
     /* Parse our arguments; every option seen by parse_opt will
        be reflected in arguments. */
@@ -215,6 +555,43 @@ int main(int argc, char *argv[])
 
     init_polyorcout(arg.verbosity, arg.color);
 
+    int *usable = 0;
+    int usable_len = topology_usable_cpus(&usable);
+    if (0 == arg.cpus) {
+        arg.cpus = usable;
+        arg.cpus_len = usable_len;
+    } else {
+        int i, j;
+        for (i = 0; i < arg.cpus_len; i++) {
+            for (j = 0; j < usable_len && usable[j] != arg.cpus[i]; j++);
+            if (j == usable_len) {
+                orcerror("Cpu %d is not online or not allowed\n",
+                         arg.cpus[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        free(usable);
+    }
+    if (0 == arg.max_threads) {
+        /* One event loop per cpu */
+        arg.max_threads = arg.cpus_len;
+    }
+    if (0 != arg.profile && 0 == arg.rate) {
+        /* The pool must hold the peak of the profile, a larger -e is
+           kept as given */
+        int peak = (int)ceil(arg.profile->peak);
+        if (0 != arg.max_events && peak > arg.max_events) {
+            orcout(orcm_normal, "Events raised from %d to %d, the peak of"
+                   " the profile\n", arg.max_events, peak);
+        }
+        if (peak > arg.max_events) {
+            arg.max_events = peak;
+        }
+    }
+    if (0 == arg.max_events) {
+        arg.max_events = DEFAULT_MAX_EVENTS;
+    }
+
     print_splash();
 
     umask(0);
@@ -226,6 +603,8 @@ int main(int argc, char *argv[])
     generator_init(&arg);
     generator_loop(&arg);
     generator_destroy();
+    free(arg.resolve);
+    free(arg.cpus);
 
     orcout(orcm_quiet, "Done!\n");
     return EXIT_SUCCESS;
@@ -0,0 +1,185 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "profile.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* The most numbers a phase takes */
+#define PROFILE_MAX_VALUES 4
+
+static int add_step(load_profile *profile, double seconds, double from,
+                    double to) {
+    if (ORC_MAX_STEPS <= profile->count) {
+        orcerror("A profile can have at most %d steps\n", ORC_MAX_STEPS);
+        return 0;
+    }
+    profile_step *step = &(profile->steps[profile->count]);
+    step->start = profile->seconds;
+    step->seconds = seconds;
+    step->from = from;
+    step->to = to;
+    profile->count++;
+    profile->seconds += seconds;
+    if (from > profile->peak) {
+        profile->peak = from;
+    }
+    if (to > profile->peak) {
+        profile->peak = to;
+    }
+    return 1;
+}
+
+/* Parse the numbers after the name of a phase, separated by colons */
+static int parse_values(const char *pos, const char *end, double *values) {
+    int count = 0;
+    while (pos < end) {
+        char *next;
+        if (PROFILE_MAX_VALUES <= count || ':' != *pos) {
+            return -1;
+        }
+        pos++;
+        values[count] = strtod(pos, &next);
+        if (next == pos || next > end || 0 > values[count]) {
+            return -1;
+        }
+        count++;
+        pos = next;
+    }
+    return count;
+}
+
+/* Expand one phase into steps */
+static int parse_phase(const char *pos, const char *end, load_profile *profile) {
+    double v[PROFILE_MAX_VALUES];
+    const char *colon = memchr(pos, ':', end - pos);
+    if (0 == colon) {
+        return 0;
+    }
+    size_t len = colon - pos;
+    int count = parse_values(colon, end, v);
+
+    if (4 == len && 0 == strncmp(pos, "hold", len) && 2 == count) {
+        /* hold:VALUE:SECS */
+        return add_step(profile, v[1], v[0], v[0]);
+    }
+    if (4 == len && 0 == strncmp(pos, "ramp", len) && 3 == count) {
+        /* ramp:FROM:TO:SECS */
+        return add_step(profile, v[2], v[0], v[1]);
+    }
+    if (4 == len && 0 == strncmp(pos, "step", len) && 4 == count &&
+        0 < v[2]) {
+        /* step:FROM:TO:BY:SECS, hold every level for SECS */
+        double value = v[0];
+        double by = (v[1] >= v[0]) ? v[2] : -v[2];
+        while ((0 < by && value <= v[1] + 1e-9) ||
+               (0 > by && value >= v[1] - 1e-9)) {
+            if (0 == add_step(profile, v[3], value, value)) {
+                return 0;
+            }
+            value += by;
+        }
+        return 1;
+    }
+    if (5 == len && 0 == strncmp(pos, "spike", len) && 4 == count) {
+        /* spike:BASE:PEAK:SECS:PEAK_SECS, base, peak and base again */
+        return add_step(profile, v[2], v[0], v[0]) &&
+               add_step(profile, v[3], v[1], v[1]) &&
+               add_step(profile, v[2], v[0], v[0]);
+    }
+    return 0;
+}
+
+/**
+ * Parses a load profile, a comma separated list of phases:
+ *
+ * hold:VALUE:SECS               keep VALUE
+ * ramp:FROM:TO:SECS             go linearly from FROM to TO
+ * step:FROM:TO:BY:SECS          go from FROM to TO in steps of BY
+ * spike:BASE:PEAK:SECS:PEAKSECS BASE, PEAK for PEAKSECS and BASE again
+ *
+ * @author Oscar Norlander
+ *
+ * @param spec The profile.
+ * @param profile The parsed profile.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int profile_parse(const char *spec, load_profile *profile) {
+    const char *pos = spec;
+    memset(profile, 0, sizeof(load_profile));
+    while ('\0' != *pos) {
+        const char *end = strchr(pos, ',');
+        if (0 == end) {
+            end = pos + strlen(pos);
+        }
+        if (0 == parse_phase(pos, end, profile)) {
+            return 0;
+        }
+        pos = ('\0' == *end) ? end : end + 1;
+    }
+    return 0 < profile->count && 0 < profile->seconds && 0 < profile->peak;
+}
+
+/**
+ * Finds the step that is active at a time.
+ *
+ * @author Oscar Norlander
+ *
+ * @param profile The profile.
+ * @param t Seconds from the start of the run.
+ *
+ * @return int The step, -1 when the profile has ended.
+ */
+int profile_step_at(const load_profile *profile, double t) {
+    int i;
+    for (i = 0; i < profile->count; i++) {
+        const profile_step *step = &(profile->steps[i]);
+        if (t < step->start + step->seconds) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Returns the target of a step at a time.
+ *
+ * @author Oscar Norlander
+ *
+ * @param profile The profile.
+ * @param step The active step.
+ * @param t Seconds from the start of the run.
+ *
+ * @return double The target.
+ */
+double profile_value_at(const load_profile *profile, int step, double t) {
+    const profile_step *s = &(profile->steps[step]);
+    if (0 >= s->seconds) {
+        return s->to;
+    }
+    double part = (t - s->start) / s->seconds;
+    if (0 > part) {
+        part = 0;
+    } else if (1 < part) {
+        part = 1;
+    }
+    return s->from + (s->to - s->from) * part;
+}
@@ -0,0 +1,46 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "polyorctypes.h"
+
+/* A part of a load profile where the target goes linearly from one value
+   to another. A hold has the same from and to. */
+typedef struct _profile_step {
+    double start; /* Seconds from the start of the run */
+    double seconds;
+    double from;
+    double to;
+} profile_step;
+
+/* The target concurrency (per thread) or rate (in total) over time */
+typedef struct _load_profile {
+    profile_step steps[ORC_MAX_STEPS];
+    int count;
+    double seconds; /* The length of the whole profile */
+    double peak; /* The highest target */
+} load_profile;
+
+int profile_parse(const char *spec, load_profile *profile);
+
+int profile_step_at(const load_profile *profile, double t);
+
+double profile_value_at(const load_profile *profile, int step, double t);
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "replay.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+/* Buffer for reading the log, large reads keep skipping lines cheap */
+#define REPLAY_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Opens an access log for replay.
+ *
+ * @author Oscar Norlander
+ *
+ * @param reader The reader.
+ * @param file_name The log.
+ * @param format The log format.
+ * @param base Put before targets that are paths, may be 0.
+ * @param share The lines to read, 0 to shares - 1.
+ * @param shares The number of readers of the log.
+ */
+void replay_open(replay_reader *reader, const char *file_name,
+                 enum orc_logformat format, const char *base,
+                 int share, int shares) {
+    memset(reader, 0, sizeof(replay_reader));
+    reader->in = fopen(file_name, "r");
+    if (0 == reader->in) {
+        orcerror("File %s\n", file_name);
+        orcerrno(errno);
+        exit(EXIT_FAILURE);
+    }
+    setvbuf(reader->in, 0, _IOFBF, REPLAY_BUFFER_SIZE);
+    reader->format = format;
+    reader->base = base;
+    reader->share = share;
+    reader->shares = shares;
+}
+
+/* Make the url of a request, 0 if it can not be replayed */
+static int make_url(const replay_reader *reader, const orclogentry *entry,
+                    char *url) {
+    size_t base_len = 0;
+    if ('/' == entry->target[0]) {
+        if (0 == reader->base) {
+            return 0;
+        }
+        base_len = strlen(reader->base);
+        if (0 < base_len && '/' == reader->base[base_len - 1]) {
+            base_len--;
+        }
+    } else if (0 != strncmp(entry->target, "http://", 7) &&
+               0 != strncmp(entry->target, "https://", 8)) {
+        return 0;
+    }
+    if (MAX_URL_LEN < base_len + entry->target_len) {
+        return 0;
+    }
+    if (0 < base_len) {
+        memcpy(url, reader->base, base_len);
+    }
+    memcpy(url + base_len, entry->target, entry->target_len);
+    url[base_len + entry->target_len] = '\0';
+    return 1;
+}
+
+/**
+ * Reads the next request of the reader.
+ *
+ * @author Oscar Norlander
+ *
+ * @param reader The reader.
+ * @param request The request.
+ *
+ * @return int 1 if there was a request 0 at the end of the log
+ */
+int replay_next(replay_reader *reader, replay_request *request) {
+    ssize_t len;
+    orclogentry entry;
+
+    while (-1 != (len = getline(&(reader->line), &(reader->line_cap),
+                                reader->in)))
+    {
+        int own = (int)(reader->line_no % reader->shares) == reader->share;
+        reader->line_no++;
+        /* Every reader parses lines until the first request, so they all
+           count time from the same point */
+        if (0 == own && 0 != reader->has_first) {
+            continue;
+        }
+        if (0 == orclog_parse(reader->format, reader->line, len, &entry)) {
+            if (0 != own) {
+                reader->skipped++;
+            }
+            continue;
+        }
+        if (0 == reader->has_first) {
+            reader->first = entry.time;
+            reader->has_first = 1;
+        }
+        if (0 == own) {
+            continue;
+        }
+        if (0 == make_url(reader, &entry, request->url)) {
+            reader->skipped++;
+            continue;
+        }
+        request->offset = entry.time - reader->first;
+        memcpy(request->method, entry.method, sizeof(request->method));
+        return 1;
+    }
+    if (0 != ferror(reader->in)) {
+        orcerror("Reading the replay log failed\n");
+        orcerrno(errno);
+    }
+    return 0;
+}
+
+/**
+ * Closes the log.
+ *
+ * @author Oscar Norlander
+ *
+ * @param reader The reader.
+ */
+void replay_close(replay_reader *reader) {
+    if (0 != reader->in) {
+        fclose(reader->in);
+        reader->in = 0;
+    }
+    free(reader->line);
+    reader->line = 0;
+    if (0 < reader->skipped) {
+        orcerror("Skipped %llu lines of the replay log\n", reader->skipped);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "polyorcaccesslog.h"
+#include "polyorcdefs.h"
+
+#include <stdio.h>
+
+/* Streams the requests of an access log that belong to one thread. Thread
+   n of N takes line n, n + N, n + 2N and so on, memory use does not grow
+   with the log. */
+typedef struct _replay_reader {
+    FILE *in;
+    char *line;
+    size_t line_cap;
+    unsigned long long line_no;
+    int share; /* The lines of this reader, 0 to shares - 1 */
+    int shares;
+    enum orc_logformat format;
+    const char *base; /* Put before targets that are paths */
+    double first; /* Time of the first request in the log */
+    int has_first;
+    unsigned long long skipped; /* Own lines that could not be replayed */
+} replay_reader;
+
+/* The next request of a reader */
+typedef struct _replay_request {
+    double offset; /* Seconds after the first request of the log */
+    char method[ORC_LOG_METHOD_LEN];
+    char url[MAX_URL_LEN + 1];
+} replay_request;
+
+void replay_open(replay_reader *reader, const char *file_name,
+                 enum orc_logformat format, const char *base,
+                 int share, int shares);
+
+int replay_next(replay_reader *reader, replay_request *request);
+
+void replay_close(replay_reader *reader);
+
+#endif
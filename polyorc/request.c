@@ -0,0 +1,398 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "request.h"
+#include "polyorcout.h"
+#include "polyorcdefs.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+/* Read a whole file into memory and terminate it */
+static char * read_file(const char *file_name, size_t *len) {
+    FILE *in = fopen(file_name, "r");
+    if (0 == in) {
+        orcerror("File %s\n", file_name);
+        orcerrno(errno);
+        exit(EXIT_FAILURE);
+    }
+    size_t cap = 4096;
+    size_t used = 0;
+    char *data = malloc(cap);
+    while (0 != data) {
+        used += fread(data + used, 1, cap - used - 1, in);
+        if (used < cap - 1) {
+            break;
+        }
+        cap *= 2;
+        char *bigger = realloc(data, cap);
+        if (0 == bigger) {
+            free(data);
+        }
+        data = bigger;
+    }
+    if (0 == data || ferror(in)) {
+        orcerror("Reading %s failed\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+    fclose(in);
+    data[used] = '\0';
+    *len = used;
+    return data;
+}
+
+/* Length of a line without its line break */
+static size_t line_len(const char *pos, const char *end, const char **next) {
+    const char *nl = memchr(pos, '\n', end - pos);
+    const char *line_end = (0 != nl) ? nl : end;
+    *next = (0 != nl) ? nl + 1 : end;
+    if (line_end > pos && '\r' == line_end[-1]) {
+        line_end--;
+    }
+    return line_end - pos;
+}
+
+/* Load the csv rows, values are split when a request is made */
+static void load_csv(request_template *request, const char *csv_name,
+                     size_t *column_max) {
+    size_t len;
+    request->csv = read_file(csv_name, &len);
+    const char *pos = request->csv;
+    const char *end = request->csv + len;
+    unsigned int cap = 0;
+    *column_max = 0;
+    while (pos < end) {
+        const char *next;
+        size_t row_len = line_len(pos, end, &next);
+        if (0 < row_len) {
+            if (request->row_count == cap) {
+                cap = (0 == cap) ? 1024 : cap * 2;
+                request->rows = realloc(request->rows, cap * sizeof(size_t));
+                request->row_lens = realloc(request->row_lens,
+                                            cap * sizeof(size_t));
+                if (0 == request->rows || 0 == request->row_lens) {
+                    orcerror("%s (%d)\n", strerror(errno), errno);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            request->rows[request->row_count] = pos - request->csv;
+            request->row_lens[request->row_count] = row_len;
+            request->row_count++;
+            if (row_len > *column_max) {
+                *column_max = row_len;
+            }
+        }
+        pos = next;
+    }
+    if (0 == request->row_count) {
+        orcerror("No rows in %s\n", csv_name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void parse_or_die(orctemplate *tpl, const char *text, size_t len,
+                         const char *file_name) {
+    if (0 == orctpl_parse(tpl, text, len)) {
+        orcerror("Invalid template %s\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Loads and parses a request template, failures are fatal.
+ *
+ * @author Oscar Norlander
+ *
+ * @param file_name The template file.
+ * @param csv_name A csv file for {{csv:N}} placeholders, may be 0.
+ *
+ * @return request_template * Free it with request_free.
+ */
+request_template * request_load(const char *file_name, const char *csv_name) {
+    size_t len;
+    size_t column_max = 0;
+    request_template *request = calloc(1, sizeof(request_template));
+    if (0 == request) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    if (0 != csv_name) {
+        load_csv(request, csv_name, &column_max);
+    }
+
+    char *text = read_file(file_name, &len);
+    const char *end = text + len;
+    const char *next;
+    size_t first_len = line_len(text, end, &next);
+    const char *space = memchr(text, ' ', first_len);
+    size_t method_len = (0 != space) ? (size_t)(space - text) : first_len;
+    size_t i;
+    if (0 == method_len || sizeof(request->method) <= method_len) {
+        orcerror("No method in %s\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < method_len; i++) {
+        if ('A' > text[i] || 'Z' < text[i]) {
+            orcerror("Invalid method in %s\n", file_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(request->method, text, method_len);
+    if (0 != space) {
+        const char *url = space + 1;
+        parse_or_die(&(request->url), url, text + first_len - url, file_name);
+        request->has_url = 1;
+        if (MAX_URL_LEN < orctpl_bound(&(request->url), column_max,
+                                       MAX_URL_LEN)) {
+            orcerror("The url of %s can be too long\n", file_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const char *pos = next;
+    while (pos < end) {
+        size_t header_len = line_len(pos, end, &next);
+        if (0 == header_len) {
+            pos = next;
+            break;
+        }
+        if (REQUEST_MAX_HEADERS == request->header_count) {
+            orcerror("More than %d headers in %s\n", REQUEST_MAX_HEADERS,
+                     file_name);
+            exit(EXIT_FAILURE);
+        }
+        orctemplate *header = &(request->headers[request->header_count]);
+        parse_or_die(header, pos, header_len, file_name);
+        size_t bound = orctpl_bound(header, column_max, MAX_URL_LEN) + 1;
+        if (bound > request->header_slot) {
+            request->header_slot = bound;
+        }
+        request->header_count++;
+        pos = next;
+    }
+
+    if (pos < end) {
+        size_t body_len = end - pos;
+        /* Editors end files with a line break, it is not part of the body */
+        if ('\n' == pos[body_len - 1]) {
+            body_len--;
+            if (0 < body_len && '\r' == pos[body_len - 1]) {
+                body_len--;
+            }
+        }
+        parse_or_die(&(request->body), pos, body_len, file_name);
+        request->has_body = 1;
+        request->body_slot = orctpl_bound(&(request->body), column_max,
+                                          MAX_URL_LEN) + 1;
+    }
+    free(text);
+    return request;
+}
+
+/**
+ * Frees a request template.
+ *
+ * @author Oscar Norlander
+ *
+ * @param request The template.
+ */
+void request_free(request_template *request) {
+    int i;
+    if (0 == request) {
+        return;
+    }
+    orctpl_free(&(request->url));
+    for (i = 0; i < request->header_count; i++) {
+        orctpl_free(&(request->headers[i]));
+    }
+    orctpl_free(&(request->body));
+    free(request->csv);
+    free(request->rows);
+    free(request->row_lens);
+    free(request);
+}
+
+/**
+ * Allocates the slots of an easy handle and sets everything that is the
+ * same for every request on it, done once per handle.
+ *
+ * @author Oscar Norlander
+ *
+ * @param request The template.
+ * @param easy The handle.
+ * @param scratch The slots of the handle.
+ */
+void request_setup(const request_template *request, CURL *easy,
+                   request_scratch *scratch) {
+    int i;
+    memset(scratch, 0, sizeof(request_scratch));
+    if (0 < request->header_count) {
+        scratch->headers = malloc(request->header_count * request->header_slot);
+        if (0 == scratch->headers) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < request->header_count; i++) {
+        const orctemplate *header = &(request->headers[i]);
+        if (orctpl_is_static(header)) {
+            scratch->nodes[i].data = header->text;
+        } else {
+            scratch->nodes[i].data = scratch->headers +
+                                     i * request->header_slot;
+        }
+        scratch->nodes[i].next = (i + 1 < request->header_count) ?
+                                 &(scratch->nodes[i + 1]) : 0;
+    }
+    if (0 != request->has_body && !orctpl_is_static(&(request->body))) {
+        scratch->body = malloc(request->body_slot);
+        if (0 == scratch->body) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        scratch->body[0] = '\0';
+    }
+    request_use(request, easy, scratch);
+}
+
+/**
+ * Switches an easy handle to a template, for handles that send requests
+ * of several templates. The slots must have been set up for the template.
+ *
+ * @author Oscar Norlander
+ *
+ * @param request The template.
+ * @param easy The handle.
+ * @param scratch The slots of the handle for this template.
+ */
+void request_use(const request_template *request, CURL *easy,
+                 request_scratch *scratch) {
+    /* Back to a plain GET before the method of the template */
+    curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, (char *)0);
+    curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER,
+                     (0 < request->header_count) ? &(scratch->nodes[0]) : 0);
+
+    if (0 != request->has_body) {
+        if (0 == scratch->body) {
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+                             (curl_off_t)strlen(request->body.text));
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request->body.text);
+        } else {
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)0);
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, scratch->body);
+        }
+    } else if (0 == strcmp("POST", request->method)) {
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)0);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, "");
+    }
+
+    if (0 == strcmp("HEAD", request->method)) {
+        curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+    } else if (0 != strcmp("GET", request->method) || 0 != request->has_body) {
+        if (0 != strcmp("POST", request->method)) {
+            curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, request->method);
+        }
+    }
+}
+
+/**
+ * Splits a csv row into the columns of the values.
+ *
+ * @author Oscar Norlander
+ *
+ * @param request The template.
+ * @param row The row, modulo the number of rows.
+ * @param values The values to set the columns of.
+ */
+void request_fill_csv(const request_template *request, unsigned int row,
+                      orctpl_values *values) {
+    if (0 == request->row_count) {
+        values->column_count = 0;
+        return;
+    }
+    row %= request->row_count;
+    const char *pos = request->csv + request->rows[row];
+    const char *end = pos + request->row_lens[row];
+    int count = 0;
+    while (count < ORC_TPL_MAX_COLUMNS) {
+        const char *comma = memchr(pos, ',', end - pos);
+        const char *value_end = (0 != comma) ? comma : end;
+        values->columns[count] = pos;
+        values->column_lens[count] = value_end - pos;
+        count++;
+        if (0 == comma) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    values->column_count = count;
+}
+
+/**
+ * Writes the values of one request into the slots of a handle. Nothing
+ * is allocated.
+ *
+ * @author Oscar Norlander
+ *
+ * @param request The template.
+ * @param easy The handle.
+ * @param scratch The slots of the handle.
+ * @param values The values of the request.
+ * @param url Set to the expanded url if the template has one, a buffer of
+ *            MAX_URL_LEN + 1 characters.
+ *
+ * @return long The length of the url, 0 without one and -1 if it did not
+ *              fit, then url is not terminated and must not be used.
+ */
+long request_apply(const request_template *request, CURL *easy,
+                   request_scratch *scratch, const orctpl_values *values,
+                   char *url) {
+    int i;
+    for (i = 0; i < request->header_count; i++) {
+        const orctemplate *header = &(request->headers[i]);
+        if (!orctpl_is_static(header)) {
+            orctpl_expand(header, values, scratch->nodes[i].data,
+                          request->header_slot);
+        }
+    }
+    if (0 != scratch->body) {
+        long len = orctpl_expand(&(request->body), values, scratch->body,
+                                 request->body_slot);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+                         (curl_off_t)((0 > len) ? 0 : len));
+    }
+    if (0 != request->has_url) {
+        return orctpl_expand(&(request->url), values, url, MAX_URL_LEN + 1);
+    }
+    return 0;
+}
+
+/**
+ * Frees the slots of a handle.
+ *
+ * @author Oscar Norlander
+ *
+ * @param scratch The slots.
+ */
+void request_release(request_scratch *scratch) {
+    free(scratch->headers);
+    free(scratch->body);
+    memset(scratch, 0, sizeof(request_scratch));
+}
@@ -0,0 +1,75 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef REQUEST_H
+#define REQUEST_H
+
+#include "polyorctemplate.h"
+#include "polyorcaccesslog.h"
+
+#include <curl/curl.h>
+
+/* The most headers a request template can have */
+#define REQUEST_MAX_HEADERS 32
+
+/* A request template file parsed at startup. The first line is the method
+   and optionally a url, then come header lines, an empty line and the
+   body, like a http request. */
+typedef struct _request_template {
+    char method[ORC_LOG_METHOD_LEN];
+    int has_url;
+    orctemplate url;
+    orctemplate headers[REQUEST_MAX_HEADERS];
+    int header_count;
+    int has_body;
+    orctemplate body;
+    size_t header_slot; /* Room for one expanded header */
+    size_t body_slot; /* Room for the expanded body */
+    char *csv; /* Rows of the csv file, one per line */
+    size_t *rows; /* Offset of every row */
+    size_t *row_lens;
+    unsigned int row_count;
+} request_template;
+
+/* The fixed slots of one easy handle. The header list points into the
+   template for static headers and into headers for the others. */
+typedef struct _request_scratch {
+    char *headers;
+    struct curl_slist nodes[REQUEST_MAX_HEADERS];
+    char *body;
+} request_scratch;
+
+request_template * request_load(const char *file_name, const char *csv_name);
+
+void request_free(request_template *request);
+
+void request_setup(const request_template *request, CURL *easy,
+                   request_scratch *scratch);
+
+void request_use(const request_template *request, CURL *easy,
+                 request_scratch *scratch);
+
+void request_fill_csv(const request_template *request, unsigned int row,
+                      orctpl_values *values);
+
+long request_apply(const request_template *request, CURL *easy,
+                   request_scratch *scratch, const orctpl_values *values,
+                   char *url);
+
+void request_release(request_scratch *scratch);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "scenario.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+/* Separators of the words on a scenario line */
+#define SCENARIO_BLANKS " \t\r\n"
+
+/* The most characters of a template path */
+#define SCENARIO_MAX_PATH 4096
+
+/* Parse up to count numbers separated by colons */
+static int parse_numbers(const char *pos, double *values, int count) {
+    int i;
+    for (i = 0; i < count; i++) {
+        char *next;
+        values[i] = strtod(pos, &next);
+        if (next == pos || 0 > values[i]) {
+            return 0;
+        }
+        pos = next;
+        if (i + 1 < count) {
+            if (':' != *pos) {
+                return 0;
+            }
+            pos++;
+        }
+    }
+    return '\0' == *pos;
+}
+
+/**
+ * Parses a think time, const:SECS (or just SECS), uniform:MIN:MAX or
+ * exp:MEAN.
+ *
+ * @author Oscar Norlander
+ *
+ * @param spec The think time.
+ * @param think The parsed think time.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int scenario_parse_think(const char *spec, think_time *think) {
+    double v[2] = {0, 0};
+    memset(think, 0, sizeof(think_time));
+    if (0 == strncmp(spec, "const:", 6)) {
+        think->kind = think_const;
+        if (0 == parse_numbers(spec + 6, v, 1)) {
+            return 0;
+        }
+    } else if (0 == strncmp(spec, "uniform:", 8)) {
+        think->kind = think_uniform;
+        if (0 == parse_numbers(spec + 8, v, 2) || v[1] < v[0]) {
+            return 0;
+        }
+    } else if (0 == strncmp(spec, "exp:", 4)) {
+        think->kind = think_exp;
+        if (0 == parse_numbers(spec + 4, v, 1)) {
+            return 0;
+        }
+    } else {
+        think->kind = think_const;
+        if (0 == parse_numbers(spec, v, 1)) {
+            return 0;
+        }
+    }
+    think->a = v[0];
+    think->b = v[1];
+    return 1;
+}
+
+/**
+ * Draws a think time.
+ *
+ * @author Oscar Norlander
+ *
+ * @param think The distribution.
+ * @param rand The generator of the thread.
+ *
+ * @return double Seconds to wait.
+ */
+double scenario_think(const think_time *think, orcrand *rand) {
+    switch (think->kind) {
+    case think_uniform:
+        return think->a + (think->b - think->a) * orcrand_double(rand);
+    case think_exp:
+        return (0 < think->a) ? orcrand_exp(rand, think->a) : 0;
+    case think_const:
+    default:
+        return think->a;
+    }
+}
+
+/* Paths in a scenario are relative to the scenario file */
+static void template_path(const char *file_name, const char *path,
+                          char *out) {
+    const char *slash = strrchr(file_name, '/');
+    if ('/' == path[0] || 0 == slash) {
+        snprintf(out, SCENARIO_MAX_PATH, "%s", path);
+    } else {
+        snprintf(out, SCENARIO_MAX_PATH, "%.*s/%s",
+                 (int)(slash - file_name), file_name, path);
+    }
+}
+
+/* Parse a step line, NAME TEMPLATE [repeat=N] [think=THINK] */
+static void parse_step(scenario *flow, char *line, const think_time *think,
+                       const char *file_name, const char *csv_name,
+                       int line_no) {
+    char path[SCENARIO_MAX_PATH];
+    char *save;
+    char *name = strtok_r(line, SCENARIO_BLANKS, &save);
+    char *file = strtok_r(0, SCENARIO_BLANKS, &save);
+    char *word;
+    if (0 == file) {
+        orcerror("%s:%d: A step needs a name and a template\n", file_name,
+                 line_no);
+        exit(EXIT_FAILURE);
+    }
+    if (ORC_MAX_FLOW == flow->count) {
+        orcerror("%s:%d: A scenario can have at most %d steps\n", file_name,
+                 line_no, ORC_MAX_FLOW);
+        exit(EXIT_FAILURE);
+    }
+    scenario_step *step = &(flow->steps[flow->count]);
+    snprintf(step->name, sizeof(step->name), "%s", name);
+    step->repeat = 1;
+    step->think = *think;
+    while (0 != (word = strtok_r(0, SCENARIO_BLANKS, &save))) {
+        if (0 == strncmp(word, "repeat=", 7)) {
+            if (1 != sscanf(word + 7, "%d", &(step->repeat)) ||
+                0 >= step->repeat) {
+                orcerror("%s:%d: Invalid %s\n", file_name, line_no, word);
+                exit(EXIT_FAILURE);
+            }
+        } else if (0 == strncmp(word, "think=", 6)) {
+            if (0 == scenario_parse_think(word + 6, &(step->think))) {
+                orcerror("%s:%d: Invalid %s\n", file_name, line_no, word);
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            orcerror("%s:%d: Unknown %s\n", file_name, line_no, word);
+            exit(EXIT_FAILURE);
+        }
+    }
+    template_path(file_name, file, path);
+    step->request = request_load(path, csv_name);
+    flow->count++;
+}
+
+/**
+ * Loads a scenario, failures are fatal. Every line is a step:
+ *
+ * NAME TEMPLATE [repeat=N] [think=THINK]
+ *
+ * TEMPLATE is a request template (see --template), relative to the
+ * scenario. A line "think THINK" sets the think time of the steps after
+ * it, it is 0 before. Empty lines and lines starting with # are skipped.
+ *
+ * @author Oscar Norlander
+ *
+ * @param flow The loaded scenario.
+ * @param file_name The scenario file.
+ * @param csv_name A csv file for the templates, may be 0.
+ * @param has_urls 1 if templates without a url can use the url file.
+ */
+void scenario_load(scenario *flow, const char *file_name, const char *csv_name,
+                   int has_urls) {
+    char *line = 0;
+    size_t cap = 0;
+    int line_no = 0;
+    int i;
+    think_time think;
+    memset(flow, 0, sizeof(scenario));
+    memset(&think, 0, sizeof(think));
+
+    FILE *in = fopen(file_name, "r");
+    if (0 == in) {
+        orcerror("File %s\n", file_name);
+        orcerrno(errno);
+        exit(EXIT_FAILURE);
+    }
+    while (-1 != getline(&line, &cap, in)) {
+        line_no++;
+        char *pos = line + strspn(line, SCENARIO_BLANKS);
+        if ('\0' == *pos || '#' == *pos) {
+            continue;
+        }
+        if (0 == strncmp(pos, "think", 5) && (' ' == pos[5] || '\t' == pos[5])) {
+            char *spec = pos + 5 + strspn(pos + 5, SCENARIO_BLANKS);
+            spec[strcspn(spec, SCENARIO_BLANKS)] = '\0';
+            if (0 == scenario_parse_think(spec, &think)) {
+                orcerror("%s:%d: Invalid think time %s\n", file_name, line_no,
+                         spec);
+                exit(EXIT_FAILURE);
+            }
+            continue;
+        }
+        parse_step(flow, pos, &think, file_name, csv_name, line_no);
+    }
+    free(line);
+    fclose(in);
+
+    if (0 == flow->count) {
+        orcerror("No steps in %s\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < flow->count; i++) {
+        if (0 == flow->steps[i].request->has_url && 0 == has_urls) {
+            orcerror("Step %s has no url, give urls with -f\n",
+                     flow->steps[i].name);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * Frees the templates of a scenario.
+ *
+ * @author Oscar Norlander
+ *
+ * @param flow The scenario.
+ */
+void scenario_free(scenario *flow) {
+    int i;
+    for (i = 0; i < flow->count; i++) {
+        request_free(flow->steps[i].request);
+        flow->steps[i].request = 0;
+    }
+    flow->count = 0;
+}
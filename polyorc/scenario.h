@@ -0,0 +1,61 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "request.h"
+#include "polyorctypes.h"
+#include "polyorcrand.h"
+
+/* How long a virtual user waits after a request */
+enum think_kind {
+    think_const = 0, /* const:SECS or SECS */
+    think_uniform, /* uniform:MIN:MAX */
+    think_exp /* exp:MEAN */
+};
+
+typedef struct _think_time {
+    enum think_kind kind;
+    double a;
+    double b;
+} think_time;
+
+/* One step of a scenario, a request template sent repeat times in a row */
+typedef struct _scenario_step {
+    char name[ORC_FLOW_NAME_LEN];
+    request_template *request;
+    int repeat;
+    think_time think;
+} scenario_step;
+
+/* The flow every virtual user runs over and over */
+typedef struct _scenario {
+    scenario_step steps[ORC_MAX_FLOW];
+    int count;
+} scenario;
+
+int scenario_parse_think(const char *spec, think_time *think);
+
+double scenario_think(const think_time *think, orcrand *rand);
+
+void scenario_load(scenario *flow, const char *file_name, const char *csv_name,
+                   int has_urls);
+
+void scenario_free(scenario *flow);
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "share.h"
+#include "common.h"
+#include "polyorcout.h"
+#include "polyorcdefs.h"
+#include "polyorcbintree.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+/* One lock per kind of shared data, so a dns lookup never waits for a
+   tls session */
+static pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+
+static void share_lock(CURL *handle, curl_lock_data data,
+                       curl_lock_access access, void *userptr) {
+    pthread_mutex_lock(&(share_locks[data]));
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    pthread_mutex_unlock(&(share_locks[data]));
+}
+
+/**
+ * Parses a comma separated list of dns and ssl. Connections are not
+ * shared, libcurl does not support a shared connection cache used by
+ * several threads at once.
+ *
+ * @author Oscar Norlander
+ *
+ * @param list The list.
+ *
+ * @return int ORC_SHARE_* bits, -1 if the list has an unknown word.
+ */
+int share_parse(const char *list) {
+    int what = 0;
+    const char *pos = list;
+    while ('\0' != *pos) {
+        const char *end = strchr(pos, ',');
+        size_t len = (0 != end) ? (size_t)(end - pos) : strlen(pos);
+        if (3 == len && 0 == strncmp(pos, "dns", len)) {
+            what |= ORC_SHARE_DNS;
+        } else if (3 == len && 0 == strncmp(pos, "ssl", len)) {
+            what |= ORC_SHARE_SSL;
+        } else {
+            return -1;
+        }
+        pos += len;
+        if (',' == *pos) {
+            pos++;
+        }
+    }
+    return what;
+}
+
+/**
+ * Creates a share handle for all threads. curl_global_init must have
+ * been called.
+ *
+ * @author Oscar Norlander
+ *
+ * @param what ORC_SHARE_* bits.
+ *
+ * @return CURLSH * Never 0, failures are fatal.
+ */
+CURLSH * share_create(int what) {
+    int i;
+    CURLSH *share = curl_share_init();
+    if (0 == share) {
+        orcerror("curl_share_init() failed, exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&(share_locks[i]), 0);
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+
+    CURLSHcode rc = CURLSHE_OK;
+    if (0 != (what & ORC_SHARE_DNS)) {
+        rc = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+    if (CURLSHE_OK == rc && 0 != (what & ORC_SHARE_SSL)) {
+        rc = curl_share_setopt(share, CURLSHOPT_SHARE,
+                               CURL_LOCK_DATA_SSL_SESSION);
+    }
+    if (CURLSHE_OK != rc) {
+        orcerror("Share %s\n", curl_share_strerror(rc));
+        exit(EXIT_FAILURE);
+    }
+    return share;
+}
+
+/**
+ * Frees a share handle, no easy handle may use it any more.
+ *
+ * @author Oscar Norlander
+ *
+ * @param share The share handle.
+ */
+void share_destroy(CURLSH *share) {
+    int i;
+    if (0 == share) {
+        return;
+    }
+    curl_share_cleanup(share);
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&(share_locks[i]));
+    }
+}
+
+/**
+ * Makes a CURLOPT_RESOLVE list of HOST:PORT:ADDR entries.
+ *
+ * @author Oscar Norlander
+ *
+ * @param entries The entries.
+ * @param len The number of entries.
+ *
+ * @return struct curl_slist * 0 if len is 0.
+ */
+struct curl_slist * share_resolve_list(const char **entries, int len) {
+    int i;
+    struct curl_slist *list = 0;
+    for (i = 0; i < len; i++) {
+        struct curl_slist *next = curl_slist_append(list, entries[i]);
+        if (0 == next) {
+            orcerror("curl_slist_append() failed, exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        list = next;
+    }
+    return list;
+}
+
+/* Find host and port of a http or https url. Returns 0 for other schemes
+   and for hosts that are addresses already. */
+static int url_host_port(const char *url, size_t url_len, char *host,
+                         size_t host_size, int *port) {
+    const char *pos;
+    if (7 < url_len && 0 == strncasecmp(url, "http://", 7)) {
+        pos = url + 7;
+        *port = 80;
+    } else if (8 < url_len && 0 == strncasecmp(url, "https://", 8)) {
+        pos = url + 8;
+        *port = 443;
+    } else {
+        return 0;
+    }
+    const char *end = url + url_len;
+    const char *auth_end = pos;
+    while (auth_end < end && '/' != *auth_end && '?' != *auth_end &&
+           '#' != *auth_end) {
+        auth_end++;
+    }
+    const char *at = memchr(pos, '@', auth_end - pos);
+    if (0 != at) {
+        pos = at + 1;
+    }
+    if (pos < auth_end && '[' == *pos) {
+        /* An ipv6 address */
+        return 0;
+    }
+    const char *colon = memchr(pos, ':', auth_end - pos);
+    const char *host_end = (0 != colon) ? colon : auth_end;
+    size_t len = host_end - pos;
+    if (0 == len || host_size <= len) {
+        return 0;
+    }
+    memcpy(host, pos, len);
+    host[len] = '\0';
+    if (0 != colon) {
+        char *port_end;
+        long value = strtol(colon + 1, &port_end, 10);
+        if (port_end != auth_end || 0 >= value || 65535 < value) {
+            return 0;
+        }
+        *port = (int)value;
+    }
+    struct in_addr addr;
+    if (1 == inet_pton(AF_INET, host, &addr)) {
+        return 0;
+    }
+    return 1;
+}
+
+/* Resolve a host and add a HOST:PORT:ADDR,ADDR entry to the list */
+static struct curl_slist * resolve_host(const char *host_port,
+                                        struct curl_slist *list) {
+    char host[MAX_URL_LEN + 1];
+    const char *colon = strrchr(host_port, ':');
+    size_t len = colon - host_port;
+    memcpy(host, host_port, len);
+    host[len] = '\0';
+
+    struct addrinfo hints;
+    struct addrinfo *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int status = getaddrinfo(host, colon + 1, &hints, &result);
+    if (0 != status) {
+        orcerror("Could not resolve %s %s\n", host, gai_strerror(status));
+        return list;
+    }
+
+    char entry[MAX_URL_LEN + 512];
+    size_t used = snprintf(entry, sizeof(entry), "%s:", host_port);
+    int count = 0;
+    struct addrinfo *ai;
+    for (ai = result; 0 != ai; ai = ai->ai_next) {
+        char addr[INET6_ADDRSTRLEN];
+        const void *src;
+        if (AF_INET == ai->ai_family) {
+            src = &(((struct sockaddr_in *)ai->ai_addr)->sin_addr);
+        } else if (AF_INET6 == ai->ai_family) {
+            src = &(((struct sockaddr_in6 *)ai->ai_addr)->sin6_addr);
+        } else {
+            continue;
+        }
+        if (0 == inet_ntop(ai->ai_family, src, addr, sizeof(addr))) {
+            continue;
+        }
+        int written = snprintf(entry + used, sizeof(entry) - used,
+                               (AF_INET6 == ai->ai_family) ?
+                               "%s[%s]" : "%s%s", (0 < count) ? "," : "",
+                               addr);
+        if (0 > written || sizeof(entry) - used <= (size_t)written) {
+            break;
+        }
+        used += written;
+        count++;
+    }
+    freeaddrinfo(result);
+    if (0 == count) {
+        return list;
+    }
+
+    struct curl_slist *next = curl_slist_append(list, entry);
+    if (0 == next) {
+        orcerror("curl_slist_append() failed, exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    orcout(orcm_debug, "Resolved %s\n", entry);
+    return next;
+}
+
+static void free_host(void **key, void **value, const enum free_cmd cmd) {
+    free(*key);
+    (*key) = 0;
+}
+
+/**
+ * Resolves every host of the corpus once and adds the addresses to a
+ * CURLOPT_RESOLVE list, so no lookups are done while generating load.
+ * Hosts that do not resolve are left to libcurl.
+ *
+ * @author Oscar Norlander
+ *
+ * @param corpus The urls.
+ * @param list The list to add to, may be 0.
+ *
+ * @return struct curl_slist * The list.
+ */
+struct curl_slist * share_pre_resolve(const url_corpus *corpus,
+                                      struct curl_slist *list) {
+    bintree_root hosts;
+    char url[MAX_URL_LEN + 1];
+    char host[MAX_URL_LEN + 1];
+    char last[MAX_URL_LEN + 16];
+    unsigned int i;
+
+    bintree_init(&hosts, bintree_streq, free_host);
+    last[0] = '\0';
+    for (i = 0; i < corpus->count; i++) {
+        int port;
+        size_t len = corpus_copy_url(corpus, i, url);
+        if (0 == url_host_port(url, len, host, sizeof(host), &port)) {
+            continue;
+        }
+        char host_port[MAX_URL_LEN + 16];
+        snprintf(host_port, sizeof(host_port), "%s:%d", host, port);
+        /* Url files are often grouped by host */
+        if (0 == strcmp(last, host_port)) {
+            continue;
+        }
+        strcpy(last, host_port);
+        if (0 != bintree_find(&hosts, host_port)) {
+            continue;
+        }
+        char *key = strdup(host_port);
+        if (0 == key) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        bintree_add(&hosts, key, key);
+        list = resolve_host(key, list);
+    }
+    orcstatus(orcm_verbose, orc_green, "RESOLVED", "%d hosts\n",
+              hosts.node_count);
+    bintree_free(&hosts);
+    return list;
+}
@@ -0,0 +1,191 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "topology.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define TOPOLOGY_NODE_PATH "/sys/devices/system/node/node%d/cpulist"
+
+/* Add a cpu to a growing array */
+static void add_cpu(int **cpus, int *len, int cpu) {
+    int *next = realloc(*cpus, (*len + 1) * sizeof(int));
+    if (0 == next) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    next[*len] = cpu;
+    (*len)++;
+    *cpus = next;
+}
+
+/**
+ * Parses a cpu list in the format of the kernel (0-3,8,10-11).
+ *
+ * @author Oscar Norlander
+ *
+ * @param list The list, a trailing newline is allowed.
+ * @param cpus Set to the cpus in list order, free it when done.
+ *
+ * @return int The number of cpus, -1 if the list is not valid or has a cpu
+ *             at or above CPU_SETSIZE.
+ */
+int topology_parse_cpus(const char *list, int **cpus) {
+    const char *pos = list;
+    int len = 0;
+
+    *cpus = 0;
+    while ('\0' != *pos && '\n' != *pos) {
+        char *end;
+        long first = strtol(pos, &end, 10);
+        long last = first;
+        if (end == pos || 0 > first) {
+            break;
+        }
+        pos = end;
+        if ('-' == *pos) {
+            last = strtol(pos + 1, &end, 10);
+            if (end == pos + 1 || last < first) {
+                break;
+            }
+            pos = end;
+        }
+        /* No cpu at or above CPU_SETSIZE can be pinned to */
+        if (CPU_SETSIZE <= last) {
+            break;
+        }
+        for (; first <= last; first++) {
+            add_cpu(cpus, &len, (int)first);
+        }
+        if (',' == *pos) {
+            pos++;
+        } else if ('\0' != *pos && '\n' != *pos) {
+            break;
+        }
+    }
+    if (('\0' != *pos && '\n' != *pos) || 0 == len) {
+        free(*cpus);
+        *cpus = 0;
+        return -1;
+    }
+    return len;
+}
+
+/**
+ * Reads the cpus of a NUMA node from sysfs.
+ *
+ * @author Oscar Norlander
+ *
+ * @param node The node number.
+ * @param cpus Set to the cpus of the node, free it when done.
+ *
+ * @return int The number of cpus, -1 if the node is unknown.
+ */
+int topology_node_cpus(int node, int **cpus) {
+    char path[128];
+    char list[4096];
+
+    *cpus = 0;
+    snprintf(path, sizeof(path), TOPOLOGY_NODE_PATH, node);
+    FILE *in = fopen(path, "r");
+    if (0 == in) {
+        orcerror("File %s\n", path);
+        orcerrno(errno);
+        return -1;
+    }
+    if (0 == fgets(list, sizeof(list), in)) {
+        fclose(in);
+        return -1;
+    }
+    fclose(in);
+    return topology_parse_cpus(list, cpus);
+}
+
+/**
+ * Lists the cpus this process may run on, the affinity mask on linux
+ * (so taskset and cgroups are respected) and all online cpus otherwise.
+ *
+ * @author Oscar Norlander
+ *
+ * @param cpus Set to the cpus, free it when done.
+ *
+ * @return int The number of cpus, at least 1.
+ */
+int topology_usable_cpus(int **cpus) {
+    int len = 0;
+    int i;
+
+    *cpus = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 == sched_getaffinity(0, sizeof(set), &set)) {
+        for (i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &set)) {
+                add_cpu(cpus, &len, i);
+            }
+        }
+    }
+#endif
+    if (0 == len) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (1 > online) {
+            online = 1;
+        }
+        for (i = 0; i < online; i++) {
+            add_cpu(cpus, &len, i);
+        }
+    }
+    return len;
+}
+
+/**
+ * Makes threads created with attr run on one cpu only. The thread then
+ * allocates its memory on the node of that cpu (first touch).
+ *
+ * @author Oscar Norlander
+ *
+ * @param attr The attributes of the thread to create.
+ * @param cpu The cpu.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int topology_set_cpu(pthread_attr_t *attr, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    if (0 > cpu || CPU_SETSIZE <= cpu) {
+        return 0;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return 0 == pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+#else
+    return 0;
+#endif
+}
@@ -22,18 +22,19 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <dirent.h>
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <sys/time.h>
 #include <limits.h>
 #include <sys/ioctl.h>
 #include <time.h>
+#include <sys/socket.h>
 
 
 #include "common.h"
 #include "client.h"
+#include "coordinator.h"
 #include "polyorctypes.h"
+#include "polyorcstats.h"
+#include "polyorcsegment.h"
 
 #define RED_ON_BLACK 1
 #define GREEN_ON_BLACK 2
@@ -43,95 +44,121 @@
 #define CYAN_ON_BLACK 6
 #define WHITE_ON_BLACK 7
 
-typedef struct _mmapfile {
-    int fd;
+/* Urls in each table of the url statistics */
+#define URL_TOP 5
+
+/* What is shown of a thread */
+typedef struct _threadview {
     int working;
     int working_check;
     unsigned long long history_total_bytes;
-    orcstatistics *stat;
-    struct _mmapfile *next;
-} mmapfile;
-
-static mmapfile *files = 0;
-
-void openfiles(const char* dir_path) {
-    DIR *d;
-    struct dirent *dir;
-    d = opendir(dir_path);
-
-    if (d)
-    {
-        const char *suffix = ".threadmem";
-        const int suffix_len = strlen(suffix);
-        while ((dir = readdir(d)) != NULL)
-        {
-            const char *file_name = dir->d_name;
-            int file_name_len = strlen(file_name);
-            if (file_name_len < suffix_len) {
-                continue;
-            }
-            if (0 != strncmp(file_name + (file_name_len - suffix_len),
-                             suffix, suffix_len))
-            {
-                continue;
-            }
-            mmapfile *file = calloc(1, sizeof(mmapfile));
-            char path[PATH_MAX - 1];
-            int len = snprintf(path, PATH_MAX - 2, "%s/%s",
-                               dir_path, file_name);
-            if (-1 == len) {
-                orcerror("Name error for path %s", path);
-                orcerrno(errno);
-                exit(EXIT_FAILURE);
-            }
-            int fd = open(path, O_RDONLY);
-            if (-1 == fd) {
-                orcerror("File %s", path);
-                orcerrno(errno);
-                exit(EXIT_FAILURE);
-            }
-            file->fd = fd;
-            file->fd = 0;
-            file->stat = mmap(NULL, sizeof(orcstatistics), PROT_READ,
-                          MAP_SHARED, fd, 0);
-            if (MAP_FAILED == file->stat) {
-                orcerror("Maping memory failed \n");
-                orcerrno(errno);
-                exit(EXIT_FAILURE);
-            }
-            fd = close(fd);
-            if (-1 == fd) {
-                orcerror("Close file %s", path);
-                orcerrno(errno);
-                exit(EXIT_FAILURE);
-            }
-            if (0 == files) {
-                files = file;
-            } else {
-                mmapfile *ptr = files;
-                mmapfile *tail = files;
-
-                while (0 != ptr) {
-                    if (ptr->stat->thread_no < file->stat->thread_no) {
-                        tail = ptr;
-                        ptr = ptr->next;
-                    } else {
-                        if (tail == ptr) {
-                            file->next = ptr;
-                            files = file;
-                            break;
-                        }
-                        tail->next = file;
-                        file->next = ptr;
-                        break;
-                    }
-                }
-                if (0 == ptr) {
-                    tail->next = file;
-                }
-            }
+    orcstatistics *stat; /* The last snapshot of its slot */
+    orcrate rate;
+} threadview;
+
+/* The statistics segment of polyorc */
+static orcsegment segment;
+
+/* One view per slot of the segment */
+static threadview *views = 0;
+
+/* Where a slot is read to before it replaces the view of a thread */
+static orcstatistics *scratch = 0;
+
+/* All threads merged, rebuilt for every display */
+static orcstatistics *merged = 0;
+
+/* The rates of all threads merged */
+static orcrate merged_rate;
+
+/* The url statistics of all threads merged, 0 without --url-stats */
+static orcurlstat *merged_urls = 0;
+
+/* Where polyorc takes commands, 0 without --admin */
+static const char *admin = 0;
+
+/* Set when the keys steer the agents of a coordinator */
+static int steering = 0;
+
+/* The last answer of the admin channel */
+static char admin_reply[128];
+
+/* Send one command to the admin channel of polyorc and keep the first line
+   of the answer */
+void send_command(const char *command) {
+    struct timeval wait = {1, 0};
+    int fd = agent_connect(admin);
+    if (-1 == fd) {
+        snprintf(admin_reply, sizeof(admin_reply), "%s: %s", command,
+                 strerror(errno));
+        return;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+    char line[128];
+    snprintf(line, sizeof(line), "%s\n", command);
+    ssize_t len = -1;
+    if (-1 != send(fd, line, strlen(line), MSG_NOSIGNAL)) {
+        len = recv(fd, line, sizeof(line) - 1, 0);
+    }
+    close(fd);
+    if (0 >= len) {
+        snprintf(admin_reply, sizeof(admin_reply), "%s: no answer", command);
+        return;
+    }
+    line[len] = '\0';
+    line[strcspn(line, "\r\n")] = '\0';
+    snprintf(admin_reply, sizeof(admin_reply), "%s: %s", command, line);
+}
+
+/* The admin command of a key, 0 if the key has none */
+static const char * key_command(int ch) {
+    switch (ch) {
+    case 'p': return "pause";
+    case 'r': return "resume";
+    case '+': return "scale 1.25";
+    case '-': return "scale 0.8";
+    case 's': return "stop";
+    default: return 0;
+    }
+}
+
+/* Map the statistics segment polyorc keeps in the directory */
+void opensegment(const char* dir_path) {
+    unsigned int i;
+    char path[PATH_MAX - 1];
+    int len = snprintf(path, PATH_MAX - 2, "%s/%s", dir_path,
+                       ORC_SEGMENT_FILE);
+    if (-1 == len) {
+        orcerror("Name error for path %s", path);
+        orcerrno(errno);
+        exit(EXIT_FAILURE);
+    }
+    if (0 == orcseg_open(&segment, path)) {
+        exit(EXIT_FAILURE);
+    }
+    views = calloc(segment.header->threads, sizeof(threadview));
+    if (0 == views) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    scratch = calloc(1, sizeof(orcstatistics));
+    if (0 == scratch) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < segment.header->threads; i++) {
+        views[i].stat = calloc(1, sizeof(orcstatistics));
+        if (0 == views[i].stat) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (0 != segment.header->urls) {
+        merged_urls = calloc(segment.header->urls, sizeof(orcurlstat));
+        if (0 == merged_urls) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
         }
-        closedir(d);
     }
 }
 
@@ -139,6 +166,200 @@ void display_header() {
     attron(COLOR_PAIR(GREEN_ON_BLACK));
     mvprintw(0, 0, "Polyorc Boss");
     attroff(COLOR_PAIR(GREEN_ON_BLACK));
+    if (0 != admin || 0 != steering) {
+        mvprintw(0, 16, "p pause  r resume  + faster  - slower  s stop");
+        mvprintw(0, 64, "%s", admin_reply);
+    }
+}
+
+/* One row of the latency table */
+static void display_histogram(int row, const char *name,
+                              const orchistogram *hist) {
+    mvprintw(row, 0, "%s", name);
+    mvprintw(row, 16, "%llu", hist->count);
+    mvprintw(row, 28, "%.2f", orchist_mean(hist) / 1000.0);
+    mvprintw(row, 38, "%.2f", orchist_percentile(hist, 50.0) / 1000.0);
+    mvprintw(row, 48, "%.2f", orchist_percentile(hist, 90.0) / 1000.0);
+    mvprintw(row, 58, "%.2f", orchist_percentile(hist, 99.0) / 1000.0);
+    mvprintw(row, 68, "%.2f", orchist_percentile(hist, 99.9) / 1000.0);
+    mvprintw(row, 78, "%.2f", hist->max / 1000.0);
+}
+
+/* Shows the merged latency histograms of all threads in milliseconds */
+int display_latency(int row) {
+    int i;
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "Latency ms");
+    mvprintw(row, 16, "count");
+    mvprintw(row, 28, "mean");
+    mvprintw(row, 38, "p50");
+    mvprintw(row, 48, "p90");
+    mvprintw(row, 58, "p99");
+    mvprintw(row, 68, "p99.9");
+    mvprintw(row, 78, "max");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    row++;
+    for (i = 0; i < orcl_count; i++) {
+        display_histogram(row, orcstat_latency_name(i), &(merged->latency[i]));
+        row++;
+    }
+    if (0 != merged->failed) {
+        display_histogram(row++, "ok", &(merged->ok_latency));
+        display_histogram(row++, "failed", &(merged->failed_latency));
+    }
+    return row;
+}
+
+/* Shows a table of urls in the order of top */
+static int display_url_table(int row, const char *title,
+                             const unsigned int *top, int count) {
+    int i;
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "%s", title);
+    mvprintw(row, 16, "count");
+    mvprintw(row, 28, "p99 ms");
+    mvprintw(row, 38, "errors");
+    mvprintw(row, 48, "url");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    row++;
+    for (i = 0; i < count; i++) {
+        const orcurlstat *url = &(merged_urls[top[i]]);
+        mvprintw(row, 16, "%u", url->count);
+        mvprintw(row, 28, "%.2f", orcurl_percentile(url, 99.0) / 1000.0);
+        mvprintw(row, 38, "%u", url->errors);
+        mvprintw(row, 48, "%.*s", (COLS > 48) ? COLS - 48 : 0,
+                 orcseg_url_name(&segment, top[i]));
+        row++;
+    }
+    return row;
+}
+
+/* Shows the slowest urls and the urls that fail most, of all threads */
+int display_urls(int row) {
+    unsigned int i;
+    unsigned int top[URL_TOP];
+    if (0 == merged_urls) {
+        return row;
+    }
+    memset(merged_urls, 0, segment.header->urls * sizeof(orcurlstat));
+    for (i = 0; i < segment.header->threads; i++) {
+        orcurl_merge(merged_urls, orcseg_urls(&segment, i),
+                     segment.header->urls);
+    }
+    int count = orcurl_top(merged_urls, segment.header->urls, orcu_p99, top,
+                           URL_TOP);
+    row = display_url_table(row, "Slowest urls", top, count);
+    count = orcurl_top(merged_urls, segment.header->urls, orcu_errors, top,
+                       URL_TOP);
+    if (0 != count) {
+        row = display_url_table(row + 1, "Failing urls", top, count);
+    }
+    return row;
+}
+
+/* Shows the status classes, the most common codes and curl failures */
+int display_outcome(int row) {
+    int i;
+    orccode top[6];
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "Failed");
+    mvprintw(row + 1, 0, "Status");
+    mvprintw(row + 2, 0, "Codes");
+    mvprintw(row + 3, 0, "Errors");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    if (0 != merged->failed) {
+        attron(COLOR_PAIR(RED_ON_BLACK));
+    }
+    mvprintw(row, 8, "%llu", merged->failed);
+    if (0 != merged->failed) {
+        attroff(COLOR_PAIR(RED_ON_BLACK));
+    }
+    for (i = 0; i < orcc_count; i++) {
+        mvprintw(row + 1, 8 + i * 13, "%s %llu", orcstat_status_name(i),
+                 merged->status[i]);
+    }
+    int count = orcstat_top_codes(merged, top, 6);
+    for (i = 0; i < count; i++) {
+        mvprintw(row + 2, 8 + i * 13, "%d %llu", top[i].code, top[i].count);
+    }
+    for (i = 0; i < orcf_count; i++) {
+        mvprintw(row + 3, 8 + i * 13, "%s %llu", orcstat_failure_name(i),
+                 merged->failures[i]);
+    }
+    return row + 4;
+}
+
+/* Shows how many connections the transfers of all threads needed */
+int display_connections(int row) {
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "Connections");
+    mvprintw(row, 16, "opened");
+    mvprintw(row, 28, "streams");
+    mvprintw(row, 38, "per conn");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    row++;
+    mvprintw(row, 16, "%llu", merged->connects);
+    mvprintw(row, 28, "%llu", merged->multiplexed);
+    if (0 < merged->connects) {
+        mvprintw(row, 38, "%.1f", (double)merged->hits / merged->connects);
+    }
+    return row + 1;
+}
+
+/* Shows the active step of a load profile */
+int display_step(int row) {
+    if (0 == merged->step) {
+        return row;
+    }
+    const orcstep *step = &(merged->steps[merged->step - 1]);
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "Profile");
+    mvprintw(row, 16, "step");
+    mvprintw(row, 28, "target");
+    mvprintw(row, 38, "secs");
+    mvprintw(row, 48, "d/s");
+    mvprintw(row, 58, "p99 ms");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    row++;
+    mvprintw(row, 16, "%d", merged->step);
+    mvprintw(row, 28, "%.1f", merged->target);
+    mvprintw(row, 38, "%.1f", step->seconds);
+    if (0 < step->seconds) {
+        mvprintw(row, 48, "%.1f", step->hits / step->seconds);
+    }
+    mvprintw(row, 58, "%.2f",
+             orchist_percentile(&(step->latency), 99.0) / 1000.0);
+    return row + 2;
+}
+
+/* Shows the steps of a scenario and how many sessions ended */
+int display_flow(int row) {
+    int i;
+    if (0 == merged->flow_count) {
+        return row;
+    }
+    attron(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row, 0, "Scenario");
+    mvprintw(row, 16, "count");
+    mvprintw(row, 28, "mean");
+    mvprintw(row, 38, "p50");
+    mvprintw(row, 48, "p99");
+    mvprintw(row, 58, "sessions");
+    attroff(COLOR_PAIR(CYAN_ON_BLACK));
+    mvprintw(row + 1, 58, "%llu", merged->sessions);
+    row++;
+    for (i = 0; i < merged->flow_count; i++) {
+        const orcflowstep *step = &(merged->flow[i]);
+        mvprintw(row, 0, "%.*s", ORC_FLOW_NAME_LEN, step->name);
+        mvprintw(row, 16, "%llu", step->hits);
+        mvprintw(row, 28, "%.2f", orchist_mean(&(step->latency)) / 1000.0);
+        mvprintw(row, 38, "%.2f",
+                 orchist_percentile(&(step->latency), 50.0) / 1000.0);
+        mvprintw(row, 48, "%.2f",
+                 orchist_percentile(&(step->latency), 99.0) / 1000.0);
+        row++;
+    }
+    return row;
 }
 
 void display_data() {
@@ -148,19 +369,24 @@ void display_data() {
     //int width = w.ws_col;
 
     int row = 2;
-    mmapfile *ptr = files;
+    unsigned int i;
     clear();
     display_header();
-    if (ptr == 0) {
+    if (0 == segment.header || 0 == segment.header->threads) {
         mvprintw(row, 0, "No threads found!");
         return;
     }
-    unsigned long long sum = 0;
-    unsigned long long sum_bsec = 0;
-    unsigned int sum_hits = 0;
-    unsigned int sum_hits_sec = 0;
-    while (0 != ptr) {
-        mvprintw(row, 0, "Thread %d", ptr->stat->thread_no);
+    memset(merged, 0, sizeof(orcstatistics));
+    for (i = 0; i < segment.header->threads; i++) {
+        threadview *ptr = &(views[i]);
+        /* Keep the last snapshot if the thread was busy publishing */
+        if (0 != orcseg_read(&(segment.slots[i]), scratch)) {
+            orcstatistics *last = ptr->stat;
+            ptr->stat = scratch;
+            scratch = last;
+            orcrate_update(&(ptr->rate), ptr->stat);
+        }
+        mvprintw(row, 0, "Thread %d", i + 1);
 
         ptr->working_check++;
         if (ptr->working_check % 10 == 0) {
@@ -187,27 +413,33 @@ void display_data() {
                  byte_to_human_suffix(ptr->stat->total_bytes));
 
         mvprintw(row, 36, "%.2Lf %s/s",
-                 byte_to_human_size(ptr->stat->bytes_sec),
-                 byte_to_human_suffix(ptr->stat->bytes_sec));
-
-        mvprintw(row, 56, "%d d/s", ptr->stat->hits_sec);
-        mvprintw(row, 65, "%d d", ptr->stat->hits);
+                 byte_to_human_size(ptr->rate.bytes_sec),
+                 byte_to_human_suffix(ptr->rate.bytes_sec));
 
-        sum += ptr->stat->total_bytes;
-        sum_bsec += ptr->stat->bytes_sec;
-        sum_hits += ptr->stat->hits;
-        sum_hits_sec += ptr->stat->hits_sec;
+        mvprintw(row, 56, "%.0f d/s", ptr->rate.hits_sec);
+        mvprintw(row, 65, "%llu d", ptr->stat->hits);
+        mvprintw(row, 76, "%llu m", ptr->stat->missed);
 
-        ptr = ptr->next;
+        orcstat_merge(merged, ptr->stat);
         row++;
     }
+    row = display_latency(row + 1);
+    row = display_outcome(row + 1);
+    row = display_connections(row + 1);
+    row = display_step(row + 1);
+    row = display_flow(row);
+    display_urls(row + 1);
+    orcrate_update(&merged_rate, merged);
     mvprintw(height - 1, 0, "Sum");
-    mvprintw(height - 1, 16, "%.2Lf %s", byte_to_human_size(sum),
-                         byte_to_human_suffix(sum));
-    mvprintw(height - 1, 36, "%.2Lf %s/s", byte_to_human_size(sum_bsec),
-                         byte_to_human_suffix(sum_bsec));
-    mvprintw(height - 1, 56, "%d d/s", sum_hits_sec);
-    mvprintw(height - 1, 65, "%d d", sum_hits);
+    mvprintw(height - 1, 16, "%.2Lf %s",
+                         byte_to_human_size(merged->total_bytes),
+                         byte_to_human_suffix(merged->total_bytes));
+    mvprintw(height - 1, 36, "%.2Lf %s/s",
+                         byte_to_human_size(merged_rate.bytes_sec),
+                         byte_to_human_suffix(merged_rate.bytes_sec));
+    mvprintw(height - 1, 56, "%.0f d/s", merged_rate.hits_sec);
+    mvprintw(height - 1, 65, "%llu d", merged->hits);
+    mvprintw(height - 1, 76, "%llu m", merged->missed);
 }
 
 static void finish(int sig)
@@ -242,8 +474,63 @@ void init_curses() {
     }
 }
 
+/* Coordinator mode, the statistics come from the agents instead of the
+   stat files. Quiet runs without curses and only prints the result. */
+static void coordinate(bossarguments *arg) {
+    int ui = (orcm_quiet != arg->verbosity);
+    struct timespec sleep_spec;
+    sleep_spec.tv_sec = 0;
+    sleep_spec.tv_nsec = 300000000L;
+
+    coordinator_start(arg);
+    if (0 != ui) {
+        steering = 1;
+        init_curses();
+    }
+    while (0 < coordinator_poll(merged)) {
+        if (0 != ui) {
+            clear();
+            display_header();
+            int row = coordinator_display(2);
+            row = display_latency(row + 1);
+            row = display_outcome(row + 1);
+            row = display_connections(row + 1);
+            row = display_step(row + 1);
+            display_flow(row);
+            int ch = getch();
+            if ('q' == ch) {
+                break;
+            }
+            const char *command = key_command(ch);
+            if (0 != command) {
+                coordinator_broadcast(command);
+                snprintf(admin_reply, sizeof(admin_reply), "%s: sent",
+                         command);
+            }
+        }
+        nanosleep(&sleep_spec, 0);
+    }
+    if (0 != ui) {
+        endwin();
+    }
+    coordinator_report(merged);
+    coordinator_finish();
+}
+
 void client_loop(bossarguments *arg) {
-    openfiles(arg->stat_dir);
+    admin = arg->admin;
+    merged = calloc(1, sizeof(orcstatistics));
+    if (0 == merged) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    if (0 != arg->agents) {
+        coordinate(arg);
+        return;
+    }
+    if (0 != arg->stat_dir) {
+        opensegment(arg->stat_dir);
+    }
 
     init_curses();
     int run = 1;
@@ -267,6 +554,10 @@ void client_loop(bossarguments *arg) {
         if ('q' == ch) {
             finish(0);
         }
+        const char *command = key_command(ch);
+        if (0 != admin && 0 != command) {
+            send_command(command);
+        }
         nanosleep(&sleep_spec, 0);
     }
 }
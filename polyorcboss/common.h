@@ -26,6 +26,11 @@ typedef struct _bossarguments {
     enum polyorc_verbosity verbosity;
     enum polyorc_color color;
     const char *stat_dir;
+    const char *admin; /* Port or unix socket of polyorc --admin */
+    const char *agents; /* Admin addresses of polyorc --hold processes */
+    double rate; /* Total rate shared by the agents, 0 to keep theirs */
+    int shard; /* Give every agent its own part of the urls */
+    double start_delay; /* Seconds from the barrier to the start */
 } bossarguments;
 
 #endif
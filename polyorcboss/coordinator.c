@@ -0,0 +1,395 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "coordinator.h"
+#include "polyorcout.h"
+#include "polyorcwire.h"
+#include "polyorcstats.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <curses.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/* The most agents a coordinator drives */
+#define MAX_AGENTS 64
+
+/* A polyorc --hold process and the statistics it sent last */
+typedef struct _agent {
+    char address[256];
+    int fd;
+    FILE *in; /* Replies are read a line at a time */
+    int finished;
+    int gone; /* The connection broke, its last statistics are kept */
+    orcstatistics *stat;
+    orcrate rate;
+} agent;
+
+static agent agents[MAX_AGENTS];
+static int agent_count;
+
+/* Read buffer of the wire encoding */
+static char *wire;
+static size_t wire_cap;
+
+/**
+ * Connects to the admin channel of polyorc.
+ *
+ * @author Oscar Norlander
+ *
+ * @param address A port on localhost, HOST:PORT or a unix socket path.
+ *
+ * @return int The socket, -1 on fail with errno set.
+ */
+int agent_connect(const char *address) {
+    int fd = -1;
+    if (0 != strchr(address, '/')) {
+        struct sockaddr_un un;
+        memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        snprintf(un.sun_path, sizeof(un.sun_path), "%s", address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (-1 != fd && -1 == connect(fd, (struct sockaddr *)&un, sizeof(un))) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            fd = -1;
+        }
+        return fd;
+    }
+    char host[256] = "127.0.0.1";
+    const char *port = address;
+    const char *colon = strrchr(address, ':');
+    if (0 != colon) {
+        snprintf(host, sizeof(host), "%.*s", (int)(colon - address), address);
+        port = colon + 1;
+    }
+    struct addrinfo hints;
+    struct addrinfo *found = 0;
+    struct addrinfo *pos;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (0 != getaddrinfo(host, port, &hints, &found)) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    for (pos = found; 0 != pos; pos = pos->ai_next) {
+        fd = socket(pos->ai_family, pos->ai_socktype, pos->ai_protocol);
+        if (-1 == fd) {
+            continue;
+        }
+        if (0 == connect(fd, pos->ai_addr, pos->ai_addrlen)) {
+            break;
+        }
+        int error = errno;
+        close(fd);
+        errno = error;
+        fd = -1;
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+/* Send a command and read the first line of the answer */
+static int agent_command(agent *a, const char *command, char *line,
+                         size_t len) {
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf), "%s\n", command);
+    if (0 != a->gone || -1 == send(a->fd, buf, n, MSG_NOSIGNAL) ||
+        0 == fgets(line, len, a->in))
+    {
+        a->gone = 1;
+        return 0;
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+    return 1;
+}
+
+/* Send a command that is answered by OK */
+static void agent_setup(agent *a, const char *command) {
+    char line[256];
+    if (0 == agent_command(a, command, line, sizeof(line))) {
+        orcerror("Agent %s: %s: no answer\n", a->address, command);
+        exit(EXIT_FAILURE);
+    }
+    if (0 != strcmp("OK", line)) {
+        orcerror("Agent %s: %s: %s\n", a->address, command, line);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Fetch the statistics of an agent */
+static void agent_dump(agent *a) {
+    char line[256];
+    size_t len = 0;
+    if (0 == agent_command(a, "dump", line, sizeof(line))) {
+        return;
+    }
+    if (0 != strncmp("state ", line, 6)) {
+        orcerror("Agent %s: dump: %s\n", a->address, line);
+        a->gone = 1;
+        return;
+    }
+    int finished = (0 == strcmp("state finished", line));
+    /* The encoding ends with an end line, then comes OK */
+    while (1) {
+        if (wire_cap - len < sizeof(line)) {
+            wire_cap = wire_cap * 2 + sizeof(line);
+            wire = realloc(wire, wire_cap);
+            if (0 == wire) {
+                orcerror("%s (%d)\n", strerror(errno), errno);
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (0 == fgets(wire + len, wire_cap - len, a->in)) {
+            a->gone = 1;
+            return;
+        }
+        size_t got = strlen(wire + len);
+        int end = (0 == strcmp("end\n", wire + len) &&
+                   (0 == len || '\n' == wire[len - 1]));
+        len += got;
+        if (0 != end) {
+            break;
+        }
+    }
+    if (0 == fgets(line, sizeof(line), a->in) || 0 != strncmp("OK", line, 2) ||
+        0 == orcwire_decode(a->stat, wire, len))
+    {
+        orcerror("Agent %s: broken dump\n", a->address);
+        a->gone = 1;
+        return;
+    }
+    orcrate_update(&(a->rate), a->stat);
+    a->finished = finished;
+}
+
+/**
+ * Connects to every agent, hands out the shards and the rate and starts
+ * them all at the same time. Failures are fatal.
+ *
+ * @author Oscar Norlander
+ *
+ * @param arg The arguments, agents is a comma separated list.
+ */
+void coordinator_start(const bossarguments *arg) {
+    char command[128];
+    const char *pos = arg->agents;
+    int i;
+    while ('\0' != *pos) {
+        size_t len = strcspn(pos, ",");
+        if (MAX_AGENTS == agent_count) {
+            orcerror("At most %d agents\n", MAX_AGENTS);
+            exit(EXIT_FAILURE);
+        }
+        agent *a = &(agents[agent_count]);
+        snprintf(a->address, sizeof(a->address), "%.*s", (int)len, pos);
+        a->fd = agent_connect(a->address);
+        if (-1 == a->fd) {
+            orcerror("Agent %s\n", a->address);
+            orcerrno(errno);
+            exit(EXIT_FAILURE);
+        }
+        a->in = fdopen(a->fd, "r");
+        a->stat = calloc(1, sizeof(orcstatistics));
+        if (0 == a->in || 0 == a->stat) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            exit(EXIT_FAILURE);
+        }
+        agent_count++;
+        pos += len;
+        if (',' == *pos) {
+            pos++;
+        }
+    }
+    if (0 == agent_count) {
+        orcerror("No agents\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < agent_count; i++) {
+        if (0 != arg->shard) {
+            snprintf(command, sizeof(command), "shard %d %d", i, agent_count);
+            agent_setup(&(agents[i]), command);
+        }
+        if (0 < arg->rate) {
+            snprintf(command, sizeof(command), "rate %.17g",
+                     arg->rate / agent_count);
+            agent_setup(&(agents[i]), command);
+        }
+    }
+    /* Every agent is set up, this is the barrier. They start at the same
+       wall clock time, so the clocks of their hosts should be in sync. */
+    struct timeval now;
+    gettimeofday(&now, 0);
+    double start_at = now.tv_sec + now.tv_usec / 1e6 + arg->start_delay;
+    snprintf(command, sizeof(command), "start %.6f", start_at);
+    for (i = 0; i < agent_count; i++) {
+        agent_setup(&(agents[i]), command);
+    }
+    orcstatus(orcm_normal, orc_green, "STARTED", "%d agents in %g seconds\n",
+              agent_count, arg->start_delay);
+}
+
+/**
+ * Fetches the statistics of every agent and merges them.
+ *
+ * @author Oscar Norlander
+ *
+ * @param merged Set to the sum of all agents.
+ *
+ * @return int The number of agents still running.
+ */
+int coordinator_poll(orcstatistics *merged) {
+    int i;
+    int running = 0;
+    memset(merged, 0, sizeof(orcstatistics));
+    for (i = 0; i < agent_count; i++) {
+        agent *a = &(agents[i]);
+        if (0 == a->finished && 0 == a->gone) {
+            agent_dump(a);
+        }
+        if (0 == a->finished && 0 == a->gone) {
+            running++;
+        }
+        orcstat_merge(merged, a->stat);
+    }
+    return running;
+}
+
+/**
+ * Sends a command to every agent that is still running.
+ *
+ * @author Oscar Norlander
+ *
+ * @param command The command, like pause.
+ */
+void coordinator_broadcast(const char *command) {
+    char line[256];
+    int i;
+    for (i = 0; i < agent_count; i++) {
+        if (0 == agents[i].finished) {
+            agent_command(&(agents[i]), command, line, sizeof(line));
+        }
+    }
+}
+
+/**
+ * Shows a row per agent.
+ *
+ * @author Oscar Norlander
+ *
+ * @param row The first row.
+ *
+ * @return int The row after the agents.
+ */
+int coordinator_display(int row) {
+    int i;
+    attron(A_BOLD);
+    mvprintw(row, 0, "Agent");
+    mvprintw(row, 28, "state");
+    mvprintw(row, 40, "requests");
+    mvprintw(row, 52, "d/s");
+    mvprintw(row, 62, "missed");
+    attroff(A_BOLD);
+    row++;
+    for (i = 0; i < agent_count; i++) {
+        const agent *a = &(agents[i]);
+        mvprintw(row, 0, "%.27s", a->address);
+        mvprintw(row, 28, "%s", (0 != a->gone) ? "gone" :
+                 (0 != a->finished) ? "finished" : "running");
+        mvprintw(row, 40, "%llu", a->stat->hits);
+        mvprintw(row, 52, "%.0f", a->rate.hits_sec);
+        mvprintw(row, 62, "%llu", a->stat->missed);
+        row++;
+    }
+    return row;
+}
+
+/**
+ * Lets the agents exit and closes the connections.
+ *
+ * @author Oscar Norlander
+ */
+void coordinator_finish() {
+    char line[256];
+    int i;
+    for (i = 0; i < agent_count; i++) {
+        agent_command(&(agents[i]), "bye", line, sizeof(line));
+        fclose(agents[i].in);
+        free(agents[i].stat);
+    }
+    agent_count = 0;
+    free(wire);
+    wire = 0;
+    wire_cap = 0;
+}
+
+/**
+ * Prints the merged statistics of all agents, like polyorc prints its own.
+ *
+ * @author Oscar Norlander
+ *
+ * @param merged The statistics of all agents.
+ */
+void coordinator_report(const orcstatistics *merged) {
+    int i;
+    orcoutc(orc_reset, orc_red, "Agents:     ");
+    orcout(orcm_quiet, "%d\n", agent_count);
+    orcoutc(orc_reset, orc_red, "Requests:   ");
+    orcout(orcm_quiet, "%llu\n", merged->hits);
+    orcoutc(orc_reset, orc_red, "Downloaded: ");
+    orcout(orcm_quiet, "%.2Lf %s\n", byte_to_human_size(merged->total_bytes),
+           byte_to_human_suffix(merged->total_bytes));
+    orcoutc(orc_reset, orc_red, "Missed:     ");
+    orcout(orcm_quiet, "%llu\n", merged->missed);
+    orcoutc(orc_reset, orc_red, "Aborted:    ");
+    orcout(orcm_quiet, "%llu\n", merged->aborted);
+    orcoutc(orc_reset, orc_red, "Connects:   ");
+    orcout(orcm_quiet, "%llu\n", merged->connects);
+    if (0 != merged->flow_count) {
+        orcoutc(orc_reset, orc_red, "Sessions:   ");
+        orcout(orcm_quiet, "%llu\n", merged->sessions);
+    }
+    orcstat_print_outcome(merged);
+    orcoutc(orc_reset, orc_red, "%-10s", "ms");
+    orcout(orcm_quiet, "%10s %9s %9s %9s %9s %9s %9s\n", "count", "mean",
+           "p50", "p90", "p99", "p99.9", "max");
+    for (i = 0; i < orcl_count; i++) {
+        orcstat_print_latency(orcstat_latency_name(i), &(merged->latency[i]));
+    }
+    if (0 != merged->failed) {
+        orcstat_print_latency("ok", &(merged->ok_latency));
+        orcstat_print_latency("failed", &(merged->failed_latency));
+    }
+    for (i = 0; i < merged->flow_count; i++) {
+        char name[ORC_FLOW_NAME_LEN + 1];
+        snprintf(name, sizeof(name), "%.*s", ORC_FLOW_NAME_LEN,
+                 merged->flow[i].name);
+        orcstat_print_latency(name, &(merged->flow[i].latency));
+    }
+}
@@ -17,6 +17,7 @@
 
 #include <argp.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include "common.h"
 #include "polyorcutils.h"
@@ -39,7 +40,19 @@ static struct argp_option options[] = {
     {"debug",        'd', 0,       0, "Produce debug and verbose output" },
     {"color",        'c', 0,       0, "Color output" },
     {"no-color",     'n', 0,       0, "No color output" },
-    {"stat-dir",     's', "DIR",   0, "A directory for reading stat files"},
+    {"stat-dir",     's', "DIR",   0, "The directory of the statistics segment"},
+    {"admin",        'a', "ADDR",  0, "Steer polyorc through the admin port" \
+                                      " or unix socket ADDR with the keys" \
+                                      " p, r, +, - and s"},
+    {"agents",       1001, "LIST", 0, "Coordinate the polyorc --hold agents" \
+                                      " with these comma separated admin" \
+                                      " addresses, -q only prints the result"},
+    {"rate",         1002, "RATE", 0, "Share the total RATE between the" \
+                                      " agents"},
+    {"shard",        1003, 0,      0, "Give every agent its own share of" \
+                                      " the urls"},
+    {"start-delay",  1004, "SECS", 0, "Start the agents SECS seconds after" \
+                                      " all are set up (default 1)"},
     { 0 }
 };
 
@@ -93,12 +106,38 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
     case 's':
         arg->stat_dir = opt_arg;
         break;
+    case 'a':
+        arg->admin = opt_arg;
+        break;
+    case 1001:
+        arg->agents = opt_arg;
+        break;
+    case 1002:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->rate)) || !(0 < arg->rate)) {
+            orcerror("Rate must be a number above 0.\n");
+            argp_usage(state);
+        }
+        break;
+    case 1003:
+        arg->shard = 1;
+        break;
+    case 1004:
+        if (1 != sscanf(opt_arg, "%lf", &(arg->start_delay)) ||
+            !(0 <= arg->start_delay)) {
+            orcerror("Start delay must be a number of seconds.\n");
+            argp_usage(state);
+        }
+        break;
     case ARGP_KEY_ARG:
     case ARGP_KEY_END:
         if (state->arg_num != 0) {
             /* Not enough arguments. */
             argp_usage(state);
         }
+        if (0 == arg->agents && (0 < arg->rate || 0 != arg->shard)) {
+            orcerror("Rate and shard are for agents (see --agents)\n");
+            argp_usage(state);
+        }
         break;
     default:
         return ARGP_ERR_UNKNOWN;
@@ -117,6 +156,11 @@ int main(int argc, char *argv[])
     arg.verbosity = orcm_not_set;
     arg.color = orcc_not_set;
     arg.stat_dir = 0;
+    arg.admin = 0;
+    arg.agents = 0;
+    arg.rate = 0;
+    arg.shard = 0;
+    arg.start_delay = 1;
 
     /* Parse our arguments; every option seen by parse_opt will
        be reflected in arguments. */
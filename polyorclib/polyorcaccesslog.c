@@ -0,0 +1,184 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcaccesslog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *months[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/* Days from 1970-01-01 to a date in the proleptic Gregorian calendar */
+static long long days_from_civil(long long y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* Parse a fixed number of digits */
+static int parse_digits(const char *pos, int count, int *out) {
+    int i;
+    *out = 0;
+    for (i = 0; i < count; i++) {
+        if ('0' > pos[i] || '9' < pos[i]) {
+            return 0;
+        }
+        *out = *out * 10 + (pos[i] - '0');
+    }
+    return 1;
+}
+
+/* Parse 10/Oct/2000:13:55:36 -0700 (26 characters) */
+static int parse_clf_time(const char *pos, double *time) {
+    int day, year, hour, min, sec, zone_h, zone_m;
+    int month;
+    if (!parse_digits(pos, 2, &day) || '/' != pos[2] || '/' != pos[6] ||
+        !parse_digits(pos + 7, 4, &year) || ':' != pos[11] ||
+        !parse_digits(pos + 12, 2, &hour) || ':' != pos[14] ||
+        !parse_digits(pos + 15, 2, &min) || ':' != pos[17] ||
+        !parse_digits(pos + 18, 2, &sec) || ' ' != pos[20] ||
+        ('+' != pos[21] && '-' != pos[21]) ||
+        !parse_digits(pos + 22, 2, &zone_h) ||
+        !parse_digits(pos + 24, 2, &zone_m))
+    {
+        return 0;
+    }
+    for (month = 0; month < 12; month++) {
+        if (0 == strncmp(pos + 3, months[month], 3)) {
+            break;
+        }
+    }
+    if (12 == month) {
+        return 0;
+    }
+    long long seconds = days_from_civil(year, month + 1, day) * 86400LL +
+                        hour * 3600 + min * 60 + sec;
+    long long zone = zone_h * 3600 + zone_m * 60;
+    /* Local time minus the offset is utc */
+    *time = (double)(('+' == pos[21]) ? seconds - zone : seconds + zone);
+    return 1;
+}
+
+/* Copy a method, it has to be a token */
+static int copy_method(const char *pos, size_t len, orclogentry *entry) {
+    size_t i;
+    if (0 == len || ORC_LOG_METHOD_LEN <= len) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        if (('A' > pos[i] || 'Z' < pos[i]) && '-' != pos[i] && '_' != pos[i]) {
+            return 0;
+        }
+    }
+    memcpy(entry->method, pos, len);
+    entry->method[len] = '\0';
+    return 1;
+}
+
+/* host ident user [time] "METHOD target PROTOCOL" status bytes ... */
+static int parse_clf(const char *line, size_t len, orclogentry *entry) {
+    const char *end = line + len;
+    const char *open = memchr(line, '[', len);
+    if (0 == open || end - open < 28 || ']' != open[27]) {
+        return 0;
+    }
+    if (!parse_clf_time(open + 1, &(entry->time))) {
+        return 0;
+    }
+    const char *pos = open + 28;
+    if (end - pos < 2 || ' ' != pos[0] || '"' != pos[1]) {
+        return 0;
+    }
+    pos += 2;
+    const char *space = memchr(pos, ' ', end - pos);
+    if (0 == space || !copy_method(pos, space - pos, entry)) {
+        return 0;
+    }
+    pos = space + 1;
+    const char *target_end = pos;
+    while (target_end < end && ' ' != *target_end && '"' != *target_end) {
+        target_end++;
+    }
+    if (target_end == pos) {
+        return 0;
+    }
+    entry->target = pos;
+    entry->target_len = target_end - pos;
+    return 1;
+}
+
+/* time<TAB>method<TAB>target */
+static int parse_tsv(const char *line, size_t len, orclogentry *entry) {
+    const char *end = line + len;
+    const char *tab = memchr(line, '\t', len);
+    if (0 == tab || tab == line || 64 <= tab - line) {
+        return 0;
+    }
+    char number[64];
+    memcpy(number, line, tab - line);
+    number[tab - line] = '\0';
+    char *number_end;
+    entry->time = strtod(number, &number_end);
+    if ('\0' != *number_end) {
+        return 0;
+    }
+    const char *pos = tab + 1;
+    tab = memchr(pos, '\t', end - pos);
+    if (0 == tab || !copy_method(pos, tab - pos, entry)) {
+        return 0;
+    }
+    pos = tab + 1;
+    const char *target_end = memchr(pos, '\t', end - pos);
+    if (0 == target_end) {
+        target_end = end;
+    }
+    if (target_end == pos) {
+        return 0;
+    }
+    entry->target = pos;
+    entry->target_len = target_end - pos;
+    return 1;
+}
+
+/**
+ * Parses one line of an access log.
+ *
+ * @author Oscar Norlander
+ *
+ * @param format The log format.
+ * @param line The line, a trailing newline is allowed.
+ * @param len The length of the line.
+ * @param entry The parsed request.
+ *
+ * @return int 1 on succes 0 if the line is not a request
+ */
+int orclog_parse(enum orc_logformat format, const char *line, size_t len,
+                 orclogentry *entry) {
+    while (0 < len && ('\n' == line[len - 1] || '\r' == line[len - 1])) {
+        len--;
+    }
+    if (orclog_tsv == format) {
+        return parse_tsv(line, len, entry);
+    }
+    return parse_clf(line, len, entry);
+}
@@ -0,0 +1,45 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCACCESSLOG_H
+#define POLYORCACCESSLOG_H
+
+#include <stddef.h>
+
+#define ORC_LOG_METHOD_LEN 16
+
+/* The access log formats that can be replayed */
+enum orc_logformat {
+    orclog_clf = 0, /* Common and combined log format */
+    orclog_tsv /* Epoch seconds, method and url separated by tabs */
+};
+
+/**
+ * One request of an access log. The target points into the parsed
+ * line and is not terminated.
+ */
+typedef struct _orclogentry {
+    double time; /**< Seconds since the epoch */
+    char method[ORC_LOG_METHOD_LEN]; /**< Terminated */
+    const char *target; /**< A path or a full url */
+    size_t target_len;
+} orclogentry;
+
+int orclog_parse(enum orc_logformat format, const char *line, size_t len,
+                 orclogentry *entry);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcalias.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* A probability in [0, 1] as a 32 bit threshold */
+static unsigned int to_threshold(double prob) {
+    if (prob >= 1.0) {
+        return 0xffffffffU;
+    }
+    if (prob <= 0.0) {
+        return 0;
+    }
+    return (unsigned int)(prob * 4294967296.0);
+}
+
+/**
+ * Builds an alias table (Vose's method). Weights do not have to sum
+ * to one but must not be negative and at least one must be positive.
+ *
+ * @author Oscar Norlander
+ *
+ * @param table The table to build, free it with orcalias_free.
+ * @param weights The weight of every index.
+ * @param count The number of weights.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcalias_init(orcalias *table, const double *weights, unsigned int count) {
+    unsigned int i;
+    double sum = 0;
+
+    memset(table, 0, sizeof(orcalias));
+    if (0 == count) {
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        if (weights[i] < 0) {
+            orcerror("Negative weight %g at %u\n", weights[i], i);
+            return 0;
+        }
+        sum += weights[i];
+    }
+    if (sum <= 0) {
+        orcerror("All weights are zero\n");
+        return 0;
+    }
+
+    double *scaled = calloc(count, sizeof(double));
+    unsigned int *small = calloc(count, sizeof(unsigned int));
+    unsigned int *large = calloc(count, sizeof(unsigned int));
+    table->entries = calloc(count, sizeof(orcalias_entry));
+    if (0 == scaled || 0 == small || 0 == large || 0 == table->entries) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        free(scaled);
+        free(small);
+        free(large);
+        free(table->entries);
+        table->entries = 0;
+        return 0;
+    }
+
+    unsigned int small_len = 0;
+    unsigned int large_len = 0;
+    for (i = 0; i < count; i++) {
+        scaled[i] = weights[i] * count / sum;
+        if (scaled[i] < 1.0) {
+            small[small_len++] = i;
+        } else {
+            large[large_len++] = i;
+        }
+    }
+
+    /* Fill every small column up to one with a piece of a large one */
+    while (0 < small_len && 0 < large_len) {
+        unsigned int s = small[--small_len];
+        unsigned int l = large[large_len - 1];
+        table->entries[s].threshold = to_threshold(scaled[s]);
+        table->entries[s].alias = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) {
+            large_len--;
+            small[small_len++] = l;
+        }
+    }
+    /* What is left is one up to rounding errors */
+    while (0 < large_len) {
+        unsigned int l = large[--large_len];
+        table->entries[l].threshold = 0xffffffffU;
+        table->entries[l].alias = l;
+    }
+    while (0 < small_len) {
+        unsigned int s = small[--small_len];
+        table->entries[s].threshold = 0xffffffffU;
+        table->entries[s].alias = s;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+    table->count = count;
+    return 1;
+}
+
+/**
+ * Draws an index with the probability of its weight.
+ *
+ * @author Oscar Norlander
+ *
+ * @param table The table.
+ * @param rand The generator of the calling thread.
+ *
+ * @return unsigned int An index in [0, count).
+ */
+unsigned int orcalias_sample(const orcalias *table, orcrand *rand) {
+    unsigned long long r = orcrand_next(rand);
+    /* The high half picks the column, the low half the side */
+    unsigned int i = (unsigned int)(((r >> 32) * table->count) >> 32);
+    const orcalias_entry *entry = &(table->entries[i]);
+    if ((unsigned int)r < entry->threshold) {
+        return i;
+    }
+    return entry->alias;
+}
+
+/**
+ * Frees the memory of a table.
+ *
+ * @author Oscar Norlander
+ *
+ * @param table The table.
+ */
+void orcalias_free(orcalias *table) {
+    free(table->entries);
+    table->entries = 0;
+    table->count = 0;
+}
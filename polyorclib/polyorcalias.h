@@ -0,0 +1,47 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCALIAS_H
+#define POLYORCALIAS_H
+
+#include "polyorcrand.h"
+
+/* One column of the alias table. Column i is picked with equal
+   probability, then i is kept if a 32 bit draw is below threshold,
+   otherwise alias is used. */
+typedef struct _orcalias_entry {
+    unsigned int threshold;
+    unsigned int alias;
+} orcalias_entry;
+
+/**
+ * A Walker/Vose alias table for drawing indexes with given weights
+ * in O(1). The table is read-only after orcalias_init so threads
+ * can share it, each drawing with its own orcrand.
+ */
+typedef struct _orcalias {
+    unsigned int count; /**< The number of weights */
+    orcalias_entry *entries; /**< One column per weight */
+} orcalias;
+
+int orcalias_init(orcalias *table, const double *weights, unsigned int count);
+
+unsigned int orcalias_sample(const orcalias *table, orcrand *rand);
+
+void orcalias_free(orcalias *table);
+
+#endif
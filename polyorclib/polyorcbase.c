@@ -0,0 +1,327 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcbase.h"
+
+#include <string.h>
+
+/* A letter or digit, without looking at the locale */
+static int is_alnum(char c) {
+    return ('a' <= c && 'z' >= c) || ('A' <= c && 'Z' >= c) ||
+           ('0' <= c && '9' >= c);
+}
+
+static int is_hex(char c) {
+    return ('a' <= c && 'f' >= c) || ('A' <= c && 'F' >= c) ||
+           ('0' <= c && '9' >= c);
+}
+
+/* What an ascii character is in a link, 0 not allowed, 1 plain and
+   2 one of / ? # % that need a closer look */
+static const unsigned char uric[128] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 2, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0
+};
+
+static int is_plain_char(char c) {
+    return 0 == (c & 0x80) && 1 == uric[(unsigned char)c];
+}
+
+/* Checks a %XX escape at link[i] */
+static int is_escape(const char *link, size_t len, size_t i) {
+    return i + 2 < len && is_hex(link[i + 1]) && is_hex(link[i + 2]);
+}
+
+/* A . or .. segment from start to end */
+static int is_dots(const char *link, size_t start, size_t end) {
+    return '.' == link[start] && (1 == end - start ||
+                                  (2 == end - start && '.' == link[start + 1]));
+}
+
+/* Checks that link only has characters uriparser takes, at most one #
+   and no . or .. segments, so joining it gives what uriparser would */
+static int is_plain(const char *link, size_t len) {
+    size_t i = 0;
+    size_t segment = 0; /* Where the current segment of the path starts */
+    int fragment = 0;
+    while (1) {
+        while (i < len && is_plain_char(link[i])) {
+            i++;
+        }
+        if (i < len && '%' == link[i]) {
+            if (!is_escape(link, len, i)) {
+                return 0;
+            }
+            i += 3;
+            continue;
+        } else if (i < len && '/' != link[i] && '?' != link[i] &&
+                   '#' != link[i]) {
+            return 0;
+        }
+        /* The end of a segment */
+        if (i > segment && is_dots(link, segment, i)) {
+            return 0;
+        }
+        if (i == len || '/' != link[i]) {
+            break;
+        }
+        segment = ++i;
+    }
+    /* The query and fragment */
+    for (; i < len; i++) {
+        if ('%' == link[i]) {
+            if (!is_escape(link, len, i)) {
+                return 0;
+            }
+            i += 2;
+        } else if ('#' == link[i]) {
+            if (fragment) {
+                return 0;
+            }
+            fragment = 1;
+        } else if ('/' != link[i] && '?' != link[i] &&
+                   !is_plain_char(link[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* The length of the scheme of link with its :, 0 when it has none */
+static size_t scheme_len(const char *link, size_t len) {
+    size_t i;
+    if (0 == len || !(('a' <= link[0] && 'z' >= link[0]) ||
+                      ('A' <= link[0] && 'Z' >= link[0]))) {
+        return 0;
+    }
+    for (i = 1; i < len; i++) {
+        if (':' == link[i]) {
+            return i + 1;
+        } else if (!is_alnum(link[i]) && '+' != link[i] && '-' != link[i] &&
+                   '.' != link[i]) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/* The length of a //host or //host:port that starts link, 0 when there
+   is none or it has a user, an ip v6 address or escapes */
+static size_t authority_len(const char *link, size_t len) {
+    size_t i;
+    size_t port = 0;
+    if (3 > len || '/' != link[0] || '/' != link[1]) {
+        return 0;
+    }
+    for (i = 2; i < len && '/' != link[i] && '?' != link[i] &&
+         '#' != link[i]; i++) {
+        if (':' == link[i] && 0 == port) {
+            port = i;
+        } else if (0 < port ? !('0' <= link[i] && '9' >= link[i]) :
+                   ('@' == link[i] || !is_plain_char(link[i]))) {
+            return 0;
+        }
+    }
+    return (2 == i || 2 == port) ? 0 : i;
+}
+
+/* Writes prefix, a / if slash and link to out */
+static int join(char *out, size_t out_len, const char *prefix,
+                size_t prefix_len, int slash, const char *link, size_t len) {
+    size_t total = prefix_len + slash + len;
+    if (total >= out_len) {
+        return 0;
+    }
+    memcpy(out, prefix, prefix_len);
+    if (slash) {
+        out[prefix_len] = '/';
+    }
+    memcpy(out + prefix_len + slash, link, len);
+    out[total] = '\0';
+    return total;
+}
+
+/* Resolves link with uriparser, the way every link once was */
+static int resolve_uri(orcbase *base, const char *link, size_t len,
+                       char *out, size_t out_len) {
+    UriParserStateA state;
+    UriUriA relative_source;
+    UriUriA absolute_dest;
+    int chars_required;
+    int status = 0;
+
+    if (0 == base->parsed) {
+        state.uri = &(base->uri);
+        if (uriParseUriA(&state, base->url) == URI_SUCCESS) {
+            base->parsed = 1;
+        } else {
+            uriFreeUriMembersA(&(base->uri));
+            base->parsed = -1;
+        }
+    }
+    if (1 != base->parsed) {
+        return 0;
+    }
+
+    state.uri = &relative_source;
+    if (uriParseUriExA(&state, link, link + len) != URI_SUCCESS) {
+        uriFreeUriMembersA(&relative_source);
+        return 0;
+    }
+    if (uriAddBaseUriA(&absolute_dest, &relative_source, &(base->uri)) ==
+            URI_SUCCESS &&
+        uriToStringCharsRequiredA(&absolute_dest, &chars_required) ==
+            URI_SUCCESS &&
+        (size_t)chars_required < out_len &&
+        uriToStringA(out, &absolute_dest, out_len, 0) == URI_SUCCESS)
+    {
+        status = chars_required;
+    }
+    uriFreeUriMembersA(&absolute_dest);
+    uriFreeUriMembersA(&relative_source);
+    return status;
+}
+
+/**
+ * Splits the url of a page so links on it can be resolved. The url must
+ * be kept until the base is freed.
+ *
+ * @author Oscar Norlander
+ *
+ * @param base The base to set up.
+ * @param url The absolute url of the page.
+ */
+void orcbase_init(orcbase *base, const char *url) {
+    size_t len = strlen(url);
+    size_t scheme = scheme_len(url, len);
+    size_t authority = 0;
+    size_t path_end;
+
+    memset(base, 0, sizeof(orcbase));
+    base->url = url;
+    if (0 == scheme || 0 == is_plain(url, len) ||
+        0 == (authority = authority_len(url + scheme, len - scheme))) {
+        return;
+    }
+    base->origin_len = scheme + authority;
+    base->doc_len = strcspn(url, "#");
+    path_end = base->origin_len + strcspn(url + base->origin_len, "?#");
+    base->dir_len = path_end;
+    while (base->dir_len > base->origin_len && '/' != url[base->dir_len - 1]) {
+        base->dir_len--;
+    }
+    base->fast = 1;
+}
+
+/**
+ * Frees what uriparser kept of the url of a base.
+ *
+ * @author Oscar Norlander
+ *
+ * @param base The base to free.
+ */
+void orcbase_free(orcbase *base) {
+    if (1 == base->parsed) {
+        uriFreeUriMembersA(&(base->uri));
+    }
+    base->parsed = 0;
+}
+
+/**
+ * Makes a link found on the page of a base absolute. Absolute urls,
+ * absolute paths, paths in the same or a parent directory and fragments
+ * are joined with the url of the page directly, other links are left to
+ * uriparser.
+ *
+ * @author Oscar Norlander
+ *
+ * @param base The page the link is on.
+ * @param link The link, it does not need to be terminated.
+ * @param len The length of link.
+ * @param out A buffer for the terminated absolute url.
+ * @param out_len The length of out.
+ *
+ * @return int The length of the url, 0 if it can not be resolved or is
+ *             too long for out.
+ */
+int orcbase_resolve(orcbase *base, const char *link, size_t len, char *out,
+                    size_t out_len) {
+    const char *url = base->url;
+    const char *rest = link;
+    size_t rest_len = len;
+    size_t dir = base->dir_len;
+    size_t scheme;
+    size_t colon;
+
+    if (0 == base->fast) {
+        return resolve_uri(base, link, len, out, out_len);
+    }
+    /* Every ../ leaves a directory of the page, but not the root */
+    while (3 <= rest_len && 0 == memcmp(rest, "../", 3)) {
+        if (dir > base->origin_len + 1) {
+            dir--;
+            while ('/' != url[dir - 1]) {
+                dir--;
+            }
+        }
+        rest += 3;
+        rest_len -= 3;
+    }
+    if (0 == is_plain(rest, rest_len)) {
+        return resolve_uri(base, link, len, out, out_len);
+    }
+    if (rest != link) {
+        if (0 < rest_len && '/' == rest[0]) {
+            return resolve_uri(base, link, len, out, out_len);
+        }
+        return join(out, out_len, url, dir, dir == base->origin_len, rest,
+                    rest_len);
+    }
+    if (0 < (scheme = scheme_len(link, len))) {
+        /* Already absolute */
+        if (len > scheme + 1 && '/' == link[scheme] &&
+            '/' == link[scheme + 1] &&
+            0 == authority_len(link + scheme, len - scheme)) {
+            return resolve_uri(base, link, len, out, out_len);
+        }
+        return join(out, out_len, link, 0, 0, link, len);
+    } else if (0 == len || '#' == link[0]) {
+        /* The page itself */
+        return join(out, out_len, url, base->doc_len, 0, link, len);
+    } else if ('/' == link[0]) {
+        /* An absolute path, but not one with a host */
+        if (1 < len && '/' == link[1]) {
+            return resolve_uri(base, link, len, out, out_len);
+        }
+        return join(out, out_len, url, base->origin_len, 0, link, len);
+    } else if ('?' == link[0]) {
+        return resolve_uri(base, link, len, out, out_len);
+    }
+    /* A path in the same directory, a : before any / is not allowed */
+    for (colon = 0; colon < len && '/' != link[colon] && '?' != link[colon] &&
+         '#' != link[colon] && ':' != link[colon]; colon++);
+    if (colon < len && ':' == link[colon]) {
+        return resolve_uri(base, link, len, out, out_len);
+    }
+    return join(out, out_len, url, dir, dir == base->origin_len, link, len);
+}
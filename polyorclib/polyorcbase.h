@@ -0,0 +1,47 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCBASE_H
+#define POLYORCBASE_H
+
+#include <stddef.h>
+#include <uriparser/Uri.h>
+
+/**
+ * The url of a page, split once so the links on it can be made absolute
+ * without parsing it again. Plain links are joined with a part of the
+ * url, other links are resolved by uriparser against uri, which is
+ * parsed the first time it is needed.
+ */
+typedef struct _orcbase {
+    const char *url; /**< The page, kept by the caller */
+    size_t origin_len; /**< The scheme and authority of url */
+    size_t dir_len; /**< Up to and with the last / of the path */
+    size_t doc_len; /**< Without the fragment */
+    int fast; /**< 1 when url is plain enough to join links with */
+    int parsed; /**< 1 when uri holds url, -1 when url can not be parsed */
+    UriUriA uri; /**< url parsed by uriparser */
+} orcbase;
+
+void orcbase_init(orcbase *base, const char *url);
+
+void orcbase_free(orcbase *base);
+
+int orcbase_resolve(orcbase *base, const char *link, size_t len, char *out,
+                    size_t out_len);
+
+#endif
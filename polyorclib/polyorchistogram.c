@@ -0,0 +1,193 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorchistogram.h"
+
+#include <string.h>
+
+/**
+ * Empties a histogram.
+ *
+ * @author Oscar Norlander
+ *
+ * @param hist The histogram.
+ */
+void orchist_reset(orchistogram *hist) {
+    memset(hist, 0, sizeof(orchistogram));
+}
+
+/**
+ * Returns the bucket a value is counted in.
+ *
+ * @author Oscar Norlander
+ *
+ * @param value The value.
+ *
+ * @return int A bucket index in [0, ORC_HIST_BUCKETS).
+ */
+int orchist_index(unsigned long long value) {
+    if (value < ORC_HIST_SUB_COUNT) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= ORC_HIST_MAX_BITS) {
+        return ORC_HIST_BUCKETS - 1;
+    }
+    int shift = msb - ORC_HIST_SUB_BITS;
+    return (shift + 1) * ORC_HIST_SUB_COUNT +
+        (int)((value >> shift) - ORC_HIST_SUB_COUNT);
+}
+
+/**
+ * Returns the smallest value counted in a bucket.
+ *
+ * @author Oscar Norlander
+ *
+ * @param index The bucket index.
+ *
+ * @return unsigned long long
+ */
+unsigned long long orchist_bucket_low(int index) {
+    int shift = index >> ORC_HIST_SUB_BITS;
+    if (0 == shift) {
+        return index;
+    }
+    return ((unsigned long long)(index & (ORC_HIST_SUB_COUNT - 1)) +
+            ORC_HIST_SUB_COUNT) << (shift - 1);
+}
+
+/**
+ * Returns the largest value counted in a bucket.
+ *
+ * @author Oscar Norlander
+ *
+ * @param index The bucket index.
+ *
+ * @return unsigned long long
+ */
+unsigned long long orchist_bucket_high(int index) {
+    int shift = index >> ORC_HIST_SUB_BITS;
+    if (0 == shift) {
+        return index;
+    }
+    return orchist_bucket_low(index) + (1ULL << (shift - 1)) - 1;
+}
+
+/**
+ * Records a value.
+ *
+ * @author Oscar Norlander
+ *
+ * @param hist The histogram.
+ * @param value The value.
+ */
+void orchist_record(orchistogram *hist, unsigned long long value) {
+    if (0 == hist->count || value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->count++;
+    hist->sum += value;
+    hist->buckets[orchist_index(value)]++;
+}
+
+/**
+ * Adds all values recorded in src to dst.
+ *
+ * @author Oscar Norlander
+ *
+ * @param dst The histogram that is updated.
+ * @param src The histogram that is added.
+ */
+void orchist_merge(orchistogram *dst, const orchistogram *src) {
+    int i;
+    if (0 == src->count) {
+        return;
+    }
+    if (0 == dst->count || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    for (i = 0; i < ORC_HIST_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+/**
+ * Returns the value at a percentile, for example 99.9. The result
+ * is the upper limit of the bucket that holds the percentile but
+ * never more than the largest recorded value.
+ *
+ * @author Oscar Norlander
+ *
+ * @param hist The histogram.
+ * @param percentile A percentile in [0, 100].
+ *
+ * @return unsigned long long 0 if the histogram is empty.
+ */
+unsigned long long orchist_percentile(const orchistogram *hist,
+                                      double percentile) {
+    int i;
+    if (0 == hist->count) {
+        return 0;
+    }
+    if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    unsigned long long rank =
+        (unsigned long long)((percentile / 100.0) * hist->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    unsigned long long seen = 0;
+    for (i = 0; i < ORC_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            unsigned long long high = orchist_bucket_high(i);
+            if (high > hist->max) {
+                return hist->max;
+            }
+            if (high < hist->min) {
+                return hist->min;
+            }
+            return high;
+        }
+    }
+    return hist->max;
+}
+
+/**
+ * Returns the mean of the recorded values.
+ *
+ * @author Oscar Norlander
+ *
+ * @param hist The histogram.
+ *
+ * @return double 0 if the histogram is empty.
+ */
+double orchist_mean(const orchistogram *hist) {
+    if (0 == hist->count) {
+        return 0;
+    }
+    return (double)hist->sum / (double)hist->count;
+}
@@ -0,0 +1,63 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCHISTOGRAM_H
+#define POLYORCHISTOGRAM_H
+
+/* Every power of two range is split in 2^ORC_HIST_SUB_BITS linear buckets,
+   which keeps the relative error of a recorded value below 1/32 */
+#define ORC_HIST_SUB_BITS 5
+#define ORC_HIST_SUB_COUNT (1 << ORC_HIST_SUB_BITS)
+
+/* Values from 0 to 2^ORC_HIST_MAX_BITS - 1 are tracked, larger values are
+   counted in the last bucket. For microseconds that is about 71 minutes. */
+#define ORC_HIST_MAX_BITS 32
+
+#define ORC_HIST_BUCKETS \
+    ((ORC_HIST_MAX_BITS - ORC_HIST_SUB_BITS + 1) * ORC_HIST_SUB_COUNT)
+
+/**
+ * A log-linear (HDR style) histogram. It has a fixed size and
+ * recording never allocates, so it can live in shared memory.
+ * Histograms with the same layout are merged by adding buckets.
+ */
+typedef struct _orchistogram {
+    unsigned long long count; /**< Number of recorded values */
+    unsigned long long sum; /**< Sum of recorded values */
+    unsigned long long min; /**< Smallest value, valid if count > 0 */
+    unsigned long long max; /**< Largest value */
+    unsigned long long buckets[ORC_HIST_BUCKETS]; /**< Value counts */
+} orchistogram;
+
+void orchist_reset(orchistogram *hist);
+
+int orchist_index(unsigned long long value);
+
+unsigned long long orchist_bucket_low(int index);
+
+unsigned long long orchist_bucket_high(int index);
+
+void orchist_record(orchistogram *hist, unsigned long long value);
+
+void orchist_merge(orchistogram *dst, const orchistogram *src);
+
+unsigned long long orchist_percentile(const orchistogram *hist,
+                                      double percentile);
+
+double orchist_mean(const orchistogram *hist);
+
+#endif
@@ -16,7 +16,9 @@
 */
 
 #include "polyorcmatcher.h"
+#include "polyorcscan.h"
 #include "polyorcout.h"
+#include "polyorcdefs.h"
 
 #include <stdlib.h>
 #include <sys/types.h>
@@ -27,7 +29,6 @@
 #include <arpa/inet.h>
 #include <arpa/inet.h>
 #include <stdio.h>
-#include <uriparser/Uri.h>
 
 /* Prints regexp errors */
 void _orc_match_regerror(int errcode, const regex_t *preg, const char *pattern)
@@ -136,126 +137,61 @@ int find_search_name(const char *url, char *out, size_t out_len) {
     return 0;
 }
 
-/* Applies the exclude patterns
-   returns 1 == exclude
-           0 == include
-          -1 == error
-   */
-int is_excluded(const char* url, const find_urls_input* input) {
-    /* Apply exclude patterns */
-    int j = 0;
-    regex_t regex_exclude;
-    int status_exclude;
-    int exclude = 0;
-    while (input->excludes_len > j && !exclude) {
-        status_exclude = regcomp(&regex_exclude, input->excludes[j],
-                                 REG_EXTENDED);
-        if (0 != status_exclude) {
-            _orc_match_regerror(status_exclude, &regex_exclude,
-                                input->excludes[j]);
-            regfree(&regex_exclude);
-            return -1;
-        }
-        status_exclude = regexec(&regex_exclude, url, 0, 0, 0);
-        if (0 == status_exclude) {
-            exclude = 1;
-        } else if (REG_NOMATCH != status_exclude) {
-            _orc_match_regerror(status_exclude, &regex_exclude,
-                                input->excludes[j]);
-            regfree(&regex_exclude);
-            return -1;
-        }
-        regfree(&regex_exclude);
-        j++;
-    }
-    return exclude;
-}
-
-/* Fixes urls by adding missing parts like domain and making them absolute.
-   returns 1 == exclude
-           0 == include
+/* Makes a link absolute in out and decides if it is on the search name
+   returns 1 == intra domain
+           0 == not intra domain or not an url
           -1 == error
 */
-int fix_url(char **url, const find_urls_input* input ) {
-    UriParserStateA state;
-    UriUriA absolute_dest;
-    UriUriA relative_source;
-    UriUriA absolute_base;
-
-    /* make str to uri */
-    state.uri = &relative_source;
-    if (uriParseUriA(&state, (*url)) != URI_SUCCESS) {
-        uriFreeUriMembersA(&relative_source);
-        return 0;
-    }
+int fix_url(char *out, size_t out_len, orcbase *base, const char *link,
+            size_t len, const orcmatcher* matcher) {
+    regmatch_t pmatch[2];
+    int status;
 
-    /* make str to uri */
-    state.uri = &absolute_base;
-    if (uriParseUriA(&state, input->url) != URI_SUCCESS) {
-        uriFreeUriMembersA(&relative_source);
-        uriFreeUriMembersA(&absolute_base);
+    /* For example "../TWO" on "http://example.com/one/two/three" gives
+       "http://example.com/one/TWO" */
+    if (0 == orcbase_resolve(base, link, len, out, out_len)) {
+        snprintf(out, out_len, "%.*s", (int)len, link);
         return 0;
     }
 
-    /* make realative url to absolute url etc.
-       relative_source holds for example "../TWO" now
-       absolute_base holds for example "http://example.com/one/two/three" now
-     */
-    if (uriAddBaseUriA(&absolute_dest, &relative_source, &absolute_base) != URI_SUCCESS) {
-        uriFreeUriMembersA(&absolute_dest);
-        uriFreeUriMembersA(&relative_source);
-        uriFreeUriMembersA(&absolute_base);
-        return 0;
+    /* Decide if this url is intra domain */
+    if (REG_NOMATCH != (status = regexec(&(matcher->domain), out, 2,
+                                         pmatch, 0))) {
+        if (0 != status) {
+            _orc_match_regerror(status, &(matcher->domain),
+                                matcher->domain_pattern);
+            return -1;
+        }
+        /* Yes, the url is intra domain url */
+        return 1;
     }
-    /* absolute_dest holds for example "http://example.com/one/TWO" now */
 
-    char * uriString;
-    int charsRequired;
-
-    /* Get length of new url */
-    if (uriToStringCharsRequiredA(&absolute_dest, &charsRequired) != URI_SUCCESS) {
-        uriFreeUriMembersA(&absolute_dest);
-        uriFreeUriMembersA(&relative_source);
-        uriFreeUriMembersA(&absolute_base);
-        return 0;
-    }
-    charsRequired++;
+    /* No, the url is not intra domain url */
+    return 0;
+}
 
-    /* Get new url */
-    uriString = calloc(charsRequired, sizeof(char));
-    if (uriString == NULL) {
-        uriFreeUriMembersA(&absolute_dest);
-        uriFreeUriMembersA(&relative_source);
-        uriFreeUriMembersA(&absolute_base);
-        return 0;
-    }
-    if (uriToStringA(uriString, &absolute_dest, charsRequired, NULL) != URI_SUCCESS) {
-        uriFreeUriMembersA(&absolute_dest);
-        uriFreeUriMembersA(&relative_source);
-        uriFreeUriMembersA(&absolute_base);
-        free(uriString);
-        return 0;
-    }
-    free(*url);
-    (*url) = uriString;
-    uriFreeUriMembersA(&absolute_dest);
-    uriFreeUriMembersA(&relative_source);
-    uriFreeUriMembersA(&absolute_base);
+/* Builds the pattern of urls on the search name, with its dots escaped */
+static char * domain_pattern(const find_urls_input *input) {
+    size_t search_len = strnlen(input->search_name, input->search_name_len);
 
     /* Count dots in domain */
-    int i = 0;
-    int append = 0;
-    for (i=0; i < input->search_name_len; i++) {
+    size_t i = 0;
+    size_t append = 0;
+    for (i = 0; i < search_len; i++) {
         if ('.' == input->search_name[i]) {
             append++;
         }
     }
     /* Terminate the dots */
-    int name_len = input->search_name_len + append + 1;
-    char *name = calloc(name_len , sizeof(char));
+    size_t name_len = search_len + append + 1;
+    char *name = calloc(name_len, sizeof(char));
+    if (0 == name) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        return 0;
+    }
+    size_t j = 0;
     i = 0;
-    int j = 0;
-    while (j < input->search_name_len) {
+    while (j < search_len) {
         if ('.' == input->search_name[j]) {
             name[i] = '\\';
             i++;
@@ -268,140 +204,199 @@ int fix_url(char **url, const find_urls_input* input ) {
 
     /* Create search pattern for domain url */
     const char *pattern_format =
-        "%s(:[[:digit:]]{1,5})?/.*|%s(:[[:digit:]]{1,5})?$\0";
-    int find_pattern_len = strlen(pattern_format) + (name_len * 2) + 1;
+        "%s(:[[:digit:]]{1,5})?/.*|%s(:[[:digit:]]{1,5})?$";
+    size_t find_pattern_len = strlen(pattern_format) + (name_len * 2) + 1;
     char *find_pattern = calloc(find_pattern_len, sizeof(char));
-    snprintf(find_pattern, find_pattern_len, pattern_format, name, name);
+    if (0 != find_pattern) {
+        snprintf(find_pattern, find_pattern_len, pattern_format, name, name);
+    } else {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+    }
     free(name);
+    return find_pattern;
+}
 
-    regex_t regex;
-    regmatch_t pmatch[2];
-    int status;
+/* Compiles a pattern and prints why if it can not be */
+static int compile(regex_t *regex, const char *pattern, int cflags) {
+    int status = regcomp(regex, pattern, cflags);
+    if (0 != status) {
+        _orc_match_regerror(status, regex, pattern);
+        regfree(regex);
+        return 0;
+    }
+    return 1;
+}
 
-    /* Decide if this url is intra domain */
-    if (0 != (status = regcomp(&regex, find_pattern,
-                               REG_ICASE | REG_EXTENDED)))
-    {
-        _orc_match_regerror(status, &regex, find_pattern);
-        regfree(&regex);
-        return -1;
+/**
+ * Compiles the domain, exclude and include patterns of an input once, so
+ * pages and links are matched without compiling anything. The input
+ * must keep its patterns while the matcher is used.
+ *
+ * @author Oscar Norlander
+ *
+ * @param matcher The matcher to set up.
+ * @param input The search name, exclude and include patterns to use.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcmatcher_init(orcmatcher *matcher, const find_urls_input *input) {
+    memset(matcher, 0, sizeof(orcmatcher));
+    matcher->domain_pattern = domain_pattern(input);
+    if (0 == matcher->domain_pattern ||
+        0 == compile(&(matcher->domain), matcher->domain_pattern,
+                     REG_ICASE | REG_EXTENDED)) {
+        free(matcher->domain_pattern);
+        matcher->domain_pattern = 0;
+        return 0;
     }
-    if (REG_NOMATCH != (status = regexec(&regex, (*url), 2, pmatch, 0))) {
-        if (0 != status) {
-            _orc_match_regerror(status, &regex, find_pattern);
-            regfree(&regex);
-            free(find_pattern);
+    if (0 == orcrules_init(&(matcher->rules), input->excludes,
+                           input->excludes_len, input->includes,
+                           input->includes_len)) {
+        orcmatcher_free(matcher);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Frees the compiled patterns of a matcher.
+ *
+ * @author Oscar Norlander
+ *
+ * @param matcher The matcher to free.
+ */
+void orcmatcher_free(orcmatcher *matcher) {
+    if (0 == matcher->domain_pattern) {
+        return;
+    }
+    regfree(&(matcher->domain));
+    free(matcher->domain_pattern);
+    orcrules_free(&(matcher->rules));
+    memset(matcher, 0, sizeof(orcmatcher));
+}
+
+/**
+ * Makes a link found on the page of base absolute and decides if the
+ * spider should follow it, it must be on the search name and not be
+ * excluded, see orcrules_excluded. Only urls to follow are allocated.
+ *
+ * @author Oscar Norlander
+ *
+ * @param matcher The compiled patterns.
+ * @param base The page the link is on.
+ * @param link The link as found on the page.
+ * @param len The length of link, it does not need to be terminated.
+ * @param url Set to the absolute url to follow, free it after use.
+ *
+ * @return int 1 to follow, 0 to leave it and -1 on fail.
+ */
+int orcmatcher_check_url(orcmatcher *matcher, orcbase *base,
+                         const char *link, size_t len, char **url)
+{
+    int status;
+    char str[MAX_URL_LEN + 1];
+
+    int exclude = 1;
+    if (0 != (status = fix_url(str, sizeof(str), base, link, len, matcher))) {
+        if (-1 == status) {
+            return -1;
+        }
+        exclude = orcrules_excluded(&(matcher->rules), str);
+        if (-1 == exclude) {
             return -1;
         }
-        free(find_pattern);
-        regfree(&regex);
-        /* Yes, the url is intra domain url */
-        return 1;
     }
-    free(find_pattern);
-    regfree(&regex);
-
 
-    /* No, the url is not intra domain url */
-    return 0;
+    /* Execute include or exclude */
+    if (exclude) {
+        orcstatus(orcm_verbose, orc_yellow, "exclude", "%s\n", str);
+        return 0;
+    }
+    size_t str_len = strlen(str);
+    if (0 == ((*url) = malloc(str_len + 1))) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        return -1;
+    }
+    memcpy((*url), str, str_len + 1);
+    return 1;
 }
 
 /**
  * Searches a buffer for html links by looking for href and src
- * attributes.
+ * attributes in one pass, see orcscan_next. The links are checked with
+ * patterns compiled by orcmatcher_init.
  *
  * @author Oscar Norlander
  *
+ * @param matcher The compiled patterns.
  * @param html The buffer containing html.
  * @param input See find_urls_input.
  *
- * @return int The number of urls found.
+ * @return int The number of urls found, -1 on fail.
  */
-int find_urls(char *html, find_urls_input* input)
+int orcmatcher_find_urls(orcmatcher *matcher, char *html,
+                         find_urls_input *input)
 {
-    const char *find_patterns[] = {
-        "href[:space:]*=[:space:]*\"[:space:]*([^\"]*)\"",
-        "href[:space:]*=[:space:]*'[:space:]*([^']*)'",
-        "src[:space:]*=[:space:]*\"[:space:]*([^\"]*)\"",
-        "src[:space:]*=[:space:]*'[:space:]*([^']*)'",
-        0
-    };
-
-    const char *find_pattern = 0;
-    int i = 0;
     int url_count = 0;
-    while (0 != (find_pattern = find_patterns[i])) {
-        /* Last match pointer that points directly after last match */
-        char *current = html; /* Restet last match pointer */
-
-        regex_t regex;
-        regmatch_t pmatch[2];
-        int status;
-
-        if (0 != (status = regcomp(&regex, find_pattern,
-                                   REG_ICASE | REG_EXTENDED)))
-        {
-            _orc_match_regerror(status, &regex, find_pattern);
-            regfree(&regex);
-            return -1;
-        }
-
-        /* Find all links */
-        while (REG_NOMATCH != (status = regexec(&regex, current, 2, pmatch, 0)))
-        {
-            if (0 != status) {
-                _orc_match_regerror(status, &regex, find_pattern);
-                regfree(&regex);
-                return -1;
-            }
-            /* Copy links and move on */
-            size_t str_len = (pmatch[1].rm_eo - pmatch[1].rm_so) + 1;
-            char *str = calloc(str_len, sizeof(char));
-            strncpy(str, &(current[pmatch[1].rm_so]), str_len);
-            str[str_len - 1] = '\0';
-            current = &(current[pmatch[1].rm_eo]);
-
-            int exclude = 1;
-            if (0 != (status = fix_url(&str, input))) {
-                if (-1 == status) {
-                    regfree(&regex);
-                    return -1;
-                }
-                exclude = is_excluded(str, input);
-                if (-1 == exclude) {
-                    regfree(&regex);
+    int status;
+    char *str;
+    orcscanner scan;
+    orclink link;
+    orcbase base;
+
+    /* The url of the page is split once for all its links */
+    orcbase_init(&base, input->url);
+    orcscan_init(&scan, html, strlen(html));
+    while (orcscan_next(&scan, &link)) {
+        status = orcmatcher_check_url(matcher, &base, link.start, link.len,
+                                      &str);
+        if (-1 == status) {
+            url_count = -1;
+            break;
+        } else if (1 == status) {
+            /* Add to result */
+            url_count++;
+            char **tmp = 0;
+            if (url_count  > input->ret_len) {
+                tmp = realloc((input->ret), url_count * sizeof(char *));
+                if (0 == tmp) {
+                    orcerror("%s (%d)\n", strerror(errno), errno);
                     free(str);
-                    return -1;
+                    url_count = -1;
+                    break;
                 }
-            }
-
-            /* Execute include or exclude */
-            if (exclude) {
-                orcstatus(orcm_verbose, orc_yellow, "exclude", "%s\n", str);
-                free(str);
+                input->ret_len = url_count;
+                input->ret = tmp;
             } else {
-                /* Add to result */
-                url_count++;
-                char **tmp = 0;
-                if (url_count  > input->ret_len) {
-                    tmp = realloc((input->ret), url_count * sizeof(char *));
-                    if (0 == tmp) {
-                        orcerror("%s (%d)\n", strerror(errno), errno);
-                        regfree(&regex);
-                        free(str);
-                        return -1;
-                    }
-                    input->ret_len = url_count;
-                    input->ret = tmp;
-                } else {
-                    tmp = input->ret;
-                }
-                tmp[url_count - 1] = str;
+                tmp = input->ret;
             }
+            tmp[url_count - 1] = str;
         }
-        regfree(&regex);
-        i++;
     }
 
+    orcbase_free(&base);
+    return url_count;
+}
+
+/**
+ * Searches a buffer for html links by looking for href and src
+ * attributes. Compiles all patterns for this page only, use a matcher
+ * and orcmatcher_find_urls for more pages.
+ *
+ * @author Oscar Norlander
+ *
+ * @param html The buffer containing html.
+ * @param input See find_urls_input.
+ *
+ * @return int The number of urls found.
+ */
+int find_urls(char *html, find_urls_input* input)
+{
+    orcmatcher matcher;
+    if (0 == orcmatcher_init(&matcher, input)) {
+        return -1;
+    }
+    int url_count = orcmatcher_find_urls(&matcher, html, input);
+    orcmatcher_free(&matcher);
     return url_count;
 }
@@ -18,7 +18,12 @@
 #ifndef POLYORCMATCHER_H
 #define POLYORCMATCHER_H
 
+#include "polyorcbase.h"
+#include "polyorcrules.h"
+
 #include <stdlib.h>
+#include <sys/types.h>
+#include <regex.h>
 
 /**
  * A structure that is used for collecting input when analyzing
@@ -30,12 +35,34 @@ typedef struct _find_urls_input {
     char *url; /**< The curl of the analyzed html document */
     char **excludes; /**< Regex exclude patterns */
     int excludes_len; /**<  The number of exclude patterns */
+    char **includes; /**< Regex include patterns, urls must match one */
+    int includes_len; /**< The number of include patterns */
     char **ret; /**< The return buffer */
     int ret_len; /**< The max number of items in the return */
 } find_urls_input;
 
+/**
+ * The patterns find_urls needs, compiled once for a whole crawl from the
+ * search name, exclude and include patterns of a find_urls_input.
+ */
+typedef struct _orcmatcher {
+    regex_t domain; /**< Matches urls of the search name */
+    char *domain_pattern; /**< The source of domain, for errors */
+    orcrules rules; /**< The exclude and include patterns */
+} orcmatcher;
+
 int find_search_name(const char *url, char *out, size_t out_len);
 
+int orcmatcher_init(orcmatcher *matcher, const find_urls_input *input);
+
+void orcmatcher_free(orcmatcher *matcher);
+
+int orcmatcher_check_url(orcmatcher *matcher, orcbase *base,
+                         const char *link, size_t len, char **url);
+
+int orcmatcher_find_urls(orcmatcher *matcher, char *html,
+                         find_urls_input *input);
+
 int find_urls(char *html, find_urls_input* input);
 
 #endif
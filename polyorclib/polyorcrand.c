@@ -0,0 +1,117 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcrand.h"
+
+#include <math.h>
+
+static unsigned long long rotl(const unsigned long long x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/* Used to spread a single seed over the whole state */
+static unsigned long long splitmix64(unsigned long long *x) {
+    unsigned long long z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seeds a generator. Two generators seeded with the same value
+ * produce the same sequence.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rand The generator to seed.
+ * @param seed Any value, zero included.
+ */
+void orcrand_seed(orcrand *rand, unsigned long long seed) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        rand->s[i] = splitmix64(&seed);
+    }
+}
+
+/**
+ * Returns the next 64 bit number from the generator.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rand The generator.
+ *
+ * @return unsigned long long
+ */
+unsigned long long orcrand_next(orcrand *rand) {
+    unsigned long long *s = rand->s;
+    const unsigned long long result = rotl(s[1] * 5, 7) * 9;
+    const unsigned long long t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Returns a uniformly distributed double in [0, 1).
+ *
+ * @author Oscar Norlander
+ *
+ * @param rand The generator.
+ *
+ * @return double
+ */
+double orcrand_double(orcrand *rand) {
+    return (orcrand_next(rand) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Returns a uniformly distributed integer in [0, n). n must be
+ * larger than 0.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rand The generator.
+ * @param n The upper limit (exclusive).
+ *
+ * @return unsigned int
+ */
+unsigned int orcrand_range(orcrand *rand, unsigned int n) {
+    /* Multiply and shift, the bias is negligible for 32 bit ranges */
+    return (unsigned int)(((orcrand_next(rand) >> 32) * n) >> 32);
+}
+
+/**
+ * Returns an exponentially distributed value, used for the time
+ * between arrivals in a Poisson process.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rand The generator.
+ * @param mean The mean of the distribution.
+ *
+ * @return double
+ */
+double orcrand_exp(orcrand *rand, double mean) {
+    /* 1 - u is in (0, 1] so log never sees zero */
+    return -mean * log(1.0 - orcrand_double(rand));
+}
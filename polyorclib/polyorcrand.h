@@ -0,0 +1,39 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCRAND_H
+#define POLYORCRAND_H
+
+/**
+ * A small pseudo random generator (xoshiro256**). Every thread keeps its own
+ * state so drawing numbers never touches the lock inside random().
+ */
+typedef struct _orcrand {
+    unsigned long long s[4]; /**< Generator state, never all zero */
+} orcrand;
+
+void orcrand_seed(orcrand *rand, unsigned long long seed);
+
+unsigned long long orcrand_next(orcrand *rand);
+
+double orcrand_double(orcrand *rand);
+
+unsigned int orcrand_range(orcrand *rand, unsigned int n);
+
+double orcrand_exp(orcrand *rand, double mean);
+
+#endif
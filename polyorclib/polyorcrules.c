@@ -0,0 +1,542 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcrules.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Longer literals are cut, a part of a literal is needed as well */
+#define LITERAL_MAX 64
+
+/* Literals of which every match of a pattern holds at least one, none
+   when the pattern may match without any */
+typedef struct _litset {
+    char **lits;
+    int count;
+} litset;
+
+/* Prints regexp errors */
+static void print_regerror(int errcode, const regex_t *preg,
+                           const char *pattern) {
+    size_t errbuff_len = regerror(errcode, preg, 0, 0);
+    char *errbuff = calloc(errbuff_len, sizeof(char));
+    if (0 != errbuff) {
+        regerror(errcode, preg, errbuff, errbuff_len);
+        orcerror("%s 'regexp: %s'\n", errbuff, pattern);
+        free(errbuff);
+    }
+}
+
+static void litset_free(litset *set) {
+    int i;
+    for (i = 0; i < set->count; i++) {
+        free(set->lits[i]);
+    }
+    free(set->lits);
+    memset(set, 0, sizeof(litset));
+}
+
+/* Adds the first len bytes of lit, a set that runs out of memory is
+   emptied which only means its pattern is run for every url */
+static void litset_add(litset *set, const char *lit, size_t len) {
+    char **tmp = realloc(set->lits, (set->count + 1) * sizeof(char *));
+    char *copy = malloc(len + 1);
+    if (0 == tmp || 0 == copy) {
+        free(copy);
+        if (0 != tmp) {
+            set->lits = tmp;
+        }
+        litset_free(set);
+        return;
+    }
+    memcpy(copy, lit, len);
+    copy[len] = '\0';
+    tmp[set->count++] = copy;
+    set->lits = tmp;
+}
+
+/* Moves the literals of from to to */
+static void litset_move(litset *to, litset *from) {
+    char **tmp = realloc(to->lits, (to->count + from->count) * sizeof(char *));
+    if (0 == tmp) {
+        litset_free(to);
+        litset_free(from);
+        return;
+    }
+    memcpy(tmp + to->count, from->lits, from->count * sizeof(char *));
+    to->lits = tmp;
+    to->count += from->count;
+    free(from->lits);
+    memset(from, 0, sizeof(litset));
+}
+
+/* The length of the shortest literal, what makes a set worth using */
+static size_t litset_score(const litset *set) {
+    int i;
+    size_t score = 0;
+    for (i = 0; i < set->count; i++) {
+        size_t len = strlen(set->lits[i]);
+        if (0 == i || len < score) {
+            score = len;
+        }
+    }
+    return score;
+}
+
+/* Keeps the better of best and candidate in best */
+static void consider(litset *best, litset *candidate) {
+    if (0 < candidate->count &&
+        (0 == best->count || litset_score(candidate) > litset_score(best))) {
+        litset_free(best);
+        (*best) = (*candidate);
+        memset(candidate, 0, sizeof(litset));
+    } else {
+        litset_free(candidate);
+    }
+}
+
+/* Offers the literal collected so far to best */
+static void flush(litset *best, const char *run, size_t *run_len) {
+    litset candidate;
+    if (0 < (*run_len)) {
+        memset(&candidate, 0, sizeof(litset));
+        litset_add(&candidate, run, *run_len);
+        consider(best, &candidate);
+        (*run_len) = 0;
+    }
+}
+
+/* Skips a bracket expression, like []a[:digit:]] */
+static size_t skip_bracket(const char *p, size_t i) {
+    i++;
+    if ('^' == p[i]) {
+        i++;
+    }
+    if (']' == p[i]) {
+        i++;
+    }
+    while ('\0' != p[i] && ']' != p[i]) {
+        if ('[' == p[i] && '\0' != p[i + 1] && 0 != strchr(":=.", p[i + 1])) {
+            char kind = p[i + 1];
+            i += 2;
+            while ('\0' != p[i] && !(kind == p[i] && ']' == p[i + 1])) {
+                i++;
+            }
+            if ('\0' != p[i]) {
+                i += 2;
+            }
+        } else {
+            i++;
+        }
+    }
+    return ('\0' == p[i]) ? i : i + 1;
+}
+
+static void parse_alternatives(const char *p, size_t *i, litset *set);
+
+/* Skips the repetition operators from p[*i], like +? or {2,3}*. Returns 1
+   if the repeated atom can be absent, anything but + alone allows that. */
+static int skip_repetition(const char *p, size_t *i) {
+    int optional = 0;
+    while ('?' == p[*i] || '*' == p[*i] || '+' == p[*i] || '{' == p[*i]) {
+        char c = p[(*i)++];
+        if ('+' != c) {
+            optional = 1;
+        }
+        while ('{' == c && '\0' != p[*i] && '}' != p[(*i)++]);
+    }
+    return optional;
+}
+
+/* Finds the best literals of the branch from p[*i] to the next | or ).
+   Only what is certainly needed is taken, a literal or group that can be
+   repeated zero times is dropped and escapes of letters and digits,
+   brackets, anchors and . end a literal. */
+static void parse_branch(const char *p, size_t *i, litset *best) {
+    char run[LITERAL_MAX];
+    size_t run_len = 0;
+    litset group;
+    memset(best, 0, sizeof(litset));
+    while ('\0' != p[*i] && '|' != p[*i] && ')' != p[*i]) {
+        char c = p[*i];
+        if ('(' == c) {
+            flush(best, run, &run_len);
+            (*i)++;
+            parse_alternatives(p, i, &group);
+            if (')' == p[*i]) {
+                (*i)++;
+            }
+            if (skip_repetition(p, i)) {
+                litset_free(&group);
+            } else {
+                consider(best, &group);
+            }
+        } else if ('\\' == c) {
+            char escaped = p[*i + 1];
+            if ('\0' == escaped || ('a' <= escaped && 'z' >= escaped) ||
+                ('A' <= escaped && 'Z' >= escaped) ||
+                ('0' <= escaped && '9' >= escaped)) {
+                flush(best, run, &run_len);
+            } else if (run_len < LITERAL_MAX) {
+                run[run_len++] = escaped;
+            }
+            (*i) += ('\0' == escaped) ? 1 : 2;
+        } else if ('[' == c) {
+            flush(best, run, &run_len);
+            (*i) = skip_bracket(p, *i);
+        } else if ('.' == c || '^' == c || '$' == c) {
+            flush(best, run, &run_len);
+            (*i)++;
+        } else if ('?' == c || '*' == c || '+' == c || '{' == c) {
+            if (skip_repetition(p, i) && 0 < run_len) {
+                run_len--;
+            }
+            flush(best, run, &run_len);
+        } else {
+            if (run_len < LITERAL_MAX) {
+                run[run_len++] = c;
+            }
+            (*i)++;
+        }
+    }
+    flush(best, run, &run_len);
+}
+
+/* Finds the literals of the alternatives from p[*i] to the closing ) or
+   the end, the best of every branch */
+static void parse_alternatives(const char *p, size_t *i, litset *set) {
+    int none = 0;
+    litset branch;
+    memset(set, 0, sizeof(litset));
+    while (1) {
+        parse_branch(p, i, &branch);
+        if (0 == branch.count) {
+            none = 1;
+        }
+        if (none) {
+            litset_free(&branch);
+        } else {
+            litset_move(set, &branch);
+            none = (0 == set->count);
+        }
+        if ('|' != p[*i]) {
+            break;
+        }
+        (*i)++;
+    }
+    if (none) {
+        litset_free(set);
+    }
+}
+
+/* Builds the automaton of the literals of all patterns, every node gets
+   a next node for every class so the pass never looks back */
+static int build(orcrules *rules, litset *sets, int len) {
+    int k, j;
+    size_t i;
+    size_t nodes = 1;
+    size_t cap = 1;
+    int hit_count = 0;
+    int class_count = 1;
+    for (k = 0; k < len; k++) {
+        for (j = 0; j < sets[k].count; j++) {
+            const unsigned char *lit = (const unsigned char *)sets[k].lits[j];
+            for (i = 0; '\0' != lit[i]; i++) {
+                if (0 == rules->classes[lit[i]]) {
+                    rules->classes[lit[i]] = class_count++;
+                }
+            }
+            cap += i;
+            hit_count++;
+        }
+    }
+    if (0 == hit_count) {
+        return 1;
+    }
+    rules->class_count = class_count;
+    rules->next = malloc(cap * class_count * sizeof(int));
+    rules->hits = malloc(cap * sizeof(int));
+    rules->dict = malloc(cap * sizeof(int));
+    rules->hit_pattern = malloc(hit_count * sizeof(int));
+    rules->hit_next = malloc(hit_count * sizeof(int));
+    int *fail = malloc(cap * sizeof(int));
+    int *queue = malloc(cap * sizeof(int));
+    if (0 == rules->next || 0 == rules->hits || 0 == rules->dict ||
+        0 == rules->hit_pattern || 0 == rules->hit_next || 0 == fail ||
+        0 == queue) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        free(fail);
+        free(queue);
+        return 0;
+    }
+    memset(rules->next, -1, cap * class_count * sizeof(int));
+    memset(rules->hits, -1, cap * sizeof(int));
+
+    /* A trie of the literals */
+    hit_count = 0;
+    for (k = 0; k < len; k++) {
+        for (j = 0; j < sets[k].count; j++) {
+            const unsigned char *lit = (const unsigned char *)sets[k].lits[j];
+            size_t node = 0;
+            for (i = 0; '\0' != lit[i]; i++) {
+                int *next = &(rules->next[node * class_count +
+                                          rules->classes[lit[i]]]);
+                if (0 > (*next)) {
+                    (*next) = nodes++;
+                }
+                node = (*next);
+            }
+            rules->hit_pattern[hit_count] = k;
+            rules->hit_next[hit_count] = rules->hits[node];
+            rules->hits[node] = hit_count++;
+        }
+    }
+
+    /* Fill in the missing next nodes breadth first, where a literal
+       can not go on the pass goes on with the longest suffix that can */
+    size_t head = 0;
+    size_t tail = 0;
+    rules->dict[0] = -1;
+    for (j = 0; j < class_count; j++) {
+        int child = rules->next[j];
+        if (0 > child) {
+            rules->next[j] = 0;
+        } else {
+            fail[child] = 0;
+            rules->dict[child] = -1;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        int node = queue[head++];
+        for (j = 0; j < class_count; j++) {
+            int *next = &(rules->next[node * class_count + j]);
+            int suffix = rules->next[fail[node] * class_count + j];
+            if (0 > (*next)) {
+                (*next) = suffix;
+            } else {
+                fail[*next] = suffix;
+                rules->dict[*next] = (0 <= rules->hits[suffix]) ?
+                    suffix : rules->dict[suffix];
+                queue[tail++] = (*next);
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+    return 1;
+}
+
+/**
+ * Compiles exclude and include patterns into one set of rules. The
+ * patterns must be kept while the rules are used.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rules The rules to set up.
+ * @param excludes Extended regular expressions of urls to leave.
+ * @param excludes_len The number of excludes.
+ * @param includes Extended regular expressions of which urls must match
+ *                 one, if there are any.
+ * @param includes_len The number of includes.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcrules_init(orcrules *rules, char **excludes, int excludes_len,
+                  char **includes, int includes_len) {
+    int len = excludes_len + includes_len;
+    int k;
+    int status = 1;
+    litset *sets;
+
+    memset(rules, 0, sizeof(orcrules));
+    if (0 == len) {
+        return 1;
+    }
+    rules->regex = calloc(len, sizeof(regex_t));
+    rules->patterns = calloc(len, sizeof(char *));
+    rules->always = calloc(len, sizeof(int));
+    rules->tried = calloc(len + 1, sizeof(unsigned int));
+    sets = calloc(len, sizeof(litset));
+    if (0 == rules->regex || 0 == rules->patterns || 0 == rules->always ||
+        0 == rules->tried || 0 == sets) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        free(sets);
+        orcrules_free(rules);
+        return 0;
+    }
+
+    for (k = 0; k < len; k++) {
+        size_t i = 0;
+        rules->patterns[k] = (k < excludes_len) ?
+            excludes[k] : includes[k - excludes_len];
+        int error = regcomp(&(rules->regex[k]), rules->patterns[k],
+                            REG_EXTENDED);
+        if (0 != error) {
+            print_regerror(error, &(rules->regex[k]), rules->patterns[k]);
+            regfree(&(rules->regex[k]));
+            status = 0;
+            break;
+        }
+        if (k < excludes_len) {
+            rules->excludes_len++;
+        } else {
+            rules->includes_len++;
+        }
+        /* A ) without ( leaves the rest unparsed */
+        parse_alternatives(rules->patterns[k], &i, &(sets[k]));
+        if ('\0' != rules->patterns[k][i]) {
+            litset_free(&(sets[k]));
+        }
+        if (0 == sets[k].count) {
+            rules->always[rules->always_len++] = k;
+        }
+    }
+    if (1 == status) {
+        status = build(rules, sets, len);
+    }
+    for (k = 0; k < len; k++) {
+        litset_free(&(sets[k]));
+    }
+    free(sets);
+    if (0 == status) {
+        orcrules_free(rules);
+    }
+    return status;
+}
+
+/**
+ * Frees compiled rules.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rules The rules to free.
+ */
+void orcrules_free(orcrules *rules) {
+    int k;
+    for (k = 0; k < rules->excludes_len + rules->includes_len; k++) {
+        regfree(&(rules->regex[k]));
+    }
+    free(rules->regex);
+    free(rules->patterns);
+    free(rules->always);
+    free(rules->next);
+    free(rules->hits);
+    free(rules->dict);
+    free(rules->hit_pattern);
+    free(rules->hit_next);
+    free(rules->tried);
+    memset(rules, 0, sizeof(orcrules));
+}
+
+/* Runs pattern k once per pass, returns 1 if it matches, 0 if not or
+   if it has run and -1 on fail */
+static int try(orcrules *rules, int k, const char *url,
+               unsigned int pass) {
+    int status;
+    if (pass == rules->tried[k]) {
+        return 0;
+    }
+    rules->tried[k] = pass;
+    status = regexec(&(rules->regex[k]), url, 0, 0, 0);
+    if (0 == status) {
+        return 1;
+    } else if (REG_NOMATCH != status) {
+        print_regerror(status, &(rules->regex[k]), rules->patterns[k]);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Decides if an url is left, because it matches an exclude or does not
+ * match any include. One pass over the url finds the patterns whose
+ * literals are in it, only those and the patterns without literals are
+ * run. The rules remember which patterns ran, so one thread at a time.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rules The compiled rules.
+ * @param url The url to check.
+ *
+ * @return int 1 to leave the url, 0 to keep it and -1 on fail.
+ */
+int orcrules_excluded(orcrules *rules, const char *url) {
+    int len = rules->excludes_len + rules->includes_len;
+    int included = (0 == rules->includes_len);
+    int status;
+    int k;
+    unsigned int pass;
+
+    if (0 == len) {
+        return 0;
+    }
+    /* Patterns tried in an earlier pass have an older number */
+    pass = ++(rules->tried[len]);
+    if (0 == pass) {
+        memset(rules->tried, 0, (len + 1) * sizeof(unsigned int));
+        pass = rules->tried[len] = 1;
+    }
+
+    if (0 != rules->next) {
+        const unsigned char *c = (const unsigned char *)url;
+        int node = 0;
+        for (; '\0' != (*c); c++) {
+            int found;
+            int hit;
+            node = rules->next[node * rules->class_count +
+                               rules->classes[*c]];
+            found = (0 <= rules->hits[node]) ? node : rules->dict[node];
+            for (; 0 <= found; found = rules->dict[found]) {
+                for (hit = rules->hits[found]; 0 <= hit;
+                     hit = rules->hit_next[hit]) {
+                    k = rules->hit_pattern[hit];
+                    if (k >= rules->excludes_len && included) {
+                        continue;
+                    }
+                    if (-1 == (status = try(rules, k, url, pass))) {
+                        return -1;
+                    } else if (1 == status) {
+                        if (k < rules->excludes_len) {
+                            return 1;
+                        }
+                        included = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    for (k = 0; k < rules->always_len; k++) {
+        int pattern = rules->always[k];
+        if (pattern >= rules->excludes_len && included) {
+            continue;
+        }
+        if (-1 == (status = try(rules, pattern, url, pass))) {
+            return -1;
+        } else if (1 == status) {
+            if (pattern < rules->excludes_len) {
+                return 1;
+            }
+            included = 1;
+        }
+    }
+    return !included;
+}
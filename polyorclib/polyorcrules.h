@@ -0,0 +1,56 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCRULES_H
+#define POLYORCRULES_H
+
+#include <sys/types.h>
+#include <regex.h>
+
+/**
+ * Exclude and include patterns compiled together. Every pattern that can
+ * only match where one of a few literals is found gets them in one
+ * automaton, so one pass over an url finds the few patterns that may
+ * match it and only those are run. Patterns without such literals are
+ * run for every url. A rules is used by one thread at a time.
+ */
+typedef struct _orcrules {
+    regex_t *regex; /**< The excludes and then the includes */
+    const char **patterns; /**< Their sources, owned by the caller */
+    int excludes_len; /**< The number of excludes */
+    int includes_len; /**< The number of includes, 0 includes all */
+    int *always; /**< Patterns without literals */
+    int always_len;
+    unsigned char classes[256]; /**< The class of every byte */
+    int class_count; /**< Class 0 is bytes in no literal */
+    int *next; /**< The next node by node and class */
+    int *hits; /**< The first hit of a node, -1 if none */
+    int *dict; /**< The closest shorter suffix node with hits, -1 if none */
+    int *hit_pattern; /**< The pattern of a hit */
+    int *hit_next; /**< The next hit of the same node, -1 if none */
+    unsigned int *tried; /**< The pass a pattern was last run in, the
+                              current pass is last */
+} orcrules;
+
+int orcrules_init(orcrules *rules, char **excludes, int excludes_len,
+                  char **includes, int includes_len);
+
+void orcrules_free(orcrules *rules);
+
+int orcrules_excluded(orcrules *rules, const char *url);
+
+#endif
@@ -0,0 +1,473 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcscan.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* An attribute is found by the = after its name. A = is only a
+   candidate when the byte before it ends href or src or is a blank, the
+   vector searches test that for a whole block at once so the names of
+   most other attributes are never looked at. */
+#define ORC_SCAN_BYTE '='
+
+/* p - 1 must be in the page, the = at the very start is never a link */
+typedef const char * (*find_fn)(const char *p, const char *end);
+
+/* Can this byte come directly before the = of a link */
+static int is_candidate(char before) {
+    char lower = before | 0x20;
+    return 'f' == lower || 'c' == lower || ' ' == before ||
+           ('\t' <= before && '\r' >= before);
+}
+
+/* The first candidate from p, or end */
+static const char * find_scalar(const char *p, const char *end) {
+    while (p < end) {
+        const char *found = memchr(p, ORC_SCAN_BYTE, end - p);
+        if (0 == found) {
+            break;
+        }
+        if (is_candidate(found[-1])) {
+            return found;
+        }
+        p = found + 1;
+    }
+    return end;
+}
+
+#if defined(__SSE2__)
+/* 16 bytes at a time */
+static const char * find_sse2(const char *p, const char *end) {
+    const __m128i needle = _mm_set1_epi8(ORC_SCAN_BYTE);
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i f = _mm_set1_epi8('f');
+    const __m128i c = _mm_set1_epi8('c');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i below_tab = _mm_set1_epi8('\t' - 1);
+    const __m128i above_cr = _mm_set1_epi8('\r' + 1);
+    while (p + 16 <= end) {
+        __m128i block = _mm_loadu_si128((const __m128i *)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (0 != mask) {
+            __m128i before = _mm_loadu_si128((const __m128i *)(p - 1));
+            __m128i name = _mm_or_si128(before, lower);
+            __m128i ok = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(name, f), _mm_cmpeq_epi8(name, c)),
+                _mm_or_si128(_mm_cmpeq_epi8(before, space),
+                             _mm_and_si128(_mm_cmpgt_epi8(before, below_tab),
+                                           _mm_cmplt_epi8(before, above_cr))));
+            mask &= _mm_movemask_epi8(ok);
+            if (0 != mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        p += 16;
+    }
+    return find_scalar(p, end);
+}
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ORC_SCAN_AVX2 1
+/* 32 bytes at a time, for cpus that have AVX2 */
+__attribute__((target("avx2")))
+static const char * find_avx2(const char *p, const char *end) {
+    const __m256i needle = _mm256_set1_epi8(ORC_SCAN_BYTE);
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i f = _mm256_set1_epi8('f');
+    const __m256i c = _mm256_set1_epi8('c');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i below_tab = _mm256_set1_epi8('\t' - 1);
+    const __m256i above_cr = _mm256_set1_epi8('\r' + 1);
+    while (p + 32 <= end) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)p);
+        unsigned int mask = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(block, needle));
+        if (0 != mask) {
+            __m256i before = _mm256_loadu_si256((const __m256i *)(p - 1));
+            __m256i name = _mm256_or_si256(before, lower);
+            __m256i ok = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(name, f),
+                                _mm256_cmpeq_epi8(name, c)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(before, space),
+                                _mm256_and_si256(
+                                    _mm256_cmpgt_epi8(before, below_tab),
+                                    _mm256_cmpgt_epi8(above_cr, before))));
+            mask &= _mm256_movemask_epi8(ok);
+            if (0 != mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        p += 32;
+    }
+    return find_scalar(p, end);
+}
+#endif
+
+// Picked once by the cpu, every pick is the same so threads may race
+static find_fn find_byte = 0;
+static const char *find_name = "scalar";
+
+static void pick_find() {
+    find_fn fn = find_scalar;
+    const char *name = "scalar";
+#if defined(__SSE2__)
+    fn = find_sse2;
+    name = "sse2";
+#endif
+#if defined(ORC_SCAN_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        fn = find_avx2;
+        name = "avx2";
+    }
+#endif
+    find_name = name;
+    find_byte = fn;
+}
+
+static int is_blank(char c) {
+    return ' ' == c || ('\t' <= c && '\r' >= c);
+}
+
+/* The letters are matched without case by setting the 0x20 bit, which
+   only turns 'H' into 'h' and so on */
+static int is_href(const char *name) {
+    return 'h' == (name[0] | 0x20) && 'r' == (name[1] | 0x20) &&
+           'e' == (name[2] | 0x20) && 'f' == (name[3] | 0x20);
+}
+
+static int is_src(const char *name) {
+    return 's' == (name[0] | 0x20) && 'r' == (name[1] | 0x20) &&
+           'c' == (name[2] | 0x20);
+}
+
+/**
+ * Starts a scan of a page. The page is not copied and must be kept
+ * while the scan goes on.
+ *
+ * @author Oscar Norlander
+ *
+ * @param scan The scan to start.
+ * @param html The page, it does not need to be terminated.
+ * @param len The length of the page.
+ */
+void orcscan_init(orcscanner *scan, const char *html, size_t len) {
+    if (0 == find_byte) {
+        pick_find();
+    }
+    scan->start = html;
+    scan->next = html;
+    scan->end = html + len;
+    scan->unclosed[0] = scan->end;
+    scan->unclosed[1] = scan->end;
+}
+
+/**
+ * Finds the next href or src attribute with a quoted value. The
+ * attribute name may end another name, like data-src, as it could with
+ * the regular expressions this replaces.
+ *
+ * @author Oscar Norlander
+ *
+ * @param scan The scan.
+ * @param link Set to the value of the attribute, without the blanks at
+ *             its start.
+ *
+ * @return int 1 if a link was found 0 at the end of the page
+ */
+int orcscan_next(orcscanner *scan, orclink *link) {
+    const char *end = scan->end;
+    const char *p = scan->next;
+    if (p == scan->start) {
+        p++;
+    }
+    while (p < end) {
+        const char *eq = find_byte(p, end);
+        if (eq == end) {
+            break;
+        }
+        p = eq + 1;
+
+        /* The name before the = */
+        const char *name = eq;
+        while (name > scan->start && is_blank(name[-1])) {
+            name--;
+        }
+        if (!((name - scan->start >= 4 && is_href(name - 4)) ||
+              (name - scan->start >= 3 && is_src(name - 3)))) {
+            continue;
+        }
+
+        /* The quoted value after it */
+        const char *value = eq + 1;
+        while (value < end && is_blank(*value)) {
+            value++;
+        }
+        if (value == end || ('"' != *value && '\'' != *value)) {
+            continue;
+        }
+        char quote = *value;
+        int single = ('\'' == quote);
+        value++;
+        while (value < end && is_blank(*value)) {
+            value++;
+        }
+        /* A value that is never closed is not searched again and again */
+        if (value >= scan->unclosed[single]) {
+            continue;
+        }
+        const char *close = memchr(value, quote, end - value);
+        if (0 == close) {
+            scan->unclosed[single] = value;
+            continue;
+        }
+        link->start = value;
+        link->len = close - value;
+        scan->next = close + 1;
+        return 1;
+    }
+    scan->next = end;
+    return 0;
+}
+
+/**
+ * Names the byte search the scanner uses on this cpu, avx2, sse2 or
+ * scalar.
+ *
+ * @author Oscar Norlander
+ *
+ * @return const char* The name.
+ */
+const char * orcscan_impl() {
+    if (0 == find_byte) {
+        pick_find();
+    }
+    return find_name;
+}
+
+/**
+ * Starts a stream, before the first chunk of a page.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stream The stream to start.
+ */
+void orcstream_init(orcstream *stream) {
+    if (0 == find_byte) {
+        pick_find();
+    }
+    stream->state = orcst_search;
+    stream->quote = 0;
+    stream->tail_len = 0;
+    stream->chunk = 0;
+    stream->next = 0;
+    stream->end = 0;
+    stream->value_len = 0;
+}
+
+/**
+ * Gives a stream the next chunk of the page. Take all links of it with
+ * orcstream_next before the next chunk, the chunk is not copied.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stream The stream.
+ * @param chunk The next part of the page.
+ * @param len The length of chunk.
+ */
+void orcstream_feed(orcstream *stream, const char *chunk, size_t len) {
+    stream->chunk = chunk;
+    stream->next = chunk;
+    stream->end = chunk + len;
+}
+
+/* Is the name before the = at eq href or src. The name may start in
+   earlier chunks, then its first bytes are in the tail. */
+static int stream_name(const orcstream *stream, const char *eq) {
+    const char *chunk = stream->chunk;
+    const char *name = eq;
+    char window[4];
+    size_t len = 0;
+    while (name > chunk && is_blank(name[-1])) {
+        name--;
+    }
+    while (len < 4 && name > chunk) {
+        window[3 - len] = *(--name);
+        len++;
+    }
+    if (name == chunk) {
+        size_t i = stream->tail_len;
+        while (len < 4 && 0 < i) {
+            window[3 - len] = stream->tail[--i];
+            len++;
+        }
+    }
+    return (4 == len && is_href(window)) ||
+           (3 <= len && is_src(window + 1));
+}
+
+/* Keep the bytes before the blanks at the end of a used up chunk, a name
+   in them may belong to a = in the next chunk */
+static void keep_tail(orcstream *stream) {
+    const char *chunk = stream->chunk;
+    const char *end = stream->end;
+    while (end > chunk && is_blank(end[-1])) {
+        end--;
+    }
+    size_t len = end - chunk;
+    if (4 <= len) {
+        memcpy(stream->tail, end - 4, 4);
+        stream->tail_len = 4;
+    } else if (0 < len) {
+        size_t keep = stream->tail_len;
+        if (keep > 4 - len) {
+            keep = 4 - len;
+        }
+        memmove(stream->tail, stream->tail + stream->tail_len - keep, keep);
+        memcpy(stream->tail + keep, chunk, len);
+        stream->tail_len = keep + len;
+    }
+    stream->chunk = 0;
+}
+
+/* Add a part of a split value, a value that gets too long is skipped */
+static void keep_value(orcstream *stream, const char *start,
+                       const char *end) {
+    size_t len = end - start;
+    if (stream->value_len + len > MAX_URL_LEN) {
+        stream->state = orcst_skip;
+        return;
+    }
+    memcpy(stream->value + stream->value_len, start, len);
+    stream->value_len += len;
+}
+
+/**
+ * Finds the next link in the chunk a stream was fed. A link that was
+ * split between chunks is returned from the stream itself, other links
+ * are spans of the chunk. Both are valid until the next call.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stream The stream.
+ * @param link Set to the value of the attribute, without the blanks at
+ *             its start.
+ *
+ * @return int 1 if a link was found 0 when the chunk is used up
+ */
+int orcstream_next(orcstream *stream, orclink *link) {
+    const char *end = stream->end;
+    const char *p = stream->next;
+    const char *value = p;
+    const char *close;
+    if (0 == stream->chunk) {
+        return 0;
+    }
+    while (p < end) {
+        switch (stream->state) {
+        case orcst_search:
+            /* The first byte has no byte before it in this chunk */
+            if (p == stream->chunk && ORC_SCAN_BYTE == *p) {
+                p++;
+                if (stream_name(stream, p - 1)) {
+                    stream->state = orcst_equals;
+                }
+                break;
+            }
+            if (p == stream->chunk) {
+                p++;
+            }
+            p = find_byte(p, end);
+            if (p == end) {
+                break;
+            }
+            p++;
+            if (stream_name(stream, p - 1)) {
+                stream->state = orcst_equals;
+            }
+            break;
+        case orcst_equals:
+            while (p < end && is_blank(*p)) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+            if ('"' == *p || '\'' == *p) {
+                stream->quote = *p;
+                stream->state = orcst_lead;
+                p++;
+            } else {
+                stream->state = orcst_search;
+            }
+            break;
+        case orcst_lead:
+            while (p < end && is_blank(*p)) {
+                p++;
+            }
+            if (p < end) {
+                stream->state = orcst_value;
+                stream->value_len = 0;
+                value = p;
+            }
+            break;
+        case orcst_value:
+            close = memchr(p, stream->quote, end - p);
+            if (0 == close) {
+                keep_value(stream, value, end);
+                p = end;
+                break;
+            }
+            stream->state = orcst_search;
+            stream->next = close + 1;
+            if (0 == stream->value_len && MAX_URL_LEN >= close - value) {
+                link->start = value;
+                link->len = close - value;
+                return 1;
+            }
+            keep_value(stream, value, close);
+            if (orcst_skip == stream->state) {
+                stream->state = orcst_search;
+                p = close + 1;
+                break;
+            }
+            link->start = stream->value;
+            link->len = stream->value_len;
+            stream->value_len = 0;
+            return 1;
+        case orcst_skip:
+            close = memchr(p, stream->quote, end - p);
+            if (0 == close) {
+                p = end;
+                break;
+            }
+            stream->state = orcst_search;
+            stream->value_len = 0;
+            p = close + 1;
+            break;
+        }
+    }
+    stream->next = end;
+    keep_tail(stream);
+    return 0;
+}
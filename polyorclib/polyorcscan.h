@@ -0,0 +1,86 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCSCAN_H
+#define POLYORCSCAN_H
+
+#include "polyorcdefs.h"
+
+#include <stddef.h>
+
+/**
+ * A link found in a page, a span of the page buffer that is not
+ * terminated.
+ */
+typedef struct _orclink {
+    const char *start; /**< The first character of the url */
+    size_t len; /**< The length of the url */
+} orclink;
+
+/**
+ * Finds the href and src attributes of a page in one pass. Attributes
+ * are matched without case and with blanks around the = and inside the
+ * quotes, like href = " /index.html".
+ */
+typedef struct _orcscanner {
+    const char *start; /**< The page */
+    const char *next; /**< Where the search goes on */
+    const char *end; /**< Directly after the page */
+    const char *unclosed[2]; /**< No " and ' from here on */
+} orcscanner;
+
+/* Where an orcstream is in an attribute */
+enum orc_streamstate {
+    orcst_search = 0, /* Looking for the = of href or src */
+    orcst_equals, /* After the =, before the quote */
+    orcst_lead, /* After the quote, before the value */
+    orcst_value, /* In the value */
+    orcst_skip /* In a value too long to keep */
+};
+
+/**
+ * Finds the same links as orcscanner in a page that arrives in chunks,
+ * without keeping the page. Attributes may be split anywhere between
+ * chunks, the part of a value that is in earlier chunks is kept in
+ * value. A value longer than MAX_URL_LEN is skipped, and a value that is
+ * never closed hides the rest of the page.
+ */
+typedef struct _orcstream {
+    enum orc_streamstate state;
+    char quote; /**< That ends the value */
+    char tail[4]; /**< The bytes before the blanks at the end so far */
+    size_t tail_len;
+    const char *chunk; /**< The chunk being scanned, 0 when used up */
+    const char *next; /**< Where the scan of chunk goes on */
+    const char *end; /**< Directly after chunk */
+    size_t value_len;
+    char value[MAX_URL_LEN + 1]; /**< The start of a split value */
+} orcstream;
+
+void orcscan_init(orcscanner *scan, const char *html, size_t len);
+
+int orcscan_next(orcscanner *scan, orclink *link);
+
+const char * orcscan_impl();
+
+void orcstream_init(orcstream *stream);
+
+void orcstream_feed(orcstream *stream, const char *chunk, size_t len);
+
+int orcstream_next(orcstream *stream, orclink *link);
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcsegment.h"
+#include "polyorcout.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+/* Reads that keep meeting a writer give up after this many tries */
+#define ORC_SEGMENT_RETRIES 1000
+
+/* The bytes of a segment with this many slots and urls */
+static size_t segment_size(unsigned int threads, unsigned int urls,
+                           unsigned int names_size) {
+    return sizeof(orcsegment_header) + (size_t)threads * sizeof(orcslot) +
+           (size_t)threads * urls * sizeof(orcurlstat) +
+           (size_t)urls * sizeof(unsigned int) + names_size;
+}
+
+/* Point the mapping at the parts of a segment, as the header says */
+static void segment_layout(orcsegment *seg, void *mem, size_t size) {
+    orcsegment_header *header = (orcsegment_header *)mem;
+    char *pos = (char *)mem + sizeof(orcsegment_header);
+    seg->header = header;
+    seg->slots = (orcslot *)pos;
+    pos += (size_t)header->threads * sizeof(orcslot);
+    seg->urls = (orcurlstat *)pos;
+    pos += (size_t)header->threads * header->urls * sizeof(orcurlstat);
+    seg->name_offsets = (unsigned int *)pos;
+    pos += (size_t)header->urls * sizeof(unsigned int);
+    seg->names = pos;
+    seg->size = size;
+}
+
+/**
+ * Creates a segment for the statistics of a number of threads. With a
+ * path the segment is a file others can map, an older file is unlinked
+ * first so readers that still map it are not cut short. Without a path
+ * the segment is anonymous memory. The slots and url statistics are
+ * zero and left untouched, so their pages are placed by the thread
+ * that writes them first.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping to set up, close it with orcseg_close.
+ * @param path The file of the segment or 0.
+ * @param threads The number of slots.
+ * @param urls The urls every thread keeps statistics for, can be 0.
+ * @param names_size The bytes of all url names with terminators.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcseg_create(orcsegment *seg, const char *path, unsigned int threads,
+                  unsigned int urls, unsigned int names_size) {
+    void *mem;
+    struct timeval now;
+
+    memset(seg, 0, sizeof(orcsegment));
+    size_t size = segment_size(threads, urls, names_size);
+    if (0 == path) {
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    } else {
+        unlink(path);
+        int fd = open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (-1 == fd) {
+            orcerror("File %s\n", path);
+            orcerrno(errno);
+            return 0;
+        }
+        if (-1 == ftruncate(fd, size)) {
+            orcerror("Resize of %s\n", path);
+            orcerrno(errno);
+            close(fd);
+            return 0;
+        }
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (MAP_FAILED == mem) {
+        orcerror("Maping memory failed\n");
+        orcerrno(errno);
+        return 0;
+    }
+    gettimeofday(&now, 0);
+    orcsegment_header *header = (orcsegment_header *)mem;
+    header->threads = threads;
+    header->urls = urls;
+    header->names_size = names_size;
+    segment_layout(seg, mem, size);
+    seg->header->version = ORC_SEGMENT_VERSION;
+    seg->header->slot_size = sizeof(orcslot);
+    seg->header->start_time = (unsigned long long)now.tv_sec * 1000000ULL +
+                              now.tv_usec;
+    __sync_synchronize();
+    seg->header->magic = ORC_SEGMENT_MAGIC;
+    return 1;
+}
+
+/**
+ * Maps the segment of a running or finished polyorc read-only. A
+ * segment of another version or build is refused.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping to set up, close it with orcseg_close.
+ * @param path The file of the segment.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcseg_open(orcsegment *seg, const char *path) {
+    struct stat info;
+
+    memset(seg, 0, sizeof(orcsegment));
+    int fd = open(path, O_RDONLY);
+    if (-1 == fd) {
+        orcerror("File %s\n", path);
+        orcerrno(errno);
+        return 0;
+    }
+    if (-1 == fstat(fd, &info) ||
+        (size_t)info.st_size < sizeof(orcsegment_header))
+    {
+        orcerror("%s is no statistics segment\n", path);
+        close(fd);
+        return 0;
+    }
+    void *mem = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == mem) {
+        orcerror("Maping memory failed\n");
+        orcerrno(errno);
+        return 0;
+    }
+    orcsegment_header *header = (orcsegment_header *)mem;
+    const char *problem = 0;
+    if (ORC_SEGMENT_MAGIC != header->magic) {
+        problem = "is no statistics segment";
+    } else if (ORC_SEGMENT_VERSION != header->version ||
+               sizeof(orcslot) != header->slot_size) {
+        problem = "is from another version of polyorc";
+    } else if ((size_t)info.st_size < segment_size(header->threads,
+                                                   header->urls,
+                                                   header->names_size)) {
+        problem = "is cut short";
+    }
+    if (0 != problem) {
+        orcerror("%s %s\n", path, problem);
+        munmap(mem, info.st_size);
+        return 0;
+    }
+    __sync_synchronize();
+    segment_layout(seg, mem, info.st_size);
+    return 1;
+}
+
+/**
+ * Unmaps a segment. A file stays for readers that come later.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping.
+ */
+void orcseg_close(orcsegment *seg) {
+    if (0 != seg->header) {
+        munmap(seg->header, seg->size);
+    }
+    memset(seg, 0, sizeof(orcsegment));
+}
+
+/**
+ * Copies the statistics of a thread into its slot. Only the thread
+ * that owns the slot may publish to it.
+ *
+ * @author Oscar Norlander
+ *
+ * @param slot The slot of the thread.
+ * @param stat The statistics the thread keeps privately.
+ */
+void orcseg_publish(orcslot *slot, const orcstatistics *stat) {
+    slot->sequence++;
+    __sync_synchronize();
+    memcpy(&(slot->stat), stat, sizeof(orcstatistics));
+    __sync_synchronize();
+    slot->sequence++;
+}
+
+/**
+ * Copies a consistent snapshot of the statistics in a slot, without
+ * blocking the thread that writes them.
+ *
+ * @author Oscar Norlander
+ *
+ * @param slot The slot of a thread.
+ * @param stat Set to the statistics.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcseg_read(const orcslot *slot, orcstatistics *stat) {
+    int i;
+    for (i = 0; i < ORC_SEGMENT_RETRIES; i++) {
+        unsigned long long before = slot->sequence;
+        if (0 != (before & 1)) {
+            sched_yield();
+            continue;
+        }
+        __sync_synchronize();
+        memcpy(stat, (const void *)&(slot->stat), sizeof(orcstatistics));
+        __sync_synchronize();
+        if (before == slot->sequence) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Returns the url statistics of a thread.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping.
+ * @param thread The thread, from 0.
+ *
+ * @return orcurlstat * header->urls statistics, 0 without urls.
+ */
+orcurlstat * orcseg_urls(const orcsegment *seg, unsigned int thread) {
+    if (0 == seg->header->urls) {
+        return 0;
+    }
+    return seg->urls + (size_t)thread * seg->header->urls;
+}
+
+/**
+ * Stores the name of a url. Urls are named in order, starting at 0.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping of a created segment.
+ * @param index The url.
+ * @param name The name.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcseg_name_url(orcsegment *seg, unsigned int index, const char *name) {
+    size_t len = strlen(name) + 1;
+    if (index >= seg->header->urls ||
+        seg->names_used + len > seg->header->names_size) {
+        return 0;
+    }
+    seg->name_offsets[index] = (unsigned int)seg->names_used;
+    memcpy(seg->names + seg->names_used, name, len);
+    seg->names_used += len;
+    return 1;
+}
+
+/**
+ * Returns the name of a url.
+ *
+ * @author Oscar Norlander
+ *
+ * @param seg The mapping.
+ * @param index The url.
+ *
+ * @return const char * The name, empty if it has none.
+ */
+const char * orcseg_url_name(const orcsegment *seg, unsigned int index) {
+    if (index >= seg->header->urls ||
+        seg->name_offsets[index] >= seg->header->names_size) {
+        return "";
+    }
+    const char *name = seg->names + seg->name_offsets[index];
+    /* A reader can not trust the names to be terminated */
+    if (0 == memchr(name, '\0',
+                    seg->header->names_size - seg->name_offsets[index])) {
+        return "";
+    }
+    return name;
+}
@@ -0,0 +1,96 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCSEGMENT_H
+#define POLYORCSEGMENT_H
+
+#include "polyorctypes.h"
+#include "polyorcurlstat.h"
+
+#include <stddef.h>
+
+/* "ORCS", the first bytes of every segment */
+#define ORC_SEGMENT_MAGIC 0x5343524fU
+
+/* Bumped when the layout of the segment or of orcstatistics changes */
+#define ORC_SEGMENT_VERSION 2
+
+/* The name of the segment in the stat directory */
+#define ORC_SEGMENT_FILE "polyorc.stats"
+
+#define ORC_CACHE_LINE 64
+
+/**
+ * The first cache line of a segment. The magic is written last, a
+ * segment without it is not ready to be read.
+ */
+typedef struct _orcsegment_header {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int threads; /**< The number of slots */
+    unsigned int slot_size; /**< Bytes from one slot to the next */
+    unsigned long long start_time; /**< Microseconds since the epoch */
+    unsigned int urls; /**< Urls with statistics per thread, 0 if none */
+    unsigned int names_size; /**< Bytes of the url names */
+} __attribute__((aligned(ORC_CACHE_LINE))) orcsegment_header;
+
+/**
+ * The statistics of one thread. Only the thread writes its slot, it
+ * makes the sequence odd while it copies new statistics in and even
+ * again when done. Readers retry until they copied the statistics
+ * with the same even sequence before and after (a seqlock).
+ */
+typedef struct _orcslot {
+    volatile unsigned long long sequence;
+    orcstatistics stat __attribute__((aligned(ORC_CACHE_LINE)));
+} orcslot;
+
+/**
+ * A mapping of a segment, a header followed by one slot per thread.
+ * With url statistics an array of them per thread follows, then the
+ * offset of every url name and the terminated names. A thread writes
+ * its url statistics in place and readers see them while they change,
+ * every field is a word of its own so no value is torn.
+ */
+typedef struct _orcsegment {
+    orcsegment_header *header;
+    orcslot *slots;
+    orcurlstat *urls; /**< header->urls per thread */
+    unsigned int *name_offsets;
+    char *names;
+    size_t names_used; /**< While naming urls */
+    size_t size; /**< Bytes mapped */
+} orcsegment;
+
+int orcseg_create(orcsegment *seg, const char *path, unsigned int threads,
+                  unsigned int urls, unsigned int names_size);
+
+int orcseg_open(orcsegment *seg, const char *path);
+
+void orcseg_close(orcsegment *seg);
+
+void orcseg_publish(orcslot *slot, const orcstatistics *stat);
+
+orcurlstat * orcseg_urls(const orcsegment *seg, unsigned int thread);
+
+int orcseg_name_url(orcsegment *seg, unsigned int index, const char *name);
+
+const char * orcseg_url_name(const orcsegment *seg, unsigned int index);
+
+int orcseg_read(const orcslot *slot, orcstatistics *stat);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcstats.h"
+#include "polyorcout.h"
+#include "polyorchistogram.h"
+
+#include <string.h>
+
+static const char *latency_names[] = {
+    "total", "dns", "connect", "tls", "ttfb", "transfer"
+};
+
+static const char *status_names[] = {
+    "none", "1xx", "2xx", "3xx", "4xx", "5xx"
+};
+
+static const char *failure_names[] = {
+    "connect", "timeout", "dns", "tls", "other"
+};
+
+/* Exact status codes shown in reports */
+#define TOP_CODES 5
+
+/**
+ * Returns a short name for a latency kind.
+ *
+ * @author Oscar Norlander
+ *
+ * @param latency The latency kind.
+ *
+ * @return const char *
+ */
+const char * orcstat_latency_name(enum orc_latency latency) {
+    if (latency < 0 || latency >= orcl_count) {
+        return "unknown";
+    }
+    return latency_names[latency];
+}
+
+/**
+ * Returns a short name for a class of http status codes.
+ *
+ * @author Oscar Norlander
+ *
+ * @param status The status class.
+ *
+ * @return const char *
+ */
+const char * orcstat_status_name(enum orc_status status) {
+    if (status < 0 || status >= orcc_count) {
+        return "unknown";
+    }
+    return status_names[status];
+}
+
+/**
+ * Returns a short name for a reason transfers fail.
+ *
+ * @author Oscar Norlander
+ *
+ * @param failure The reason.
+ *
+ * @return const char *
+ */
+const char * orcstat_failure_name(enum orc_failure failure) {
+    if (failure < 0 || failure >= orcf_count) {
+        return "unknown";
+    }
+    return failure_names[failure];
+}
+
+/**
+ * Counts an exact status code. A code that is not in the table yet
+ * takes the first free entry and is left out when the table is full.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stat The statistics with the table.
+ * @param code The http status code.
+ * @param count How many times it was seen.
+ */
+void orcstat_count_code(orcstatistics *stat, int code,
+                        unsigned long long count) {
+    int i;
+    for (i = 0; i < ORC_MAX_CODES; i++) {
+        orccode *entry = &(stat->codes[i]);
+        if (0 == entry->count) {
+            entry->code = code;
+        }
+        if (code == entry->code) {
+            entry->count += count;
+            return;
+        }
+    }
+}
+
+/**
+ * Copies the most common exact status codes, most common first.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stat The statistics with the table.
+ * @param top Set to the codes.
+ * @param max The most codes to copy.
+ *
+ * @return int The number of codes copied.
+ */
+int orcstat_top_codes(const orcstatistics *stat, orccode *top, int max) {
+    int i;
+    int j;
+    int count = 0;
+    /* An insertion sort, the table is small */
+    for (i = 0; i < ORC_MAX_CODES && 0 != stat->codes[i].count; i++) {
+        const orccode *entry = &(stat->codes[i]);
+        for (j = count; 0 < j && top[j - 1].count < entry->count; j--) {
+            if (j < max) {
+                top[j] = top[j - 1];
+            }
+        }
+        if (j < max) {
+            top[j] = *entry;
+            if (count < max) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Prints how many hits failed, the status classes, the most common
+ * status codes and why transfers failed in curl, for the end reports.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stat The statistics, usually of all threads.
+ */
+void orcstat_print_outcome(const orcstatistics *stat) {
+    int i;
+    orccode top[TOP_CODES];
+    orcoutc(orc_reset, orc_red, "Failed:     ");
+    orcout(orcm_quiet, "%llu\n", stat->failed);
+    orcoutc(orc_reset, orc_red, "Status:    ");
+    for (i = 0; i < orcc_count; i++) {
+        if (0 != stat->status[i]) {
+            orcout(orcm_quiet, " %s %llu", status_names[i], stat->status[i]);
+        }
+    }
+    orcout(orcm_quiet, "\n");
+    int count = orcstat_top_codes(stat, top, TOP_CODES);
+    if (0 < count) {
+        orcoutc(orc_reset, orc_red, "Codes:     ");
+        for (i = 0; i < count; i++) {
+            orcout(orcm_quiet, " %d %llu", top[i].code, top[i].count);
+        }
+        orcout(orcm_quiet, "\n");
+    }
+    unsigned long long failures = 0;
+    for (i = 0; i < orcf_count; i++) {
+        failures += stat->failures[i];
+    }
+    if (0 == failures) {
+        return;
+    }
+    orcoutc(orc_reset, orc_red, "Errors:    ");
+    for (i = 0; i < orcf_count; i++) {
+        if (0 != stat->failures[i]) {
+            orcout(orcm_quiet, " %s %llu", failure_names[i],
+                   stat->failures[i]);
+        }
+    }
+    orcout(orcm_quiet, "\n");
+}
+
+/**
+ * Prints a latency line in milliseconds: the count, mean, p50, p90, p99,
+ * p99.9 and max of a histogram.
+ *
+ * @author Oscar Norlander
+ *
+ * @param name The name of the line.
+ * @param hist The histogram.
+ */
+void orcstat_print_latency(const char *name, const orchistogram *hist) {
+    orcoutc(orc_reset, orc_red, "%-10s", name);
+    orcout(orcm_quiet, "%10llu %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+           hist->count, orchist_mean(hist) / 1000.0,
+           orchist_percentile(hist, 50.0) / 1000.0,
+           orchist_percentile(hist, 90.0) / 1000.0,
+           orchist_percentile(hist, 99.0) / 1000.0,
+           orchist_percentile(hist, 99.9) / 1000.0,
+           hist->max / 1000.0);
+}
+
+/**
+ * Adds the counters and histograms of one thread to another
+ * statistics structure, for example to get the sum of all threads.
+ *
+ * @author Oscar Norlander
+ *
+ * @param dst The statistics that are updated.
+ * @param src The statistics that are added.
+ */
+void orcstat_merge(orcstatistics *dst, const orcstatistics *src) {
+    int i;
+    /* The sum spans from the first start to the latest publish */
+    if (0 == dst->started ||
+        (0 != src->started && src->started < dst->started)) {
+        dst->started = src->started;
+    }
+    if (src->published > dst->published) {
+        dst->published = src->published;
+    }
+    dst->total_bytes += src->total_bytes;
+    dst->hits += src->hits;
+    dst->missed += src->missed;
+    dst->connects += src->connects;
+    dst->multiplexed += src->multiplexed;
+    dst->aborted += src->aborted;
+    dst->failed += src->failed;
+    for (i = 0; i < orcc_count; i++) {
+        dst->status[i] += src->status[i];
+    }
+    for (i = 0; i < ORC_MAX_CODES && 0 != src->codes[i].count; i++) {
+        orcstat_count_code(dst, src->codes[i].code, src->codes[i].count);
+    }
+    for (i = 0; i < orcf_count; i++) {
+        dst->failures[i] += src->failures[i];
+    }
+    for (i = 0; i < orcl_count; i++) {
+        orchist_merge(&(dst->latency[i]), &(src->latency[i]));
+    }
+    orchist_merge(&(dst->ok_latency), &(src->ok_latency));
+    orchist_merge(&(dst->failed_latency), &(src->failed_latency));
+    /* Threads follow the same profile, the targets add up */
+    if (src->step > dst->step) {
+        dst->step = src->step;
+    }
+    dst->target += src->target;
+    for (i = 0; i < ORC_MAX_STEPS; i++) {
+        orcstep *to = &(dst->steps[i]);
+        const orcstep *from = &(src->steps[i]);
+        if (from->seconds > to->seconds) {
+            to->seconds = from->seconds;
+        }
+        to->hits += from->hits;
+        to->total_bytes += from->total_bytes;
+        to->missed += from->missed;
+        orchist_merge(&(to->latency), &(from->latency));
+    }
+    /* Threads run the same scenario */
+    if (src->flow_count > dst->flow_count) {
+        dst->flow_count = src->flow_count;
+    }
+    dst->sessions += src->sessions;
+    for (i = 0; i < src->flow_count && i < ORC_MAX_FLOW; i++) {
+        orcflowstep *to = &(dst->flow[i]);
+        const orcflowstep *from = &(src->flow[i]);
+        if ('\0' == to->name[0]) {
+            memcpy(to->name, from->name, sizeof(to->name));
+        }
+        to->hits += from->hits;
+        to->total_bytes += from->total_bytes;
+        orchist_merge(&(to->latency), &(from->latency));
+    }
+}
+
+/**
+ * Updates rates with a new snapshot. The rates are over the time since
+ * the snapshot before, or since the start for the first one, and stay
+ * as they are while nothing new was published.
+ *
+ * @author Oscar Norlander
+ *
+ * @param rate The rates of earlier snapshots.
+ * @param stat The new snapshot.
+ */
+void orcrate_update(orcrate *rate, const orcstatistics *stat) {
+    if (stat->published <= rate->time) {
+        return;
+    }
+    if (stat->total_bytes < rate->total_bytes || stat->hits < rate->hits) {
+        /* Counters of another run */
+        memset(rate, 0, sizeof(orcrate));
+    }
+    unsigned long long since = (0 != rate->time) ? rate->time : stat->started;
+    if (0 != since && since < stat->published) {
+        double secs = (stat->published - since) / 1000000.0;
+        rate->bytes_sec = (stat->total_bytes - rate->total_bytes) / secs;
+        rate->hits_sec = (stat->hits - rate->hits) / secs;
+    }
+    rate->time = stat->published;
+    rate->total_bytes = stat->total_bytes;
+    rate->hits = stat->hits;
+}
@@ -0,0 +1,54 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCSTATS_H
+#define POLYORCSTATS_H
+
+#include "polyorctypes.h"
+
+/**
+ * Rates derived from the cumulative counters of two snapshots and the
+ * times they were published. Zero it before the first update.
+ */
+typedef struct _orcrate {
+    unsigned long long time; /**< published of the last snapshot */
+    unsigned long long total_bytes;
+    unsigned long long hits;
+    double bytes_sec;
+    double hits_sec;
+} orcrate;
+
+const char * orcstat_latency_name(enum orc_latency latency);
+
+const char * orcstat_status_name(enum orc_status status);
+
+const char * orcstat_failure_name(enum orc_failure failure);
+
+void orcstat_count_code(orcstatistics *stat, int code,
+                        unsigned long long count);
+
+int orcstat_top_codes(const orcstatistics *stat, orccode *top, int max);
+
+void orcstat_print_outcome(const orcstatistics *stat);
+
+void orcstat_print_latency(const char *name, const orchistogram *hist);
+
+void orcstat_merge(orcstatistics *dst, const orcstatistics *src);
+
+void orcrate_update(orcrate *rate, const orcstatistics *stat);
+
+#endif
@@ -0,0 +1,308 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorctemplate.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* The longest a number can be written */
+#define TPL_NUMBER_MAX 20
+#define TPL_RANDOM_LEN 16
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static int add_part(orctemplate *tpl, int *cap, enum orctpl_kind kind,
+                    size_t offset, size_t len, int column) {
+    if (tpl->count == *cap) {
+        *cap = (0 == *cap) ? 8 : *cap * 2;
+        orctpl_part *parts = realloc(tpl->parts, *cap * sizeof(orctpl_part));
+        if (0 == parts) {
+            orcerror("%s (%d)\n", strerror(errno), errno);
+            return 0;
+        }
+        tpl->parts = parts;
+    }
+    orctpl_part *part = &(tpl->parts[tpl->count]);
+    part->kind = kind;
+    part->offset = offset;
+    part->len = len;
+    part->column = column;
+    tpl->count++;
+    return 1;
+}
+
+/* The placeholder between {{ and }}, -1 if it is unknown */
+static int placeholder(const char *name, size_t len, int *column) {
+    *column = 0;
+    if (6 == len && 0 == strncmp(name, "random", len)) {
+        return orctpl_random;
+    }
+    if (7 == len && 0 == strncmp(name, "counter", len)) {
+        return orctpl_counter;
+    }
+    if (6 == len && 0 == strncmp(name, "thread", len)) {
+        return orctpl_thread;
+    }
+    if (9 == len && 0 == strncmp(name, "timestamp", len)) {
+        return orctpl_timestamp;
+    }
+    if (3 == len && 0 == strncmp(name, "url", len)) {
+        return orctpl_url;
+    }
+    if (4 < len && 0 == strncmp(name, "csv:", 4)) {
+        size_t i;
+        int value = 0;
+        for (i = 4; i < len; i++) {
+            if ('0' > name[i] || '9' < name[i] ||
+                ORC_TPL_MAX_COLUMNS < value * 10 + (name[i] - '0')) {
+                return -1;
+            }
+            value = value * 10 + (name[i] - '0');
+        }
+        if (0 == value) {
+            return -1;
+        }
+        *column = value - 1;
+        return orctpl_csv;
+    }
+    return -1;
+}
+
+/**
+ * Parses a template. Placeholders are {{random}}, {{counter}},
+ * {{thread}}, {{timestamp}}, {{url}} and {{csv:N}}.
+ *
+ * @author Oscar Norlander
+ *
+ * @param tpl The parsed template, free it with orctpl_free.
+ * @param text The template.
+ * @param len The length of text.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orctpl_parse(orctemplate *tpl, const char *text, size_t len) {
+    int cap = 0;
+    size_t pos = 0;
+    size_t literal = 0;
+
+    memset(tpl, 0, sizeof(orctemplate));
+    tpl->text = malloc(len + 1);
+    if (0 == tpl->text) {
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        return 0;
+    }
+    memcpy(tpl->text, text, len);
+    tpl->text[len] = '\0';
+
+    while (pos + 1 < len) {
+        if ('{' != text[pos] || '{' != text[pos + 1]) {
+            pos++;
+            continue;
+        }
+        const char *close = 0;
+        size_t i;
+        for (i = pos + 2; i + 1 < len; i++) {
+            if ('}' == text[i] && '}' == text[i + 1]) {
+                close = text + i;
+                break;
+            }
+        }
+        if (0 == close) {
+            break;
+        }
+        int column;
+        int kind = placeholder(text + pos + 2, close - (text + pos + 2),
+                               &column);
+        if (0 > kind) {
+            orcerror("Unknown placeholder %.*s\n",
+                     (int)(close - text - pos + 2), text + pos);
+            orctpl_free(tpl);
+            return 0;
+        }
+        if ((literal < pos &&
+             0 == add_part(tpl, &cap, orctpl_literal, literal, pos - literal,
+                           0)) ||
+            0 == add_part(tpl, &cap, kind, 0, 0, column))
+        {
+            orctpl_free(tpl);
+            return 0;
+        }
+        pos = (close - text) + 2;
+        literal = pos;
+    }
+    if (literal < len &&
+        0 == add_part(tpl, &cap, orctpl_literal, literal, len - literal, 0)) {
+        orctpl_free(tpl);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Tells if a template has no placeholders, so it can be used as is.
+ *
+ * @author Oscar Norlander
+ *
+ * @param tpl The template.
+ *
+ * @return int 1 if static 0 if not
+ */
+int orctpl_is_static(const orctemplate *tpl) {
+    int i;
+    for (i = 0; i < tpl->count; i++) {
+        if (orctpl_literal != tpl->parts[i].kind) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * The longest a template can expand to, without the terminating zero.
+ *
+ * @author Oscar Norlander
+ *
+ * @param tpl The template.
+ * @param column_max The longest csv value.
+ * @param url_max The longest url.
+ *
+ * @return size_t The bound.
+ */
+size_t orctpl_bound(const orctemplate *tpl, size_t column_max, size_t url_max) {
+    size_t bound = 0;
+    int i;
+    for (i = 0; i < tpl->count; i++) {
+        switch (tpl->parts[i].kind) {
+        case orctpl_literal:
+            bound += tpl->parts[i].len;
+            break;
+        case orctpl_random:
+            bound += TPL_RANDOM_LEN;
+            break;
+        case orctpl_csv:
+            bound += column_max;
+            break;
+        case orctpl_url:
+            bound += url_max;
+            break;
+        default:
+            bound += TPL_NUMBER_MAX;
+            break;
+        }
+    }
+    return bound;
+}
+
+/* Write a number backwards into a small buffer, returns the start */
+static char * write_number(unsigned long long value, char *end) {
+    do {
+        *(--end) = '0' + (value % 10);
+        value /= 10;
+    } while (0 != value);
+    return end;
+}
+
+/**
+ * Expands a template into a buffer and terminates it. Nothing is
+ * allocated.
+ *
+ * @author Oscar Norlander
+ *
+ * @param tpl The template.
+ * @param values The values of the request.
+ * @param out The buffer.
+ * @param out_size The size of out.
+ *
+ * @return long The length written, -1 if out is too small.
+ */
+long orctpl_expand(const orctemplate *tpl, const orctpl_values *values,
+                   char *out, size_t out_size) {
+    size_t used = 0;
+    int i;
+    for (i = 0; i < tpl->count; i++) {
+        const orctpl_part *part = &(tpl->parts[i]);
+        const char *src = 0;
+        size_t len = 0;
+        char number[TPL_NUMBER_MAX];
+        char *number_end = number + sizeof(number);
+        int j;
+
+        switch (part->kind) {
+        case orctpl_literal:
+            src = tpl->text + part->offset;
+            len = part->len;
+            break;
+        case orctpl_random:
+            for (j = 0; j < TPL_RANDOM_LEN; j++) {
+                number[j] = hex_digits[(values->random >> (j * 4)) & 0xf];
+            }
+            src = number;
+            len = TPL_RANDOM_LEN;
+            break;
+        case orctpl_counter:
+            src = write_number(values->counter, number_end);
+            len = number_end - src;
+            break;
+        case orctpl_thread:
+            src = write_number(values->thread, number_end);
+            len = number_end - src;
+            break;
+        case orctpl_timestamp:
+            src = write_number(values->timestamp, number_end);
+            len = number_end - src;
+            break;
+        case orctpl_csv:
+            if (part->column < values->column_count) {
+                src = values->columns[part->column];
+                len = values->column_lens[part->column];
+            }
+            break;
+        case orctpl_url:
+            src = values->url;
+            len = values->url_len;
+            break;
+        }
+        if (out_size <= used + len) {
+            return -1;
+        }
+        if (0 < len) {
+            memcpy(out + used, src, len);
+        }
+        used += len;
+    }
+    if (out_size <= used) {
+        return -1;
+    }
+    out[used] = '\0';
+    return (long)used;
+}
+
+/**
+ * Frees the memory of a template.
+ *
+ * @author Oscar Norlander
+ *
+ * @param tpl The template.
+ */
+void orctpl_free(orctemplate *tpl) {
+    free(tpl->text);
+    free(tpl->parts);
+    memset(tpl, 0, sizeof(orctemplate));
+}
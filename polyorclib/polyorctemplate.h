@@ -0,0 +1,81 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCTEMPLATE_H
+#define POLYORCTEMPLATE_H
+
+#include <stddef.h>
+
+/* The most csv columns a template can refer to */
+#define ORC_TPL_MAX_COLUMNS 32
+
+/* What a part of a template expands to */
+enum orctpl_kind {
+    orctpl_literal = 0, /* Text of the template */
+    orctpl_random, /* {{random}} 16 random hex digits */
+    orctpl_counter, /* {{counter}} requests started by the thread */
+    orctpl_thread, /* {{thread}} the thread number */
+    orctpl_timestamp, /* {{timestamp}} milliseconds since the epoch */
+    orctpl_csv, /* {{csv:N}} column N (from 1) of the csv row */
+    orctpl_url /* {{url}} the url of the request */
+};
+
+typedef struct _orctpl_part {
+    enum orctpl_kind kind;
+    size_t offset; /* Literal text in the template */
+    size_t len;
+    int column; /* From 0, only for orctpl_csv */
+} orctpl_part;
+
+/**
+ * A template parsed once, so expanding it only copies literals and
+ * writes values.
+ */
+typedef struct _orctemplate {
+    char *text; /**< A copy of the template */
+    orctpl_part *parts;
+    int count; /**< The number of parts */
+} orctemplate;
+
+/**
+ * The values of one request. Columns and url may be 0 if the template
+ * does not use them.
+ */
+typedef struct _orctpl_values {
+    unsigned long long random;
+    unsigned long long counter;
+    int thread;
+    unsigned long long timestamp;
+    const char *columns[ORC_TPL_MAX_COLUMNS];
+    size_t column_lens[ORC_TPL_MAX_COLUMNS];
+    int column_count;
+    const char *url;
+    size_t url_len;
+} orctpl_values;
+
+int orctpl_parse(orctemplate *tpl, const char *text, size_t len);
+
+int orctpl_is_static(const orctemplate *tpl);
+
+size_t orctpl_bound(const orctemplate *tpl, size_t column_max, size_t url_max);
+
+long orctpl_expand(const orctemplate *tpl, const orctpl_values *values,
+                   char *out, size_t out_size);
+
+void orctpl_free(orctemplate *tpl);
+
+#endif
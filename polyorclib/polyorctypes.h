@@ -18,12 +18,100 @@
 #ifndef POLYORCTYPES_H
 #define POLYORCTYPES_H
 
+#include "polyorchistogram.h"
+
+/* The timings recorded for every completed request, all in microseconds.
+   ttfb is from the start of the request to the first byte of the response
+   and transfer is from there to the last byte. dns, connect and tls are
+   only recorded when the request had to open a new connection. */
+enum orc_latency {
+    orcl_total = 0,
+    orcl_dns,
+    orcl_connect,
+    orcl_tls,
+    orcl_ttfb,
+    orcl_transfer,
+    orcl_count
+};
+
+/* Responses by the first digit of the http status, none if the transfer
+   failed before a status arrived */
+enum orc_status {
+    orcc_none = 0,
+    orcc_1xx,
+    orcc_2xx,
+    orcc_3xx,
+    orcc_4xx,
+    orcc_5xx,
+    orcc_count
+};
+
+/* The most common reasons a transfer fails in curl */
+enum orc_failure {
+    orcf_connect = 0, /* Refused or unreachable */
+    orcf_timeout,
+    orcf_dns,
+    orcf_tls,
+    orcf_other,
+    orcf_count
+};
+
+/* Exact status codes counted per thread, codes that do not fit are only
+   counted in their class */
+#define ORC_MAX_CODES 16
+
+typedef struct _orccode {
+    int code;
+    unsigned long long count;
+} orccode;
+
+/* The most steps a load profile can have */
+#define ORC_MAX_STEPS 32
+
+/* What happened during one step of a load profile */
+typedef struct _orcstep {
+    double seconds; /* How long the step has been active */
+    unsigned long long hits;
+    unsigned long long total_bytes;
+    unsigned long long missed;
+    orchistogram latency; /* Total time in microseconds */
+} orcstep;
+
+/* The most steps a scenario can have */
+#define ORC_MAX_FLOW 16
+#define ORC_FLOW_NAME_LEN 16
+
+/* What the requests of one step of a scenario did */
+typedef struct _orcflowstep {
+    char name[ORC_FLOW_NAME_LEN];
+    unsigned long long hits;
+    unsigned long long total_bytes;
+    orchistogram latency; /* Total time in microseconds */
+} orcflowstep;
+
 typedef struct _orcstatistics {
     int thread_no;
-    int bytes_sec;
+    unsigned long long started; /* Microseconds since the epoch */
+    unsigned long long published; /* Same clock, when the counters were read */
     unsigned long long total_bytes;
-    unsigned int hits_sec;
-    unsigned int hits;
+    unsigned long long hits;
+    unsigned long long missed; /* Open-loop arrivals dropped at the cap */
+    unsigned long long connects; /* New connections opened */
+    unsigned long long multiplexed; /* Transfers run as h2 or h3 streams */
+    unsigned long long aborted; /* In flight when the drain timed out */
+    unsigned long long failed; /* Hits with a curl error, 4xx or 5xx */
+    unsigned long long status[orcc_count];
+    orccode codes[ORC_MAX_CODES]; /* In the order they were first seen */
+    unsigned long long failures[orcf_count];
+    orchistogram latency[orcl_count];
+    orchistogram ok_latency; /* Total time of hits that did not fail */
+    orchistogram failed_latency;
+    int step; /* Active profile step starting at 1, 0 without a profile */
+    double target; /* Events or rate this thread aims for in the step */
+    orcstep steps[ORC_MAX_STEPS];
+    int flow_count; /* Steps of the scenario, 0 without one */
+    unsigned long long sessions; /* Times a virtual user ran the scenario */
+    orcflowstep flow[ORC_MAX_FLOW];
 } orcstatistics;
 
 #endif
@@ -0,0 +1,188 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcurlstat.h"
+
+/* The bucket of a value, like orchist_index with fewer sub buckets */
+static int sketch_index(unsigned long long value) {
+    if (value < ORC_SKETCH_SUB_COUNT) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= ORC_HIST_MAX_BITS) {
+        return ORC_SKETCH_BUCKETS - 1;
+    }
+    int shift = msb - ORC_SKETCH_SUB_BITS;
+    return (shift + 1) * ORC_SKETCH_SUB_COUNT +
+        (int)((value >> shift) - ORC_SKETCH_SUB_COUNT);
+}
+
+/* The largest value of a bucket */
+static unsigned long long sketch_high(int index) {
+    int shift = index >> ORC_SKETCH_SUB_BITS;
+    if (0 == shift) {
+        return index;
+    }
+    unsigned long long low = ((unsigned long long)
+        (index & (ORC_SKETCH_SUB_COUNT - 1)) + ORC_SKETCH_SUB_COUNT) <<
+        (shift - 1);
+    return low + (1ULL << (shift - 1)) - 1;
+}
+
+/* The share of failed hits, for ordering */
+static double error_rate(const orcurlstat *url) {
+    return (0 == url->count) ? 0 : (double)url->errors / url->count;
+}
+
+/* Is url a ordered before url b */
+static int url_before(const orcurlstat *urls, unsigned int a, unsigned int b,
+                      enum orc_urlorder order) {
+    if (orcu_errors == order) {
+        double rate_a = error_rate(&(urls[a]));
+        double rate_b = error_rate(&(urls[b]));
+        if (rate_a != rate_b) {
+            return rate_a > rate_b;
+        }
+        return urls[a].errors > urls[b].errors;
+    }
+    unsigned long long p99_a = orcurl_percentile(&(urls[a]), 99.0);
+    unsigned long long p99_b = orcurl_percentile(&(urls[b]), 99.0);
+    if (p99_a != p99_b) {
+        return p99_a > p99_b;
+    }
+    return urls[a].count > urls[b].count;
+}
+
+/**
+ * Records a hit of a url.
+ *
+ * @author Oscar Norlander
+ *
+ * @param url The statistics of the url.
+ * @param latency The total time of the hit in microseconds.
+ * @param bytes The size of the body.
+ * @param failed Set if the hit failed.
+ */
+void orcurl_record(orcurlstat *url, unsigned long long latency,
+                   unsigned long long bytes, int failed) {
+    url->count++;
+    if (0 != failed) {
+        url->errors++;
+    }
+    url->bytes += bytes;
+    url->buckets[sketch_index(latency)]++;
+}
+
+/**
+ * Adds the statistics of an array of urls to another, for example to
+ * get the sum of all threads.
+ *
+ * @author Oscar Norlander
+ *
+ * @param dst The urls that are updated.
+ * @param src The urls that are added.
+ * @param count The number of urls in both.
+ */
+void orcurl_merge(orcurlstat *dst, const orcurlstat *src, unsigned int count) {
+    unsigned int i;
+    int j;
+    for (i = 0; i < count; i++) {
+        if (0 == src[i].count) {
+            continue;
+        }
+        dst[i].count += src[i].count;
+        dst[i].errors += src[i].errors;
+        dst[i].bytes += src[i].bytes;
+        for (j = 0; j < ORC_SKETCH_BUCKETS; j++) {
+            dst[i].buckets[j] += src[i].buckets[j];
+        }
+    }
+}
+
+/**
+ * Returns a percentile of the latency of a url, the largest value of
+ * the bucket it falls in.
+ *
+ * @author Oscar Norlander
+ *
+ * @param url The statistics of the url.
+ * @param percentile From 0 to 100.
+ *
+ * @return unsigned long long The latency, 0 without hits.
+ */
+unsigned long long orcurl_percentile(const orcurlstat *url, double percentile) {
+    int i;
+    if (0 == url->count) {
+        return 0;
+    }
+    if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    unsigned long long rank =
+        (unsigned long long)((percentile / 100.0) * url->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    unsigned long long seen = 0;
+    for (i = 0; i < ORC_SKETCH_BUCKETS; i++) {
+        seen += url->buckets[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+    return sketch_high((i < ORC_SKETCH_BUCKETS) ? i : ORC_SKETCH_BUCKETS - 1);
+}
+
+/**
+ * Finds the slowest urls or the urls that fail most. Urls without hits
+ * are left out, and so are urls without errors when ordering by errors.
+ *
+ * @author Oscar Norlander
+ *
+ * @param urls The statistics of every url.
+ * @param count The number of urls.
+ * @param order What to order by.
+ * @param top Set to the indexes of the first urls.
+ * @param max The most indexes to set.
+ *
+ * @return int The number of indexes set.
+ */
+int orcurl_top(const orcurlstat *urls, unsigned int count,
+               enum orc_urlorder order, unsigned int *top, int max) {
+    unsigned int i;
+    int j;
+    int found = 0;
+    for (i = 0; i < count; i++) {
+        if (0 == urls[i].count ||
+            (orcu_errors == order && 0 == urls[i].errors)) {
+            continue;
+        }
+        /* An insertion into the short sorted list */
+        for (j = found; 0 < j && url_before(urls, i, top[j - 1], order); j--) {
+            if (j < max) {
+                top[j] = top[j - 1];
+            }
+        }
+        if (j < max) {
+            top[j] = i;
+            if (found < max) {
+                found++;
+            }
+        }
+    }
+    return found;
+}
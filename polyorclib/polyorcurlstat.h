@@ -0,0 +1,58 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCURLSTAT_H
+#define POLYORCURLSTAT_H
+
+#include "polyorchistogram.h"
+
+/* A sketch splits every power of two range in 2^ORC_SKETCH_SUB_BITS
+   buckets, so a percentile is within 1/4 of the real value. It covers
+   the same range as orchistogram with far fewer buckets. */
+#define ORC_SKETCH_SUB_BITS 2
+#define ORC_SKETCH_SUB_COUNT (1 << ORC_SKETCH_SUB_BITS)
+#define ORC_SKETCH_BUCKETS \
+    ((ORC_HIST_MAX_BITS - ORC_SKETCH_SUB_BITS + 1) * ORC_SKETCH_SUB_COUNT)
+
+/* How orcurl_top orders urls */
+enum orc_urlorder {
+    orcu_p99 = 0, /* Slowest first */
+    orcu_errors /* Highest share of failed hits first */
+};
+
+/**
+ * What the hits of one url did, 512 bytes so an array of them stays
+ * aligned to cache lines. The latency is in microseconds.
+ */
+typedef struct _orcurlstat {
+    unsigned int count; /**< Hits */
+    unsigned int errors; /**< Hits that failed */
+    unsigned long long bytes; /**< Body bytes */
+    unsigned int buckets[ORC_SKETCH_BUCKETS]; /**< Latency counts */
+} orcurlstat;
+
+void orcurl_record(orcurlstat *url, unsigned long long latency,
+                   unsigned long long bytes, int failed);
+
+void orcurl_merge(orcurlstat *dst, const orcurlstat *src, unsigned int count);
+
+unsigned long long orcurl_percentile(const orcurlstat *url, double percentile);
+
+int orcurl_top(const orcurlstat *urls, unsigned int count,
+               enum orc_urlorder order, unsigned int *top, int max);
+
+#endif
@@ -62,3 +62,26 @@ void free_array_of_charptr_incl(char ***arr, const int len) {
     free(tmp);
     (*arr) = 0;
 }
+
+/**
+ * Updates a running 32 bit FNV-1a hash. Start with ORC_FNV1A_INIT
+ * and feed the data in as many parts as needed.
+ *
+ * @author Oscar Norlander
+ *
+ * @param hash The hash so far.
+ * @param data The next part of the data.
+ * @param len The length of data.
+ *
+ * @return unsigned int The updated hash.
+ */
+unsigned int orc_fnv1a(unsigned int hash, const void *data, size_t len) {
+    const unsigned char *ptr = data;
+    const unsigned char *end = ptr + len;
+    while (ptr < end) {
+        hash ^= *ptr;
+        hash *= 16777619U;
+        ptr++;
+    }
+    return hash;
+}
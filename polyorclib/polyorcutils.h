@@ -18,10 +18,17 @@
 #ifndef POLYORCUTILS_H
 #define POLYORCUTILS_H
 
+#include <stddef.h>
+
+/* Start value for orc_fnv1a */
+#define ORC_FNV1A_INIT 2166136261U
+
 int intpow(int x, int y);
 
 void free_array_of_charptr_excl(char ***arr);
 
 void free_array_of_charptr_incl(char ***arr, const int len);
 
+unsigned int orc_fnv1a(unsigned int hash, const void *data, size_t len);
+
 #endif
@@ -0,0 +1,346 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "polyorcwire.h"
+#include "polyorcstats.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* A growing output buffer */
+typedef struct _wirebuf {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} wirebuf;
+
+static void wire_printf(wirebuf *buf, const char *format, ...) {
+    va_list args;
+    int need;
+    if (0 != buf->failed) {
+        return;
+    }
+    while (1) {
+        va_start(args, format);
+        need = vsnprintf(buf->data + buf->len, buf->cap - buf->len, format,
+                         args);
+        va_end(args);
+        if (0 > need) {
+            buf->failed = 1;
+            return;
+        }
+        if ((size_t)need < buf->cap - buf->len) {
+            buf->len += need;
+            return;
+        }
+        size_t cap = buf->cap * 2 + need;
+        char *data = realloc(buf->data, cap);
+        if (0 == data) {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = data;
+        buf->cap = cap;
+    }
+}
+
+static void wire_hist(wirebuf *buf, const char *what, int index,
+                      const orchistogram *hist) {
+    int i;
+    if (0 == hist->count) {
+        return;
+    }
+    wire_printf(buf, "hist %s %d %llu %llu %llu %llu", what, index,
+                hist->count, hist->sum, hist->min, hist->max);
+    for (i = 0; i < ORC_HIST_BUCKETS; i++) {
+        if (0 != hist->buckets[i]) {
+            wire_printf(buf, " %d:%llu", i, hist->buckets[i]);
+        }
+    }
+    wire_printf(buf, "\n");
+}
+
+/**
+ * Encodes statistics as text.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stat The statistics.
+ * @param len Set to the length of the encoding.
+ *
+ * @return char * The terminated encoding to free, 0 if out of memory.
+ */
+char * orcwire_encode(const orcstatistics *stat, size_t *len) {
+    int i;
+    wirebuf buf;
+    buf.cap = 4096;
+    buf.len = 0;
+    buf.failed = 0;
+    buf.data = malloc(buf.cap);
+    if (0 == buf.data) {
+        return 0;
+    }
+    wire_printf(&buf, "orcstat %d\n", ORC_WIRE_VERSION);
+    wire_printf(&buf, "thread %d\n", stat->thread_no);
+    wire_printf(&buf, "time %llu %llu\n", stat->started, stat->published);
+    wire_printf(&buf, "counters %llu %llu %llu %llu %llu %llu %llu %llu\n",
+                stat->total_bytes, stat->hits, stat->missed, stat->connects,
+                stat->multiplexed, stat->aborted, stat->sessions,
+                stat->failed);
+    wire_printf(&buf, "status");
+    for (i = 0; i < orcc_count; i++) {
+        wire_printf(&buf, " %llu", stat->status[i]);
+    }
+    wire_printf(&buf, "\nfailures");
+    for (i = 0; i < orcf_count; i++) {
+        wire_printf(&buf, " %llu", stat->failures[i]);
+    }
+    wire_printf(&buf, "\n");
+    for (i = 0; i < ORC_MAX_CODES && 0 != stat->codes[i].count; i++) {
+        wire_printf(&buf, "code %d %llu\n", stat->codes[i].code,
+                    stat->codes[i].count);
+    }
+    wire_printf(&buf, "profile %d %.17g\n", stat->step, stat->target);
+    for (i = 0; i < orcl_count; i++) {
+        wire_hist(&buf, "lat", i, &(stat->latency[i]));
+    }
+    wire_hist(&buf, "ok", 0, &(stat->ok_latency));
+    wire_hist(&buf, "failed", 0, &(stat->failed_latency));
+    for (i = 0; i < ORC_MAX_STEPS; i++) {
+        const orcstep *step = &(stat->steps[i]);
+        if (0 == step->seconds && 0 == step->hits && 0 == step->missed &&
+            0 == step->total_bytes && 0 == step->latency.count) {
+            continue;
+        }
+        wire_printf(&buf, "step %d %.17g %llu %llu %llu\n", i, step->seconds,
+                    step->hits, step->total_bytes, step->missed);
+        wire_hist(&buf, "step", i, &(step->latency));
+    }
+    wire_printf(&buf, "flows %d\n", stat->flow_count);
+    for (i = 0; i < stat->flow_count && i < ORC_MAX_FLOW; i++) {
+        const orcflowstep *flow = &(stat->flow[i]);
+        /* Scenario step names have no blanks, - stands for no name */
+        wire_printf(&buf, "flow %d %.*s %llu %llu\n", i, ORC_FLOW_NAME_LEN,
+                    ('\0' == flow->name[0]) ? "-" : flow->name, flow->hits,
+                    flow->total_bytes);
+        wire_hist(&buf, "flow", i, &(flow->latency));
+    }
+    wire_printf(&buf, "end\n");
+    if (0 != buf.failed) {
+        free(buf.data);
+        return 0;
+    }
+    *len = buf.len;
+    return buf.data;
+}
+
+/* Parse the fields of a hist line after its kind */
+static int parse_hist(orcstatistics *stat, const char *what, char *pos) {
+    int index;
+    int used;
+    orchistogram *hist;
+    if (1 != sscanf(pos, "%d%n", &index, &used) || 0 > index) {
+        return 0;
+    }
+    pos += used;
+    if (0 == strcmp("lat", what) && index < orcl_count) {
+        hist = &(stat->latency[index]);
+    } else if (0 == strcmp("step", what) && index < ORC_MAX_STEPS) {
+        hist = &(stat->steps[index].latency);
+    } else if (0 == strcmp("flow", what) && index < ORC_MAX_FLOW) {
+        hist = &(stat->flow[index].latency);
+    } else if (0 == strcmp("ok", what) && 0 == index) {
+        hist = &(stat->ok_latency);
+    } else if (0 == strcmp("failed", what) && 0 == index) {
+        hist = &(stat->failed_latency);
+    } else {
+        return 0;
+    }
+    if (4 != sscanf(pos, "%llu %llu %llu %llu%n", &(hist->count),
+                    &(hist->sum), &(hist->min), &(hist->max), &used)) {
+        return 0;
+    }
+    pos += used;
+    while (' ' == *pos) {
+        char *end;
+        long bucket = strtol(pos + 1, &end, 10);
+        if (':' != *end || 0 > bucket || ORC_HIST_BUCKETS <= bucket) {
+            return 0;
+        }
+        pos = end + 1;
+        hist->buckets[bucket] = strtoull(pos, &end, 10);
+        if (end == pos) {
+            return 0;
+        }
+        pos = end;
+    }
+    return '\0' == *pos;
+}
+
+/* Parse a fixed number of counters */
+static int parse_counts(char *pos, unsigned long long *counts, int count) {
+    int i;
+    for (i = 0; i < count; i++) {
+        char *end;
+        counts[i] = strtoull(pos, &end, 10);
+        if (end == pos || ' ' != *pos) {
+            return 0;
+        }
+        pos = end;
+    }
+    return '\0' == *pos;
+}
+
+/* Decode one line, returns 2 for the end line */
+static int decode_line(orcstatistics *stat, char *line) {
+    char word[16];
+    char name[ORC_FLOW_NAME_LEN + 1];
+    int used;
+    int index;
+    int version;
+    if (1 != sscanf(line, "%15s%n", word, &used)) {
+        return 0;
+    }
+    char *pos = line + used;
+    if (0 == strcmp("orcstat", word)) {
+        return 1 == sscanf(pos, "%d", &version) && ORC_WIRE_VERSION == version;
+    }
+    if (0 == strcmp("thread", word)) {
+        return 1 == sscanf(pos, "%d", &(stat->thread_no));
+    }
+    if (0 == strcmp("time", word)) {
+        return 2 == sscanf(pos, "%llu %llu", &(stat->started),
+                           &(stat->published));
+    }
+    if (0 == strcmp("counters", word)) {
+        return 8 == sscanf(pos, "%llu %llu %llu %llu %llu %llu %llu %llu",
+                           &(stat->total_bytes), &(stat->hits),
+                           &(stat->missed), &(stat->connects),
+                           &(stat->multiplexed), &(stat->aborted),
+                           &(stat->sessions), &(stat->failed));
+    }
+    if (0 == strcmp("status", word)) {
+        return parse_counts(pos, stat->status, orcc_count);
+    }
+    if (0 == strcmp("failures", word)) {
+        return parse_counts(pos, stat->failures, orcf_count);
+    }
+    if (0 == strcmp("code", word)) {
+        unsigned long long count;
+        if (2 != sscanf(pos, "%d %llu", &index, &count) || 0 == count) {
+            return 0;
+        }
+        orcstat_count_code(stat, index, count);
+        return 1;
+    }
+    if (0 == strcmp("profile", word)) {
+        return 2 == sscanf(pos, "%d %lf", &(stat->step), &(stat->target));
+    }
+    if (0 == strcmp("step", word)) {
+        if (1 != sscanf(pos, "%d%n", &index, &used) || 0 > index ||
+            ORC_MAX_STEPS <= index) {
+            return 0;
+        }
+        orcstep *step = &(stat->steps[index]);
+        return 4 == sscanf(pos + used, "%lf %llu %llu %llu", &(step->seconds),
+                           &(step->hits), &(step->total_bytes),
+                           &(step->missed));
+    }
+    if (0 == strcmp("flows", word)) {
+        return 1 == sscanf(pos, "%d", &(stat->flow_count)) &&
+               0 <= stat->flow_count && ORC_MAX_FLOW >= stat->flow_count;
+    }
+    if (0 == strcmp("flow", word)) {
+        if (1 != sscanf(pos, "%d%n", &index, &used) || 0 > index ||
+            ORC_MAX_FLOW <= index) {
+            return 0;
+        }
+        orcflowstep *flow = &(stat->flow[index]);
+        if (3 != sscanf(pos + used, "%16s %llu %llu", name, &(flow->hits),
+                        &(flow->total_bytes))) {
+            return 0;
+        }
+        if (0 != strcmp("-", name)) {
+            memset(flow->name, 0, sizeof(flow->name));
+            memcpy(flow->name, name, strnlen(name, ORC_FLOW_NAME_LEN));
+        }
+        return 1;
+    }
+    if (0 == strcmp("hist", word)) {
+        if (1 != sscanf(pos, "%15s%n", word, &used)) {
+            return 0;
+        }
+        return parse_hist(stat, word, pos + used);
+    }
+    if (0 == strcmp("end", word)) {
+        return 2;
+    }
+    return 0;
+}
+
+/**
+ * Decodes statistics encoded by orcwire_encode.
+ *
+ * @author Oscar Norlander
+ *
+ * @param stat Cleared and set to the decoded statistics.
+ * @param text The encoding, it does not have to be terminated.
+ * @param len The length of the encoding.
+ *
+ * @return int 1 on succes 0 on fail
+ */
+int orcwire_decode(orcstatistics *stat, const char *text, size_t len) {
+    const char *pos = text;
+    const char *end = text + len;
+    int first = 1;
+    char *line = 0;
+    size_t cap = 0;
+    memset(stat, 0, sizeof(orcstatistics));
+    while (pos < end) {
+        const char *nl = memchr(pos, '\n', end - pos);
+        size_t line_len = ((0 != nl) ? nl : end) - pos;
+        if (line_len + 1 > cap) {
+            cap = line_len + 1;
+            char *bigger = realloc(line, cap);
+            if (0 == bigger) {
+                free(line);
+                return 0;
+            }
+            line = bigger;
+        }
+        memcpy(line, pos, line_len);
+        line[line_len] = '\0';
+        pos += line_len + 1;
+
+        int status = decode_line(stat, line);
+        if (0 == status || (1 == first && 0 != strncmp("orcstat ", line, 8))) {
+            free(line);
+            return 0;
+        }
+        first = 0;
+        if (2 == status) {
+            free(line);
+            return 1;
+        }
+    }
+    /* Cut short */
+    free(line);
+    return 0;
+}
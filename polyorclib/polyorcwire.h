@@ -0,0 +1,38 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#ifndef POLYORCWIRE_H
+#define POLYORCWIRE_H
+
+#include "polyorctypes.h"
+
+#include <stddef.h>
+
+/* Bumped when the encoding changes */
+#define ORC_WIRE_VERSION 3
+
+/**
+ * A text encoding of orcstatistics for sending them between processes.
+ * One record per line, empty histograms and steps are left out and the
+ * buckets of a histogram are written as index:count pairs. Decoding an
+ * encoding gives back the same statistics.
+ */
+char * orcwire_encode(const orcstatistics *stat, size_t *len);
+
+int orcwire_decode(orcstatistics *stat, const char *text, size_t len);
+
+#endif
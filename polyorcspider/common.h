@@ -30,6 +30,8 @@ typedef struct _arguments {
     const char *out_file;
     char **excludes;
     int excludes_len;
+    char **includes;
+    int includes_len;
 } arguments;
 
 #define ORC_USERAGENT ORC_NAME"/"ORC_VERSION
@@ -57,6 +57,8 @@ static struct argp_option options[] = {
                                       DEFAULT_MAX_EVENTS_STR ")" },
     {"out",          'o', "FILE",  0, "Output file (default " DEFAULT_OUT ")"},
     {"exclude",     1001, "REGEX", 0, "Exclude pattern" },
+    {"include",     1002, "REGEX", 0, "Only follow urls that match one of "
+                                      "the include patterns" },
     { 0 }
 };
 
@@ -79,6 +81,19 @@ static void check_color(struct argp_state *state,
     }
 }
 
+/* Appends a pattern to a list of patterns */
+static void add_pattern(char ***patterns, int *len, char *pattern)
+{
+    char **tmp = realloc(*patterns, (*len + 1) * sizeof(char *));
+    if (0 == tmp) {
+        free(*patterns);
+        orcerror("%s (%d)\n", strerror(errno), errno);
+        exit(EXIT_FAILURE);
+    }
+    tmp[(*len)++] = pattern;
+    (*patterns) = tmp;
+}
+
 /* Parse a single option. */
 static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
 {
@@ -119,19 +134,10 @@ static error_t parse_opt(int key, char *opt_arg, struct argp_state *state)
         }
         break;
     case 1001:
-        arg->excludes_len++;
-        size_t size = arg->excludes_len * sizeof(*(arg->excludes));
-        char **tmp;
-        tmp = realloc(arg->excludes, size);
-        if (0 == tmp) {
-            if (0 != arg->excludes) {
-                free(arg->excludes);
-            }
-            orcerror("%s (%d)\n", strerror(errno), errno);
-            exit(EXIT_FAILURE);
-        }
-        tmp[arg->excludes_len - 1] = opt_arg;
-        arg->excludes = tmp;
+        add_pattern(&(arg->excludes), &(arg->excludes_len), opt_arg);
+        break;
+    case 1002:
+        add_pattern(&(arg->includes), &(arg->includes_len), opt_arg);
         break;
     case 'o':
         arg->out_file = opt_arg;
@@ -183,6 +189,8 @@ int main(int argc, char *argv[])
     arg.out_file = DEFAULT_OUT;
     arg.excludes = 0;
     arg.excludes_len = 0;
+    arg.includes = 0;
+    arg.includes_len = 0;
 
     /* Parse our arguments; every option seen by parse_opt will
        be reflected in arguments. */
@@ -202,6 +210,7 @@ int main(int argc, char *argv[])
     crawl(&arg);
 
     free(arg.excludes);
+    free(arg.includes);
 
     orcout(orcm_quiet, "Done!\n");
     return EXIT_SUCCESS;
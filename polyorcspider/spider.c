@@ -24,6 +24,7 @@
 #include "polyorcbintree.h"
 #include "polyorcutils.h"
 #include "polyorcmatcher.h"
+#include "polyorcscan.h"
 #include "polyorcout.h"
 #include "polyorcdefs.h"
 
@@ -55,6 +56,7 @@ typedef struct _global_info {
     int still_running;
     CURLM *multi;
     find_urls_input input;
+    orcmatcher matcher; /* The patterns of input, compiled once */
     int job_max;
     int job_count;
     url_node *url_out;
@@ -70,8 +72,10 @@ typedef struct _conn_info {
     CURL *easy;
     char *url;
     global_info *global;
-    char *memory;
-    size_t memory_size;
+    size_t body_size;
+    int follow; /* 1 if the links of the page are followed, -1 not known */
+    orcstream stream; /* Finds the links while the page arrives */
+    orcbase base; /* Makes the links of the page absolute */
     char error[CURL_ERROR_SIZE];
 } conn_info;
 
@@ -142,26 +146,21 @@ static void mcode_or_die(const char *where, CURLMcode code) {
     }
 }
 
-/* Find urls in a page and keep them */
-static void analyze_page(global_info *global, conn_info *conn) {
-    /* Analyze */
-    int matches = 0;
-    global->input.url = conn->url;
-    if(-1 == (matches = find_urls(conn->memory, &(global->input))))
-    {
-        if (0 != global->input.ret_len) {
-            free_array_of_charptr_incl(&(global->input.ret),
-                                       global->input.ret_len);
+/* Find urls in the next part of a page and put them in the fifo, the
+   page is not kept */
+static void analyze_chunk(global_info *global, conn_info *conn,
+                          const char *chunk, size_t len) {
+    orclink link;
+    char *url;
+    orcstream_feed(&(conn->stream), chunk, len);
+    while (orcstream_next(&(conn->stream), &link)) {
+        int status = orcmatcher_check_url(&(global->matcher), &(conn->base),
+                                          link.start, link.len, &url);
+        if (-1 == status) {
+            exit(EXIT_FAILURE);
+        } else if (1 == status) {
+            url_add(global, url);
         }
-        exit(EXIT_FAILURE);
-    }
-    global->input.url = 0;
-
-    /* Save */
-    int i;
-    for (i = 0; i < matches; i++) {
-        url_add(global, global->input.ret[i]);
-        global->input.ret[i] = 0;
     }
 }
 
@@ -207,7 +206,6 @@ static void check_multi_info(global_info *global) {
             orcout(orcm_debug, "response code:%ld connect_code:%ld\n", response_code, connect_code);
             orcout(orcm_debug, "DONE: %s => (%d) %s\n", effective_url,
                    result, conn->error);
-            orcout(orcm_debug, "%s", conn->memory);
             /* Cleanup the finished easy handle */
             curl_multi_remove_handle(global->multi, easy);
             curl_easy_cleanup(easy);
@@ -220,10 +218,8 @@ static void check_multi_info(global_info *global) {
                              global->out_name);
                     exit(EXIT_FAILURE);
                 }
-                /* Analyze here */
-                analyze_page(global, conn);
-                /* Collect stats */
-                global->total_bytes += conn->memory_size;
+                /* The links were found while the page arrived */
+                global->total_bytes += conn->body_size;
             } else if(0 == done){
                 /* Mark as dead */
                 url_info *info = 0;
@@ -234,11 +230,9 @@ static void check_multi_info(global_info *global) {
                 }
                 orcstatus(orcm_verbose, orc_red, "dead", "%s\n", conn->url);
             }
-            /* Create new readers here */
-            read_new_pages(global);
             /* Cleanups after download */
+            orcbase_free(&(conn->base));
             free(conn->url);
-            free(conn->memory);
             free(conn);
         }
     }
@@ -256,6 +250,8 @@ static void socket_action_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
                                   &(global->still_running));
     mcode_or_die("socket_action_timer_cb: curl_multi_socket_action", rc);
     check_multi_info(global);
+    /* Create new readers here, outside the callbacks of curl */
+    read_new_pages(global);
 }
 
 /* Update the event timer ("wait for socket actions") after curl_multi library
@@ -263,12 +259,12 @@ static void socket_action_timer_cb(struct ev_loop *loop, struct ev_timer *timer,
 static int multi_timer_cb(CURLM *multi, long timeout_ms, global_info *global) {
     orcout(orcm_debug, "%s timeout %li\n", __PRETTY_FUNCTION__,  timeout_ms);
     ev_timer_stop(global->loop, &(global->timer_event));
-    if (timeout_ms > 0) {
-        double  t = timeout_ms / 1000;
-        ev_timer_init(&(global->timer_event), socket_action_timer_cb, t, 0.);
+    if (timeout_ms >= 0) {
+        /* libcurl refuses socket_action calls from inside its own
+           callbacks, so a zero timeout also goes through the loop */
+        double  t = timeout_ms / 1000.0;
+        ev_timer_set(&(global->timer_event), t, 0.);
         ev_timer_start(global->loop, &(global->timer_event));
-    } else {
-        socket_action_timer_cb(global->loop, &(global->timer_event), 0);
     }
     return 0;
 }
@@ -286,6 +282,7 @@ static void event_cb(struct ev_loop *loop, struct ev_io *event_io, int revents)
                                   &(global->still_running));
     mcode_or_die("event_cb: curl_multi_socket_action", rc);
     check_multi_info(global);
+    read_new_pages(global);
     if (global->still_running <= 0 && global->job_count  <= 0) {
         orcout(orcm_debug, "last transfer done, kill timeout\n");
         ev_timer_stop(global->loop, &(global->timer_event));
@@ -360,21 +357,24 @@ static int sock_cb(CURL *handle, curl_socket_t curl_soc, int what, void *cbp,
     return 0;
 }
 
-/* CURLOPT_WRITEFUNCTION - reads a page and write to memmory */
+/* CURLOPT_WRITEFUNCTION - finds the links of a page as it arrives. Only
+   pages that answer 200 are followed, like the pages written to the out
+   file. */
 static size_t write_cb(void *contents, size_t size, size_t nmemb, void *data) {
     size_t realsize = size * nmemb;
     conn_info *conn = (conn_info *)data;
 
-    conn->memory = realloc(conn->memory, conn->memory_size + realsize + 1);
-    if (0 == conn->memory) {
-        /* out of memory! */
-        orcerror("%s (%d)\n", strerror(errno), errno);
-        exit(EXIT_FAILURE);
+    conn->body_size += realsize;
+    if (-1 == conn->follow) {
+        long response_code = 0;
+        long connect_code = 0;
+        curl_easy_getinfo(conn->easy, CURLINFO_RESPONSE_CODE, &response_code);
+        curl_easy_getinfo(conn->easy, CURLINFO_HTTP_CONNECTCODE, &connect_code);
+        conn->follow = (200 == response_code || 200 == connect_code);
+    }
+    if (1 == conn->follow) {
+        analyze_chunk(conn->global, conn, (const char *)contents, realsize);
     }
-
-    memcpy(&(conn->memory[conn->memory_size]), contents, realsize);
-    conn->memory_size += realsize;
-    conn->memory[conn->memory_size] = 0;
 
     return realsize;
 }
@@ -410,11 +410,13 @@ static void new_conn(char *url, global_info *global) {
         exit(EXIT_FAILURE);
     }
 
-    conn->memory = calloc(1, sizeof(char));
-    conn->memory_size = 0;
+    conn->body_size = 0;
+    conn->follow = -1;
+    orcstream_init(&(conn->stream));
 
     conn->global = global;
     conn->url = strdup(url);
+    orcbase_init(&(conn->base), conn->url);
     curl_easy_setopt(conn->easy, CURLOPT_URL, conn->url);
     curl_easy_setopt(conn->easy, CURLOPT_WRITEFUNCTION, write_cb);
     curl_easy_setopt(conn->easy, CURLOPT_WRITEDATA, conn);
@@ -533,6 +535,8 @@ void crawl(arguments *arg) {
     global.input.search_name_len = SEARCH_NAME_LEN;
     global.input.excludes = arg->excludes;
     global.input.excludes_len = arg->excludes_len;
+    global.input.includes = arg->includes;
+    global.input.includes_len = arg->includes_len;
 
     if (!find_search_name(arg->url, search_name , SEARCH_NAME_LEN))
     {
@@ -540,6 +544,9 @@ void crawl(arguments *arg) {
         exit(EXIT_FAILURE);
     }
     orcoutc(orc_reset, orc_blue, "Target %s\n", global.input.search_name);
+    if (0 == orcmatcher_init(&(global.matcher), &(global.input))) {
+        exit(EXIT_FAILURE);
+    }
 
     add_first_call(arg, &global);
 
@@ -556,6 +563,7 @@ void crawl(arguments *arg) {
     /* Cleanups after looping */
     fclose(global.out);
     free_array_of_charptr_incl(&(global.input.ret), global.input.ret_len);
+    orcmatcher_free(&(global.matcher));
     bintree_free(&(global.url_tree));
     curl_multi_cleanup(global.multi);
 
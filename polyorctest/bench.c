@@ -0,0 +1,101 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "benchpolyorcmatcher.h"
+#include "benchpolyorcrules.h"
+#include "polyorcout.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define BENCH_BASE "http://www.example.com/"
+
+/* Read a whole file into a terminated buffer */
+static int load_page(const char *file_name, bench_page *page) {
+    FILE *file = fopen(file_name, "r");
+    if (0 == file) {
+        orcerror("%s (%d) %s\n", strerror(errno), errno, file_name);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    page->html = malloc(len + 1);
+    page->url = malloc(strlen(BENCH_BASE) + strlen(file_name) + 1);
+    if (0 == page->html || 0 == page->url ||
+        (size_t)len != fread(page->html, 1, len, file)) {
+        orcerror("Could not read %s\n", file_name);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    page->html[len] = '\0';
+    page->len = len;
+    /* Relative links resolve against the path of the file */
+    sprintf(page->url, "%s%s", BENCH_BASE,
+            ('/' == file_name[0]) ? file_name + 1 : file_name);
+    return 1;
+}
+
+/* Runs the microbenchmarks on html files given as arguments. Every -x
+   PATTERN before the files is an exclude pattern and every -i PATTERN an
+   include pattern. */
+int main(int argc, char **argv) {
+    int i = 1;
+    char **excludes = calloc(argc, sizeof(char *));
+    int excludes_len = 0;
+    char **includes = calloc(argc, sizeof(char *));
+    int includes_len = 0;
+    init_polyorcout(orcm_normal, orcc_no_color);
+    while (i + 1 < argc && (0 == strcmp("-x", argv[i]) ||
+                            0 == strcmp("-i", argv[i]))) {
+        if ('x' == argv[i][1]) {
+            excludes[excludes_len++] = argv[i + 1];
+        } else {
+            includes[includes_len++] = argv[i + 1];
+        }
+        i += 2;
+    }
+    if (i == argc) {
+        printf("Usage: %s [-x PATTERN]... [-i PATTERN]... FILE...\n",
+               argv[0]);
+        return EXIT_FAILURE;
+    }
+    int count = argc - i;
+    bench_page *pages = calloc(count, sizeof(bench_page));
+    for (count = 0; i < argc; i++, count++) {
+        if (0 == load_page(argv[i], &(pages[count]))) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    bench_polyorcmatcher(pages, count, excludes, excludes_len, includes,
+                         includes_len);
+    bench_polyorcrules(pages, count, excludes, excludes_len, includes,
+                       includes_len);
+
+    for (i = 0; i < count; i++) {
+        free(pages[i].html);
+        free(pages[i].url);
+    }
+    free(pages);
+    free(excludes);
+    free(includes);
+    return EXIT_SUCCESS;
+}
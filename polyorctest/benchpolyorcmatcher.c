@@ -0,0 +1,222 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "benchpolyorcmatcher.h"
+#include "polyorcmatcher.h"
+#include "polyorcscan.h"
+#include "polyorcbase.h"
+#include "polyorcutils.h"
+#include "polyorcdefs.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <regex.h>
+
+/* Every way of finding links runs at least this many seconds */
+#define BENCH_SECONDS 1.0
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* How links were found before the scanner, one pass per attribute and
+   quote */
+static const char *link_patterns[] = {
+    "href[[:space:]]*=[[:space:]]*\"[[:space:]]*([^\"]*)\"",
+    "href[[:space:]]*=[[:space:]]*'[[:space:]]*([^']*)'",
+    "src[[:space:]]*=[[:space:]]*\"[[:space:]]*([^\"]*)\"",
+    "src[[:space:]]*=[[:space:]]*'[[:space:]]*([^']*)'"
+};
+
+/* Only find the links of every page, with the patterns or the scanner */
+static unsigned long long scan_all(bench_page *pages, int count,
+                                   regex_t *regex) {
+    int i, j;
+    unsigned long long links = 0;
+    for (i = 0; i < count; i++) {
+        if (0 == regex) {
+            orcscanner scan;
+            orclink link;
+            orcscan_init(&scan, pages[i].html, pages[i].len);
+            while (orcscan_next(&scan, &link)) {
+                links++;
+            }
+            continue;
+        }
+        for (j = 0; j < 4; j++) {
+            regmatch_t pmatch[2];
+            const char *current = pages[i].html;
+            while (0 == regexec(&(regex[j]), current, 2, pmatch, 0)) {
+                current += pmatch[1].rm_eo;
+                links++;
+            }
+        }
+    }
+    return links;
+}
+
+/* Repeat the scan of all pages until BENCH_SECONDS have passed */
+static void run_scan(const char *name, bench_page *pages, int count,
+                     regex_t *regex) {
+    int i;
+    size_t bytes = 0;
+    unsigned long long links = 0;
+    int passes = 0;
+    for (i = 0; i < count; i++) {
+        bytes += pages[i].len;
+    }
+    double start = now();
+    double elapsed = 0;
+    while (elapsed < BENCH_SECONDS) {
+        links += scan_all(pages, count, regex);
+        passes++;
+        elapsed = now() - start;
+    }
+    printf("%-12s %8d pages %10llu links %12.0f links/s %10.3f GB/s\n",
+           name, count * passes, links, links / elapsed,
+           bytes * (double)passes / elapsed / 1e9);
+}
+
+/* Make the links of every page absolute, with uriparser only or with the
+   fast joins of orcbase first */
+static unsigned long long resolve_all(bench_page *pages, int count,
+                                      int fast) {
+    int i;
+    unsigned long long links = 0;
+    char url[MAX_URL_LEN + 1];
+    for (i = 0; i < count; i++) {
+        orcscanner scan;
+        orclink link;
+        orcbase base;
+        orcbase_init(&base, pages[i].url);
+        base.fast = base.fast && fast;
+        orcscan_init(&scan, pages[i].html, pages[i].len);
+        while (orcscan_next(&scan, &link)) {
+            if (0 < orcbase_resolve(&base, link.start, link.len, url,
+                                    sizeof(url))) {
+                links++;
+            }
+        }
+        orcbase_free(&base);
+    }
+    return links;
+}
+
+/* Repeat resolving all pages until BENCH_SECONDS have passed */
+static void run_resolve(const char *name, bench_page *pages, int count,
+                        int fast) {
+    unsigned long long links = 0;
+    int passes = 0;
+    double start = now();
+    double elapsed = 0;
+    while (elapsed < BENCH_SECONDS) {
+        links += resolve_all(pages, count, fast);
+        passes++;
+        elapsed = now() - start;
+    }
+    printf("%-12s %8d pages %10llu links %12.0f links/s\n",
+           name, count * passes, links, links / elapsed);
+}
+
+/* Find the links of every page, with a matcher or compiling per page */
+static int find_all(bench_page *pages, int count, find_urls_input *input,
+                    orcmatcher *matcher, unsigned long long *links) {
+    int i;
+    for (i = 0; i < count; i++) {
+        input->url = pages[i].url;
+        int found = (0 != matcher) ?
+            orcmatcher_find_urls(matcher, pages[i].html, input) :
+            find_urls(pages[i].html, input);
+        if (-1 == found) {
+            return 0;
+        }
+        *links += found;
+        free_array_of_charptr_incl(&(input->ret), input->ret_len);
+        input->ret_len = 0;
+    }
+    return 1;
+}
+
+/* Repeat all pages until BENCH_SECONDS have passed and print the rate */
+static void run(const char *name, bench_page *pages, int count,
+                find_urls_input *input, orcmatcher *matcher) {
+    int i;
+    size_t bytes = 0;
+    unsigned long long links = 0;
+    int passes = 0;
+    for (i = 0; i < count; i++) {
+        bytes += pages[i].len;
+    }
+    double start = now();
+    double elapsed = 0;
+    while (elapsed < BENCH_SECONDS) {
+        if (0 == find_all(pages, count, input, matcher, &links)) {
+            printf("%-12s failed\n", name);
+            return;
+        }
+        passes++;
+        elapsed = now() - start;
+    }
+    printf("%-12s %8d pages %10llu links %12.0f links/s %10.2f MB/s\n",
+           name, count * passes, links, links / elapsed,
+           bytes * (double)passes / elapsed / 1e6);
+}
+
+void bench_polyorcmatcher(bench_page *pages, int count, char **excludes,
+                          int excludes_len, char **includes,
+                          int includes_len) {
+    find_urls_input input;
+    orcmatcher matcher;
+    char search_name[SEARCH_NAME_LEN];
+    memset(&input, 0, sizeof(find_urls_input));
+    memset(search_name, '\0', SEARCH_NAME_LEN);
+    if (0 == count || 0 == find_search_name(pages[0].url, search_name,
+                                            SEARCH_NAME_LEN)) {
+        return;
+    }
+    input.search_name = search_name;
+    input.search_name_len = SEARCH_NAME_LEN;
+    input.excludes = excludes;
+    input.excludes_len = excludes_len;
+    input.includes = includes;
+    input.includes_len = includes_len;
+
+    int i;
+    regex_t regex[4];
+    for (i = 0; i < 4; i++) {
+        regcomp(&(regex[i]), link_patterns[i], REG_ICASE | REG_EXTENDED);
+    }
+    run_scan("regex scan", pages, count, regex);
+    for (i = 0; i < 4; i++) {
+        regfree(&(regex[i]));
+    }
+    run_scan(orcscan_impl(), pages, count, 0);
+    run_resolve("uriparser", pages, count, 0);
+    run_resolve("resolve", pages, count, 1);
+
+    run("per page", pages, count, &input, 0);
+    if (0 == orcmatcher_init(&matcher, &input)) {
+        return;
+    }
+    run("matcher", pages, count, &input, &matcher);
+    orcmatcher_free(&matcher);
+}
@@ -0,0 +1,147 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "benchpolyorcrules.h"
+#include "polyorcrules.h"
+#include "polyorcbase.h"
+#include "polyorcscan.h"
+#include "polyorcutils.h"
+#include "polyorcdefs.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <regex.h>
+
+/* Every way of checking urls runs at least this many seconds */
+#define BENCH_SECONDS 1.0
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The absolute urls of all links on the pages */
+static char ** collect_urls(bench_page *pages, int count, int *urls_len) {
+    int i;
+    int len = 0;
+    char **urls = 0;
+    char url[MAX_URL_LEN + 1];
+    for (i = 0; i < count; i++) {
+        orcscanner scan;
+        orclink link;
+        orcbase base;
+        orcbase_init(&base, pages[i].url);
+        orcscan_init(&scan, pages[i].html, pages[i].len);
+        while (orcscan_next(&scan, &link)) {
+            if (0 == orcbase_resolve(&base, link.start, link.len, url,
+                                     sizeof(url))) {
+                continue;
+            }
+            char **tmp = realloc(urls, (len + 1) * sizeof(char *));
+            if (0 != tmp) {
+                urls = tmp;
+            }
+            if (0 == tmp || 0 == (urls[len] = strdup(url))) {
+                free_array_of_charptr_incl(&urls, len);
+                orcbase_free(&base);
+                return 0;
+            }
+            len++;
+        }
+        orcbase_free(&base);
+    }
+    (*urls_len) = len;
+    return urls;
+}
+
+/* How is_excluded checked an url before rules, one pattern at a time */
+static int excluded_by_loop(regex_t *regex, int excludes_len,
+                            int includes_len, const char *url) {
+    int k;
+    for (k = 0; k < excludes_len; k++) {
+        if (0 == regexec(&(regex[k]), url, 0, 0, 0)) {
+            return 1;
+        }
+    }
+    for (k = 0; k < includes_len; k++) {
+        if (0 == regexec(&(regex[excludes_len + k]), url, 0, 0, 0)) {
+            return 0;
+        }
+    }
+    return 0 < includes_len;
+}
+
+/* Check all urls until BENCH_SECONDS have passed and print the rate,
+   with the rules or with regex one pattern at a time */
+static void run(const char *name, char **urls, int urls_len,
+                orcrules *rules, regex_t *regex, int excludes_len,
+                int includes_len) {
+    int i;
+    unsigned long long checked = 0;
+    unsigned long long left = 0;
+    double start = now();
+    double elapsed = 0;
+    while (elapsed < BENCH_SECONDS) {
+        for (i = 0; i < urls_len; i++) {
+            left += (0 != rules) ? orcrules_excluded(rules, urls[i]) :
+                excluded_by_loop(regex, excludes_len, includes_len,
+                                 urls[i]);
+        }
+        checked += urls_len;
+        elapsed = now() - start;
+    }
+    printf("%-12s %8d rules %10llu urls %12.0f urls/s %9.1f%% left\n",
+           name, excludes_len + includes_len, checked, checked / elapsed,
+           100.0 * left / checked);
+}
+
+void bench_polyorcrules(bench_page *pages, int count, char **excludes,
+                        int excludes_len, char **includes, int includes_len) {
+    int i;
+    int urls_len = 0;
+    int len = excludes_len + includes_len;
+    orcrules rules;
+    if (0 == len) {
+        return;
+    }
+    char **urls = collect_urls(pages, count, &urls_len);
+    regex_t *regex = calloc(len, sizeof(regex_t));
+    if (0 == urls || 0 == regex ||
+        0 == orcrules_init(&rules, excludes, excludes_len, includes,
+                           includes_len)) {
+        free_array_of_charptr_incl(&urls, urls_len);
+        free(regex);
+        return;
+    }
+    for (i = 0; i < len; i++) {
+        regcomp(&(regex[i]), (i < excludes_len) ? excludes[i] :
+                includes[i - excludes_len], REG_EXTENDED);
+    }
+    run("regex loop", urls, urls_len, 0, regex, excludes_len,
+        includes_len);
+    run("rules", urls, urls_len, &rules, 0, excludes_len, includes_len);
+    for (i = 0; i < len; i++) {
+        regfree(&(regex[i]));
+    }
+    free(regex);
+    orcrules_free(&rules);
+    free_array_of_charptr_incl(&urls, urls_len);
+}
@@ -17,12 +17,32 @@
 
 #include "testpolyorcbintree.h"
 #include "testpolyorcmatcher.h"
+#include "testpolyorchistogram.h"
+#include "testpolyorcalias.h"
+#include "testpolyorcaccesslog.h"
+#include "testpolyorctemplate.h"
+#include "testpolyorcwire.h"
+#include "testpolyorcsegment.h"
+#include "testpolyorcurlstat.h"
+#include "testpolyorcscan.h"
+#include "testpolyorcbase.h"
+#include "testpolyorcrules.h"
 
 #include <stdlib.h>
 
 int main(int argc, char **argv) {
     test_polyorcbintree();
     test_polyorcmatcher();
+    test_polyorchistogram();
+    test_polyorcalias();
+    test_polyorcaccesslog();
+    test_polyorctemplate();
+    test_polyorcwire();
+    test_polyorcsegment();
+    test_polyorcurlstat();
+    test_polyorcscan();
+    test_polyorcbase();
+    test_polyorcrules();
 
     return EXIT_SUCCESS;
 }
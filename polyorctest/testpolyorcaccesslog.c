@@ -0,0 +1,83 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcaccesslog.h"
+#include "polyorcaccesslog.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static int parse(enum orc_logformat format, const char *line,
+                 orclogentry *entry) {
+    return orclog_parse(format, line, strlen(line), entry);
+}
+
+static int target_is(const orclogentry *entry, const char *target) {
+    return strlen(target) == entry->target_len &&
+           0 == strncmp(target, entry->target, entry->target_len);
+}
+
+void test_polyorcaccesslog() {
+    printf("test_polyorcaccesslog ");
+
+    orclogentry entry;
+
+    /* Common log format, the example of the apache documentation */
+    assert(1 == parse(orclog_clf, "127.0.0.1 - frank [10/Oct/2000:13:55:36 "
+                      "-0700] \"GET /apache_pb.gif HTTP/1.0\" 200 2326\n",
+                      &entry));
+    assert(971211336.0 == entry.time);
+    assert(0 == strcmp("GET", entry.method));
+    assert(target_is(&entry, "/apache_pb.gif"));
+
+    /* Combined log format, utc */
+    assert(1 == parse(orclog_clf, "10.0.0.1 - - [01/Jan/1970:00:01:00 +0000] "
+                      "\"POST /a?b=c HTTP/1.1\" 201 0 \"-\" \"agent\"",
+                      &entry));
+    assert(60.0 == entry.time);
+    assert(0 == strcmp("POST", entry.method));
+    assert(target_is(&entry, "/a?b=c"));
+
+    /* A positive offset is ahead of utc */
+    assert(1 == parse(orclog_clf, "h - - [29/Feb/2024:01:00:00 +0100] "
+                      "\"HEAD / HTTP/1.1\" 200 0", &entry));
+    assert(1709164800.0 == entry.time);
+
+    /* Not requests */
+    assert(0 == parse(orclog_clf, "", &entry));
+    assert(0 == parse(orclog_clf, "h - - [10/Foo/2000:13:55:36 -0700] "
+                      "\"GET / HTTP/1.0\" 200 1", &entry));
+    assert(0 == parse(orclog_clf, "h - - [10/Oct/2000:13:55:36 -0700] "
+                      "\"-\" 400 0", &entry));
+    assert(0 == parse(orclog_clf, "h - - [10/Oct/2000:13:55:36 -0700] "
+                      "\"get / HTTP/1.0\" 200 1", &entry));
+
+    /* Tab separated */
+    assert(1 == parse(orclog_tsv, "1700000000.25\tGET\thttp://a/b\r\n",
+                      &entry));
+    assert(1700000000.25 == entry.time);
+    assert(0 == strcmp("GET", entry.method));
+    assert(target_is(&entry, "http://a/b"));
+    assert(1 == parse(orclog_tsv, "5\tDELETE\t/x\textra", &entry));
+    assert(target_is(&entry, "/x"));
+    assert(0 == parse(orclog_tsv, "x\tGET\t/", &entry));
+    assert(0 == parse(orclog_tsv, "5\tGET\t", &entry));
+    assert(0 == parse(orclog_tsv, "5 GET /", &entry));
+
+    printf("[ ok ]\n");
+}
@@ -0,0 +1,79 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcalias.h"
+#include "polyorcalias.h"
+#include "polyorcrand.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define SAMPLES 1000000
+
+void test_polyorcalias() {
+    printf("test_polyorcalias ");
+
+    orcalias table;
+    orcrand rand;
+    orcrand other;
+    unsigned int counts[6];
+    unsigned int i;
+
+    /* The same seed gives the same sequence */
+    orcrand_seed(&rand, 42);
+    orcrand_seed(&other, 42);
+    for (i = 0; i < 100; i++) {
+        assert(orcrand_next(&rand) == orcrand_next(&other));
+    }
+
+    /* Invalid weights */
+    double none[] = { 0, 0 };
+    double negative[] = { 1, -1 };
+    assert(0 == orcalias_init(&table, none, 2));
+    assert(0 == orcalias_init(&table, negative, 2));
+    assert(0 == orcalias_init(&table, none, 0));
+
+    /* One weight */
+    double one[] = { 3 };
+    assert(1 == orcalias_init(&table, one, 1));
+    for (i = 0; i < 1000; i++) {
+        assert(0 == orcalias_sample(&table, &rand));
+    }
+    orcalias_free(&table);
+
+    /* Draws follow the weights, a zero weight is never drawn */
+    double weights[] = { 1, 2, 3, 4, 0, 10 };
+    assert(1 == orcalias_init(&table, weights, 6));
+    for (i = 0; i < 6; i++) {
+        counts[i] = 0;
+    }
+    for (i = 0; i < SAMPLES; i++) {
+        unsigned int index = orcalias_sample(&table, &rand);
+        assert(6 > index);
+        counts[index]++;
+    }
+    assert(0 == counts[4]);
+    for (i = 0; i < 6; i++) {
+        double expected = SAMPLES * weights[i] / 20.0;
+        assert(counts[i] >= expected * 0.98 && counts[i] <= expected * 1.02);
+    }
+    orcalias_free(&table);
+    assert(0 == table.entries);
+
+    printf("[ ok ]\n");
+}
@@ -0,0 +1,96 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcbase.h"
+#include "polyorcbase.h"
+#include "polyorcdefs.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Resolves link on page with the fast joins and with uriparser only,
+   both must give expected */
+static void resolve(const char *page, const char *link,
+                    const char *expected) {
+    orcbase base;
+    char out[MAX_URL_LEN + 1];
+    int fast;
+    for (fast = 1; fast >= 0; fast--) {
+        orcbase_init(&base, page);
+        base.fast = base.fast && fast;
+        int len = orcbase_resolve(&base, link, strlen(link), out, sizeof(out));
+        if (0 == expected) {
+            assert(0 == len);
+        } else {
+            assert(strlen(expected) == len);
+            assert(0 == strcmp(expected, out));
+        }
+        orcbase_free(&base);
+    }
+}
+
+void test_polyorcbase() {
+    const char *page = "http://www.example.com:8080/one/two/three.html?q=1#top";
+    orcbase base;
+
+    printf("test_polyorcbase ");
+    orcbase_init(&base, page);
+    assert(1 == base.fast);
+    assert(strlen("http://www.example.com:8080") == base.origin_len);
+    assert(strlen("http://www.example.com:8080/one/two/") == base.dir_len);
+    assert(strlen("http://www.example.com:8080/one/two/three.html?q=1") ==
+           base.doc_len);
+    orcbase_free(&base);
+
+    /* Already absolute */
+    resolve(page, "https://example.org/a?b#c", "https://example.org/a?b#c");
+    resolve(page, "mailto:me@example.com", "mailto:me@example.com");
+    /* Absolute path */
+    resolve(page, "/four", "http://www.example.com:8080/four");
+    resolve(page, "/", "http://www.example.com:8080/");
+    /* Same directory */
+    resolve(page, "four.html#x",
+            "http://www.example.com:8080/one/two/four.html#x");
+    resolve(page, "a/b?c", "http://www.example.com:8080/one/two/a/b?c");
+    /* Parent directories, but not above the root */
+    resolve(page, "../four", "http://www.example.com:8080/one/four");
+    resolve(page, "../", "http://www.example.com:8080/one/");
+    resolve(page, "../../../../four", "http://www.example.com:8080/four");
+    /* The page itself */
+    resolve(page, "#end",
+            "http://www.example.com:8080/one/two/three.html?q=1#end");
+    resolve(page, "", "http://www.example.com:8080/one/two/three.html?q=1");
+    /* Left to uriparser */
+    resolve(page, "./four", "http://www.example.com:8080/one/two/four");
+    resolve(page, "a/../b", "http://www.example.com:8080/one/two/b");
+    resolve(page, "?r=2", "http://www.example.com:8080/one/two/three.html?r=2");
+    resolve(page, "//example.org/x", "http://example.org/x");
+
+    /* A page without a path */
+    resolve("http://example.com", "four", "http://example.com/four");
+    resolve("http://example.com", "../four", "http://example.com/four");
+    resolve("http://example.com", "#x", "http://example.com#x");
+
+    /* An url that does not fit is not resolved */
+    char long_link[MAX_URL_LEN + 1];
+    memset(long_link, 'a', MAX_URL_LEN);
+    long_link[MAX_URL_LEN] = '\0';
+    resolve(page, long_link, 0);
+
+    printf("[ ok ]\n");
+}
@@ -0,0 +1,89 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorchistogram.h"
+#include "polyorchistogram.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+void test_polyorchistogram() {
+    printf("test_polyorchistogram ");
+
+    orchistogram *hist = calloc(1, sizeof(orchistogram));
+    orchistogram *other = calloc(1, sizeof(orchistogram));
+    assert(0 != hist && 0 != other);
+
+    /* Buckets are contiguous and every value falls inside its bucket */
+    unsigned long long value;
+    int last = -1;
+    for (value = 0; value < 1000000; value++) {
+        int index = orchist_index(value);
+        assert(index == last || index == last + 1);
+        assert(orchist_bucket_low(index) <= value);
+        assert(orchist_bucket_high(index) >= value);
+        last = index;
+    }
+    assert(ORC_HIST_BUCKETS - 1 == orchist_index(~0ULL));
+    assert(ORC_HIST_BUCKETS - 1 ==
+           orchist_index((1ULL << ORC_HIST_MAX_BITS) - 1));
+
+    /* Empty */
+    orchist_reset(hist);
+    assert(0 == orchist_percentile(hist, 99.0));
+    assert(0 == orchist_mean(hist));
+
+    /* 1..1000, the error is bounded by the bucket width */
+    for (value = 1; value <= 1000; value++) {
+        orchist_record(hist, value);
+    }
+    assert(1000 == hist->count);
+    assert(1 == hist->min);
+    assert(1000 == hist->max);
+    assert(500.5 == orchist_mean(hist));
+    unsigned long long p50 = orchist_percentile(hist, 50.0);
+    assert(p50 >= 500 && p50 <= 500 + 500 / ORC_HIST_SUB_COUNT);
+    unsigned long long p99 = orchist_percentile(hist, 99.0);
+    assert(p99 >= 990 && p99 <= 990 + 990 / ORC_HIST_SUB_COUNT);
+    assert(1000 == orchist_percentile(hist, 100.0));
+    assert(1 == orchist_percentile(hist, 0.0));
+
+    /* Merging two halves gives the same as recording everything */
+    orchist_reset(other);
+    for (value = 1001; value <= 2000; value++) {
+        orchist_record(other, value);
+    }
+    orchist_merge(hist, other);
+    assert(2000 == hist->count);
+    assert(1 == hist->min);
+    assert(2000 == hist->max);
+    orchist_reset(other);
+    for (value = 1; value <= 2000; value++) {
+        orchist_record(other, value);
+    }
+    int i;
+    for (i = 0; i < ORC_HIST_BUCKETS; i++) {
+        assert(hist->buckets[i] == other->buckets[i]);
+    }
+    assert(orchist_percentile(hist, 99.9) == orchist_percentile(other, 99.9));
+
+    free(hist);
+    free(other);
+
+    printf("[ ok ]\n");
+}
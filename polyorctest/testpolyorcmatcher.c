@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <assert.h>
 
 void test_polyorcmatcher() {
 
@@ -96,13 +97,54 @@ void test_polyorcmatcher() {
     strncpy(input.search_name, "example.com\0", SEARCH_NAME_LEN);
     strncpy(input.url, "http://www.example.com/brex/index.html\0", MAX_URL_LEN);
 
+    /* Blanks in quotes are not part of the url, letters that [:space:]
+       once matched are */
+    const char *expected[] = {
+        "http://www.example.com/blog/index.html",
+        "http://www.example.com/ego/index.html",
+        "http://www.example.com/brex/bog/index.html",
+        "http://www.example.com/big/index.html",
+        "http://www.example.com",
+        "http://www.example.com/brex/www.example.com",
+        "http://www.example.com/brex/example.com",
+        "http://www.example.com:80/",
+        "http://www.example.com:8080",
+        "http://www.example.com/brex/127.0.0.1",
+        "http://www.example.com/brex/localhost",
+        "http://www.example.com/brex/validator.w3.org",
+        "http://www.example.com/download/pyguest.py"
+    };
     int matches = find_urls(html, &input);
 
     int i;
+    assert(13 == matches);
     for (i = 0; i < matches; i++) {
-        printf("%s\n", input.ret[i]);
+        assert(0 == strcmp(expected[i], input.ret[i]));
     }
 
+    /* A matcher compiled once finds the same urls on every page */
+    orcmatcher matcher;
+    char *excludes[] = { "brex/", "\\.py$" };
+    input.excludes = excludes;
+    input.excludes_len = 2;
+    assert(1 == orcmatcher_init(&matcher, &input));
+    for (i = 0; i < 2; i++) {
+        free_array_of_charptr_incl(&(input.ret), input.ret_len);
+        input.ret_len = 0;
+        assert(6 == orcmatcher_find_urls(&matcher, html, &input));
+        assert(0 == strcmp("http://www.example.com/blog/index.html",
+                           input.ret[0]));
+        assert(0 == strcmp("http://www.example.com:8080", input.ret[5]));
+    }
+    orcmatcher_free(&matcher);
+
+    /* A bad exclude pattern is found before any page */
+    char *bad[] = { "(" };
+    input.excludes = bad;
+    input.excludes_len = 1;
+    assert(0 == orcmatcher_init(&matcher, &input));
+    assert(-1 == find_urls(html, &input));
+
     free_array_of_charptr_incl(&(input.ret), input.ret_len);
     free(input.search_name);
     free(input.url);
@@ -16,6 +16,7 @@
 */
 
 #ifndef TESTPOLYORCMATCHER_H
+#define TESTPOLYORCMATCHER_H
 
 void test_polyorcmatcher();
 
@@ -0,0 +1,137 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcrules.h"
+#include "polyorcrules.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <regex.h>
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof(*(a)))
+
+static const char *urls[] = {
+    "http://www.example.com/",
+    "http://www.example.com/blog/index.html",
+    "http://www.example.com/std/vec/struct.Vec.html#method.push",
+    "http://www.example.com/core/index.html",
+    "http://www.example.com/docs/colour.pdf",
+    "http://www.example.com/docs/color.pdf?page=2",
+    "http://www.example.com/ac/xyz",
+    "http://www.example.com/abc/2024/01/",
+    "http://www.example.com/download/pyguest.py"
+};
+
+/* What the rules must decide, the patterns run one at a time */
+static int excluded(char **excludes, int excludes_len, char **includes,
+                    int includes_len, const char *url) {
+    int k;
+    int included = (0 == includes_len);
+    regex_t regex;
+    for (k = 0; k < excludes_len + includes_len; k++) {
+        const char *pattern = (k < excludes_len) ?
+            excludes[k] : includes[k - excludes_len];
+        assert(0 == regcomp(&regex, pattern, REG_EXTENDED));
+        int match = (0 == regexec(&regex, url, 0, 0, 0));
+        regfree(&regex);
+        if (match && k < excludes_len) {
+            return 1;
+        } else if (match) {
+            included = 1;
+        }
+    }
+    return !included;
+}
+
+/* Checks every url against the rules and the patterns one at a time */
+static void check(char **excludes, int excludes_len, char **includes,
+                  int includes_len) {
+    orcrules rules;
+    size_t i;
+    assert(1 == orcrules_init(&rules, excludes, excludes_len, includes,
+                              includes_len));
+    /* Twice, patterns are only run once per url */
+    for (i = 0; i < 2 * ARRAY_LEN(urls); i++) {
+        const char *url = urls[i % ARRAY_LEN(urls)];
+        assert(excluded(excludes, excludes_len, includes, includes_len,
+                        url) == orcrules_excluded(&rules, url));
+    }
+    orcrules_free(&rules);
+}
+
+void test_polyorcrules() {
+    orcrules rules;
+    size_t i;
+    printf("test_polyorcrules ");
+
+    /* No rules keep every url */
+    assert(1 == orcrules_init(&rules, 0, 0, 0, 0));
+    assert(0 == orcrules_excluded(&rules, urls[1]));
+    orcrules_free(&rules);
+
+    /* Literals, groups, optional parts, intervals, escapes, brackets and
+       patterns without any literal */
+    char *excludes[] = {
+        "/blog/",
+        "/(std|core)/",
+        "colou?r\\.pdf$",
+        "/ab{0}c/",
+        "\\.py$",
+        "[]x]yz",
+        "/[[:digit:]]{4}/",
+        "^http://[^/]+/$",
+        "[[:upper:]]{2}"
+    };
+    assert(1 == orcrules_init(&rules, excludes, ARRAY_LEN(excludes), 0, 0));
+    assert(1 == rules.always_len);
+    assert(1 == orcrules_excluded(&rules, urls[1]));
+    assert(1 == orcrules_excluded(&rules, urls[2]));
+    assert(1 == orcrules_excluded(&rules, urls[4]));
+    assert(0 == orcrules_excluded(&rules, urls[5]));
+    assert(1 == orcrules_excluded(&rules, urls[6]));
+    orcrules_free(&rules);
+    check(excludes, ARRAY_LEN(excludes), 0, 0);
+
+    /* Repetitions after + can repeat the atom zero times */
+    char *stacked[] = {
+        "/ab+?c",
+        "/ab+*c",
+        "/(ab)+?c",
+        "x(ab)+{0,1}y"
+    };
+    for (i = 0; i < ARRAY_LEN(stacked); i++) {
+        check(stacked + i, 1, 0, 0);
+    }
+    assert(1 == orcrules_init(&rules, stacked, 1, 0, 0));
+    assert(1 == orcrules_excluded(&rules, urls[6]));
+    orcrules_free(&rules);
+
+    /* With includes an url must match one of them */
+    char *includes[] = { "/docs/", "\\.html" };
+    check(0, 0, includes, ARRAY_LEN(includes));
+    check(excludes, 2, includes, ARRAY_LEN(includes));
+    check(excludes + 2, ARRAY_LEN(excludes) - 2, includes, 1);
+
+    /* A bad pattern is found when compiling */
+    char *bad[] = { "/blog/", "(" };
+    assert(0 == orcrules_init(&rules, bad, 2, 0, 0));
+    assert(0 == orcrules_init(&rules, 0, 0, bad, 2));
+
+    printf("[ ok ]\n");
+}
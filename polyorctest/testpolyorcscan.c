@@ -0,0 +1,187 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcscan.h"
+#include "polyorcscan.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <regex.h>
+
+#define MAX_SPANS 64
+
+/* What the scanner replaces, one regular expression per attribute and
+   quote */
+static const char *patterns[] = {
+    "href[[:space:]]*=[[:space:]]*\"[[:space:]]*([^\"]*)\"",
+    "href[[:space:]]*=[[:space:]]*'[[:space:]]*([^']*)'",
+    "src[[:space:]]*=[[:space:]]*\"[[:space:]]*([^\"]*)\"",
+    "src[[:space:]]*=[[:space:]]*'[[:space:]]*([^']*)'"
+};
+
+static int by_offset(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* The start and length of every link the expressions find, by start */
+static int regex_spans(const char *html, int *spans) {
+    int i;
+    int count = 0;
+    for (i = 0; i < 4; i++) {
+        regex_t regex;
+        regmatch_t pmatch[2];
+        const char *current = html;
+        assert(0 == regcomp(&regex, patterns[i], REG_ICASE | REG_EXTENDED));
+        while (0 == regexec(&regex, current, 2, pmatch, 0)) {
+            assert(MAX_SPANS > count);
+            spans[count * 2] = (current - html) + pmatch[1].rm_so;
+            spans[count * 2 + 1] = pmatch[1].rm_eo - pmatch[1].rm_so;
+            count++;
+            current += pmatch[1].rm_eo;
+        }
+        regfree(&regex);
+    }
+    qsort(spans, count, 2 * sizeof(int), by_offset);
+    return count;
+}
+
+/* The same from the scanner, which finds them in order */
+static int scan_spans(const char *html, int *spans) {
+    int count = 0;
+    orcscanner scan;
+    orclink link;
+    orcscan_init(&scan, html, strlen(html));
+    while (orcscan_next(&scan, &link)) {
+        assert(MAX_SPANS > count);
+        spans[count * 2] = link.start - html;
+        spans[count * 2 + 1] = link.len;
+        count++;
+    }
+    return count;
+}
+
+/* The links of a stream fed the page in chunks of step bytes, the first
+   chunk is first bytes long, all put after each other in out */
+static int stream_links(const char *html, size_t first, size_t step,
+                        char *out) {
+    int count = 0;
+    size_t len = strlen(html);
+    size_t pos = 0;
+    size_t chunk = first;
+    orcstream stream;
+    orclink link;
+    orcstream_init(&stream);
+    out[0] = '\0';
+    while (pos < len) {
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        orcstream_feed(&stream, html + pos, chunk);
+        while (orcstream_next(&stream, &link)) {
+            strncat(out, link.start, link.len);
+            strcat(out, "|");
+            count++;
+        }
+        pos += chunk;
+        chunk = step;
+    }
+    return count;
+}
+
+/* The same from the scanner */
+static int scan_links(const char *html, char *out) {
+    int count = 0;
+    orcscanner scan;
+    orclink link;
+    orcscan_init(&scan, html, strlen(html));
+    out[0] = '\0';
+    while (orcscan_next(&scan, &link)) {
+        strncat(out, link.start, link.len);
+        strcat(out, "|");
+        count++;
+    }
+    return count;
+}
+
+void test_polyorcscan() {
+    printf("test_polyorcscan (%s) ", orcscan_impl());
+
+    const char *page =
+        "<a href=\"/a.html\">a</a><A HREF='/b.html'>b</A>\n"
+        "<img src = \"c.png\"><img\tSrc=\n'  d.png'>\n"
+        "<script data-src=\"/e.js\"></script><a href=\"\">empty</a>\n"
+        "<p>x = \"no link\" and href=no quotes, a=b=c</p>\n"
+        "<a href =  \"scripts/f.html\">f</a><a href='g\"h'>g</a>\n"
+        "<a href=\"unclosed>";
+    int expected[MAX_SPANS * 2];
+    int found[MAX_SPANS * 2];
+    char html[512];
+    int pad;
+
+    /* Every link at every offset from the blocks of the byte search */
+    for (pad = 0; pad < 80; pad++) {
+        memset(html, ' ', pad);
+        strcpy(html + pad, page);
+        int count = regex_spans(html, expected);
+        assert(8 == count);
+        assert(count == scan_spans(html, found));
+        assert(0 == memcmp(expected, found, count * 2 * sizeof(int)));
+    }
+    assert(0 == strncmp("scripts/f.html", html + found[12], found[13]));
+
+    /* Nothing to find, or cut off */
+    assert(0 == scan_spans("", found));
+    assert(0 == scan_spans("href", found));
+    assert(0 == scan_spans("=\"a\"", found));
+    assert(0 == scan_spans("href=", found));
+    assert(0 == scan_spans("src=\"", found));
+    assert(1 == scan_spans("src=\"\"", found) && 0 == found[1]);
+
+    /* A stream finds the same links wherever the chunks are split */
+    char whole[512];
+    char split[512];
+    size_t at;
+    int count = scan_links(page, whole);
+    assert(8 == count);
+    for (at = 0; at <= strlen(page); at++) {
+        assert(count == stream_links(page, at, 512, split));
+        assert(0 == strcmp(whole, split));
+    }
+    assert(count == stream_links(page, 1, 1, split));
+    assert(0 == strcmp(whole, split));
+    assert(count == stream_links(page, 5, 3, split));
+    assert(0 == strcmp(whole, split));
+    assert(0 == stream_links("", 1, 1, split));
+    assert(1 == stream_links(" SRC\n", 2, 512, split) + stream_links(
+        "src\n =\n'a'", 1, 2, split));
+
+    /* A value too long to keep is skipped, the links after it are not */
+    char *longer = malloc(MAX_URL_LEN + 64);
+    strcpy(longer, "<a href=\"");
+    memset(longer + 9, 'x', MAX_URL_LEN + 1);
+    strcpy(longer + 9 + MAX_URL_LEN + 1, "\"><img src='i.png'>");
+    assert(1 == stream_links(longer, 100, 100, split));
+    assert(0 == strcmp("i.png|", split));
+    assert(1 == stream_links(longer, 10000, 1, split));
+    assert(1 == stream_links(longer, 1, 1, split));
+    free(longer);
+
+    printf("[ ok ]\n");
+}
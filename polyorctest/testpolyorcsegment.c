@@ -0,0 +1,104 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcsegment.h"
+#include "polyorcsegment.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+void test_polyorcsegment() {
+    printf("test_polyorcsegment ");
+
+    orcsegment seg;
+    orcsegment reader;
+    orcstatistics *stat = calloc(1, sizeof(orcstatistics));
+    orcstatistics *copy = calloc(1, sizeof(orcstatistics));
+    assert(0 != stat && 0 != copy);
+
+    /* Every slot starts on its own cache lines */
+    assert(0 == sizeof(orcsegment_header) % ORC_CACHE_LINE);
+    assert(0 == sizeof(orcslot) % ORC_CACHE_LINE);
+
+    /* Anonymous memory, a published slot reads back the same */
+    assert(1 == orcseg_create(&seg, 0, 3, 0, 0));
+    assert(ORC_SEGMENT_MAGIC == seg.header->magic);
+    assert(3 == seg.header->threads);
+    assert(0 == ((size_t)&(seg.slots[1].stat)) % ORC_CACHE_LINE);
+    assert(1 == orcseg_read(&(seg.slots[2]), copy));
+    assert(0 == memcmp(stat, copy, sizeof(orcstatistics)));
+    stat->thread_no = 2;
+    stat->hits = 5000000000ULL;
+    stat->total_bytes = 1ULL << 40;
+    orchist_record(&(stat->latency[orcl_total]), 1500);
+    orcseg_publish(&(seg.slots[1]), stat);
+    assert(2 == seg.slots[1].sequence);
+    assert(1 == orcseg_read(&(seg.slots[1]), copy));
+    assert(0 == memcmp(stat, copy, sizeof(orcstatistics)));
+
+    /* A slot that stays in the middle of a write is not read */
+    seg.slots[1].sequence++;
+    assert(0 == orcseg_read(&(seg.slots[1]), copy));
+    orcseg_close(&seg);
+    assert(0 == seg.header);
+
+    /* A file is mapped by readers */
+    char path[] = "/tmp/testpolyorcsegmentXXXXXX";
+    int fd = mkstemp(path);
+    assert(-1 != fd);
+    close(fd);
+    assert(1 == orcseg_create(&seg, path, 2, 3, 12));
+    orcseg_publish(&(seg.slots[0]), stat);
+    assert(0 == ((size_t)orcseg_urls(&seg, 1)) % ORC_CACHE_LINE);
+    orcurl_record(&(orcseg_urls(&seg, 1)[2]), 1000, 10, 1);
+    assert(1 == orcseg_name_url(&seg, 0, "/a"));
+    assert(1 == orcseg_name_url(&seg, 1, "/bb"));
+    assert(1 == orcseg_name_url(&seg, 2, "/ccc"));
+    assert(0 == orcseg_name_url(&seg, 2, "/d"));
+    assert(1 == orcseg_open(&reader, path));
+    assert(2 == reader.header->threads);
+    assert(1 == orcseg_read(&(reader.slots[0]), copy));
+    assert(0 == memcmp(stat, copy, sizeof(orcstatistics)));
+    assert(0 == orcseg_urls(&reader, 0)[2].count);
+    assert(1 == orcseg_urls(&reader, 1)[2].errors);
+    assert(0 == strcmp("/bb", orcseg_url_name(&reader, 1)));
+    assert(0 == strcmp("/ccc", orcseg_url_name(&reader, 2)));
+    assert(0 == strcmp("", orcseg_url_name(&reader, 3)));
+    orcseg_close(&reader);
+
+    /* Not a segment or from another version */
+    seg.header->version = ORC_SEGMENT_VERSION + 1;
+    assert(0 == orcseg_open(&reader, path));
+    seg.header->version = ORC_SEGMENT_VERSION;
+    seg.header->magic = 0;
+    assert(0 == orcseg_open(&reader, path));
+    orcseg_close(&seg);
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert(-1 != fd);
+    close(fd);
+    assert(0 == orcseg_open(&reader, path));
+    unlink(path);
+    assert(0 == orcseg_open(&reader, path));
+
+    free(stat);
+    free(copy);
+    printf("[ ok ]\n");
+}
@@ -0,0 +1,109 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorctemplate.h"
+#include "polyorctemplate.h"
+#include "polyorcdefs.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static int parse(orctemplate *tpl, const char *text) {
+    return orctpl_parse(tpl, text, strlen(text));
+}
+
+void test_polyorctemplate() {
+    printf("test_polyorctemplate ");
+
+    orctemplate tpl;
+    orctpl_values values;
+    char out[256];
+
+    memset(&values, 0, sizeof(values));
+    values.random = 0xfedcba9876543210ULL;
+    values.counter = 42;
+    values.thread = 3;
+    values.timestamp = 1700000000123ULL;
+    values.columns[0] = "alice,";
+    values.column_lens[0] = 5;
+    values.columns[1] = "7";
+    values.column_lens[1] = 1;
+    values.column_count = 2;
+    values.url = "http://a/b";
+    values.url_len = 10;
+
+    /* No placeholders */
+    assert(1 == parse(&tpl, "plain {text} {{ not closed"));
+    assert(1 == orctpl_is_static(&tpl));
+    assert(26 == orctpl_expand(&tpl, &values, out, sizeof(out)));
+    assert(0 == strcmp("plain {text} {{ not closed", out));
+    orctpl_free(&tpl);
+
+    /* Every placeholder */
+    assert(1 == parse(&tpl, "{\"id\":\"{{random}}\",\"n\":{{counter}},"
+                      "\"t\":{{thread}},\"at\":{{timestamp}},"
+                      "\"user\":\"{{csv:1}}\",\"age\":{{csv:2}},"
+                      "\"missing\":\"{{csv:3}}\",\"from\":\"{{url}}\"}"));
+    assert(0 == orctpl_is_static(&tpl));
+    long len = orctpl_expand(&tpl, &values, out, sizeof(out));
+    const char *expected = "{\"id\":\"0123456789abcdef\",\"n\":42,\"t\":3,"
+                           "\"at\":1700000000123,\"user\":\"alice\","
+                           "\"age\":7,\"missing\":\"\","
+                           "\"from\":\"http://a/b\"}";
+    assert((long)strlen(expected) == len);
+    assert(0 == strcmp(expected, out));
+    assert(orctpl_bound(&tpl, 5, 10) >= (size_t)len);
+
+    /* Too small buffers fail, the exact size works */
+    assert(-1 == orctpl_expand(&tpl, &values, out, len));
+    assert(len == orctpl_expand(&tpl, &values, out, len + 1));
+    orctpl_free(&tpl);
+
+    /* Zero is written */
+    values.counter = 0;
+    assert(1 == parse(&tpl, "{{counter}}"));
+    assert(1 == orctpl_expand(&tpl, &values, out, sizeof(out)));
+    assert(0 == strcmp("0", out));
+    orctpl_free(&tpl);
+
+    /* A url at the limit does not fit in a url template that adds to it */
+    char long_url[MAX_URL_LEN + 1];
+    char url_out[MAX_URL_LEN + 1];
+    memset(long_url, 'a', MAX_URL_LEN);
+    long_url[MAX_URL_LEN] = '\0';
+    values.url = long_url;
+    values.url_len = MAX_URL_LEN;
+    assert(1 == parse(&tpl, "{{url}}"));
+    assert(MAX_URL_LEN >= orctpl_bound(&tpl, 5, MAX_URL_LEN));
+    assert(MAX_URL_LEN == orctpl_expand(&tpl, &values, url_out,
+                                        sizeof(url_out)));
+    assert(0 == strcmp(long_url, url_out));
+    orctpl_free(&tpl);
+    assert(1 == parse(&tpl, "{{url}}?n={{counter}}"));
+    assert(MAX_URL_LEN < orctpl_bound(&tpl, 5, MAX_URL_LEN));
+    assert(-1 == orctpl_expand(&tpl, &values, url_out, sizeof(url_out)));
+    orctpl_free(&tpl);
+
+    /* Unknown placeholders */
+    assert(0 == parse(&tpl, "{{nope}}"));
+    assert(0 == parse(&tpl, "{{csv:0}}"));
+    assert(0 == parse(&tpl, "{{csv:x}}"));
+    assert(0 == parse(&tpl, "{{csv:99}}"));
+
+    printf("[ ok ]\n");
+}
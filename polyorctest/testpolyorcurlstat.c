@@ -0,0 +1,77 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcurlstat.h"
+#include "polyorcurlstat.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+void test_polyorcurlstat() {
+    printf("test_polyorcurlstat ");
+
+    orcurlstat urls[6];
+    orcurlstat sum[6];
+    unsigned int top[6];
+    int i;
+    memset(urls, 0, sizeof(urls));
+    memset(sum, 0, sizeof(sum));
+    assert(512 == sizeof(orcurlstat));
+
+    /* A percentile is within a quarter of the recorded value */
+    assert(0 == orcurl_percentile(&(urls[0]), 99.0));
+    orcurl_record(&(urls[0]), 3, 100, 0);
+    assert(3 == orcurl_percentile(&(urls[0]), 50.0));
+    for (i = 0; i < 99; i++) {
+        orcurl_record(&(urls[1]), 1000, 10, 0);
+    }
+    orcurl_record(&(urls[1]), 80000, 10, 1);
+    assert(1000 <= orcurl_percentile(&(urls[1]), 50.0));
+    assert(1250 > orcurl_percentile(&(urls[1]), 50.0));
+    assert(1000 <= orcurl_percentile(&(urls[1]), 99.0));
+    assert(1250 > orcurl_percentile(&(urls[1]), 99.0));
+    assert(80000 <= orcurl_percentile(&(urls[1]), 100.0));
+    assert(100000 > orcurl_percentile(&(urls[1]), 100.0));
+    assert(100 * 10 == urls[1].bytes && 1 == urls[1].errors);
+    orcurl_record(&(urls[2]), 1ULL << 40, 0, 1);
+    assert(orcurl_percentile(&(urls[2]), 50.0) >= (1ULL << 31));
+
+    /* Merging adds every url to the same url */
+    orcurl_merge(sum, urls, 6);
+    orcurl_merge(sum, urls, 6);
+    assert(200 == sum[1].count && 2 == sum[1].errors);
+    assert(orcurl_percentile(&(urls[1]), 99.0) ==
+           orcurl_percentile(&(sum[1]), 99.0));
+
+    /* Slowest first, urls without hits are left out */
+    orcurl_record(&(urls[4]), 20000, 0, 0);
+    orcurl_record(&(urls[5]), 20000, 0, 1);
+    orcurl_record(&(urls[5]), 20000, 0, 0);
+    assert(3 == orcurl_top(urls, 6, orcu_p99, top, 3));
+    assert(2 == top[0] && 5 == top[1] && 4 == top[2]);
+    assert(5 == orcurl_top(urls, 6, orcu_p99, top, 6));
+    assert(1 == top[3] && 0 == top[4]);
+
+    /* Failing most first, urls without errors are left out */
+    assert(3 == orcurl_top(urls, 6, orcu_errors, top, 3));
+    assert(2 == top[0] && 5 == top[1] && 1 == top[2]);
+    assert(1 == orcurl_top(urls, 6, orcu_errors, top, 1) && 2 == top[0]);
+
+    printf("[ ok ]\n");
+}
@@ -0,0 +1,146 @@
+/*
+ Originally created by Oscar Norlander (codeape)
+ ...................................................................
+ @@@@@@@    @@@@@@   @@@       @@@ @@@   @@@@@@   @@@@@@@    @@@@@@@
+ @@@@@@@@  @@@@@@@@  @@@       @@@ @@@  @@@@@@@@  @@@@@@@@  @@@@@@@@
+ @@!  @@@  @@!  @@@  @@!       @@! !@@  @@!  @@@  @@!  @@@  !@@
+ !@!  @!@  !@!  @!@  !@!       !@! @!!  !@!  @!@  !@!  @!@  !@!
+ @!@@!@!   @!@  !@!  @!!        !@!@!   @!@  !@!  @!@!!@!   !@!
+ !!@!!!    !@!  !!!  !!!         @!!!   !@!  !!!  !!@!@!    !!!
+ !!:       !!:  !!!  !!:         !!:    !!:  !!!  !!: :!!   :!!
+ :!:       :!:  !:!   :!:        :!:    :!:  !:!  :!:  !:!  :!:
+  ::       ::::: ::   :: ::::     ::    ::::: ::  ::   :::   ::: :::
+  :         : :  :   : :: : :     :      : :  :    :   : :   :: :: :
+ ...................................................................
+ Polyorc is under BSD 2-Clause License (see LICENSE file)
+*/
+
+#include "testpolyorcwire.h"
+#include "polyorcwire.h"
+#include "polyorcstats.h"
+#include "polyorcrand.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Statistics with something in every kind of field */
+static void fill(orcstatistics *stat, unsigned long long seed) {
+    orcrand rand;
+    int i;
+    int j;
+    orcrand_seed(&rand, seed);
+    memset(stat, 0, sizeof(orcstatistics));
+    stat->thread_no = 3;
+    stat->started = 1500000000000000ULL;
+    stat->published = stat->started + 1234;
+    stat->total_bytes = orcrand_next(&rand);
+    stat->hits = 100000;
+    stat->missed = 5;
+    stat->connects = 42;
+    stat->multiplexed = 9;
+    stat->aborted = 1;
+    stat->failed = 6;
+    stat->status[orcc_none] = 2;
+    stat->status[orcc_2xx] = 99990;
+    stat->status[orcc_5xx] = 4;
+    orcstat_count_code(stat, 200, 99980);
+    orcstat_count_code(stat, 204, 10);
+    orcstat_count_code(stat, 503, 4);
+    stat->failures[orcf_timeout] = 2;
+    orchist_record(&(stat->ok_latency), 900);
+    orchist_record(&(stat->failed_latency), 30000000);
+    stat->sessions = 17;
+    stat->step = 2;
+    stat->target = 1.0 / 3.0;
+    for (i = 0; i < orcl_count; i++) {
+        for (j = 0; j < 1000; j++) {
+            orchist_record(&(stat->latency[i]),
+                           orcrand_next(&rand) >> (20 + i * 4));
+        }
+    }
+    stat->steps[0].seconds = 10.25;
+    stat->steps[0].hits = 300;
+    stat->steps[1].seconds = 0.1;
+    stat->steps[1].missed = 4;
+    orchist_record(&(stat->steps[1].latency), 1500);
+    stat->flow_count = 2;
+    strcpy(stat->flow[0].name, "login");
+    stat->flow[0].hits = 8;
+    orchist_record(&(stat->flow[0].latency), 2500);
+    /* A name that fills the field is not terminated */
+    memcpy(stat->flow[1].name, "0123456789abcdef", ORC_FLOW_NAME_LEN);
+    stat->flow[1].total_bytes = 99;
+}
+
+void test_polyorcwire() {
+    printf("test_polyorcwire ");
+
+    orcstatistics *stat = calloc(1, sizeof(orcstatistics));
+    orcstatistics *copy = calloc(1, sizeof(orcstatistics));
+    orcstatistics *sum = calloc(1, sizeof(orcstatistics));
+    orcstatistics *wire_sum = calloc(1, sizeof(orcstatistics));
+    assert(0 != stat && 0 != copy && 0 != sum && 0 != wire_sum);
+    size_t len;
+
+    /* Empty statistics */
+    char *text = orcwire_encode(stat, &len);
+    assert(0 != text && strlen(text) == len);
+    assert(1 == orcwire_decode(copy, text, len));
+    assert(0 == memcmp(stat, copy, sizeof(orcstatistics)));
+    free(text);
+
+    /* A round trip gives back every field */
+    fill(stat, 1);
+    text = orcwire_encode(stat, &len);
+    assert(0 != text);
+    assert(1 == orcwire_decode(copy, text, len));
+    assert(0 == memcmp(stat, copy, sizeof(orcstatistics)));
+
+    /* Cut short, damaged or from another version */
+    assert(0 == orcwire_decode(copy, text, len / 2));
+    assert(0 == orcwire_decode(copy, text, len - 4));
+    text[len / 2] = '#';
+    assert(0 == orcwire_decode(copy, text, len));
+    free(text);
+    assert(0 == orcwire_decode(copy, "orcstat 2\nend\n", 14));
+    assert(0 == orcwire_decode(copy, "end\n", 4));
+    assert(0 == orcwire_decode(copy, "orcstat 3\nhist lat 9 1 1 1 1\nend\n",
+                               33));
+    assert(1 == orcwire_decode(copy, "orcstat 3\nend\n", 14));
+
+    /* Merging decoded statistics is the same as merging the originals */
+    int i;
+    for (i = 0; i < 4; i++) {
+        fill(stat, 10 + i);
+        orcstat_merge(sum, stat);
+        text = orcwire_encode(stat, &len);
+        assert(1 == orcwire_decode(copy, text, len));
+        orcstat_merge(wire_sum, copy);
+        free(text);
+    }
+    assert(0 == memcmp(sum, wire_sum, sizeof(orcstatistics)));
+    assert(4 * 99980 == sum->codes[0].count && 503 == sum->codes[2].code);
+
+    /* The most common codes first, codes beyond the table are left out */
+    orccode top[3];
+    memset(stat, 0, sizeof(orcstatistics));
+    for (i = 0; i < ORC_MAX_CODES + 4; i++) {
+        orcstat_count_code(stat, 400 + i, 1 + i % 5);
+    }
+    assert(400 + ORC_MAX_CODES - 1 == stat->codes[ORC_MAX_CODES - 1].code);
+    assert(3 == orcstat_top_codes(stat, top, 3));
+    assert(5 == top[0].count && 404 == top[0].code);
+    assert(5 == top[1].count && 409 == top[1].code);
+    assert(5 == top[2].count && 414 == top[2].code);
+    orcstat_count_code(stat, 409, 1);
+    assert(3 == orcstat_top_codes(stat, top, 3));
+    assert(409 == top[0].code && 404 == top[1].code);
+
+    free(stat);
+    free(copy);
+    free(sum);
+    free(wire_sum);
+    printf("[ ok ]\n");
+}